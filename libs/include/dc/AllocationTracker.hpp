@@ -0,0 +1,284 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <new>
+#include <ostream>
+
+// scopes are compiled in with DC_TRACK_ALLOCATIONS=1, they cost a thread local store each
+#ifndef DC_TRACK_ALLOCATIONS
+#define DC_TRACK_ALLOCATIONS 0
+#endif
+
+namespace dc
+{
+    // the subsystem an allocation is charged to, the innermost scope of the allocating thread
+    enum class AllocationTag
+    {
+        Other,
+        Loader,
+        MeshExport,
+        Shader,
+        Frame,
+        Count
+    };
+
+    inline const char* allocationTagName(AllocationTag tag)
+    {
+        const char* names[] = { "other", "loader", "mesh export", "shader", "frame" };
+        return names[static_cast<int>(tag)];
+    }
+
+    struct AllocationCounts
+    {
+        uint64_t allocations = 0;
+        uint64_t frees = 0;
+        uint64_t bytes = 0;
+        // bytes allocated and not yet freed, and their maximum since the last resetPeaks
+        uint64_t live = 0;
+        uint64_t peak = 0;
+    };
+
+    // Heap allocations of the process per AllocationTag. The counts only move in a program
+    // whose one translation unit defines DC_ALLOCATION_TRACKER_IMPLEMENTATION before it first
+    // includes this header, which replaces the global operator new and delete. Every block
+    // then carries a small header with its size and tag, so frees are charged to the
+    // subsystem that allocated. Counters are relaxed atomics, any thread may allocate.
+    class AllocationTracker
+    {
+    public:
+        // bytes in front of every block, keeps malloc's alignment
+        static const size_t HeaderSize = 16;
+
+        struct Header
+        {
+            size_t size;
+            AllocationTag tag;
+        };
+        static_assert(sizeof(Header) <= HeaderSize, "the header has to fit in front of the block");
+
+        static AllocationTracker& get()
+        {
+            static AllocationTracker tracker;
+            return tracker;
+        }
+
+        // the tag of the calling thread, set through AllocationScope
+        static AllocationTag& currentTag()
+        {
+            static thread_local AllocationTag tag = AllocationTag::Other;
+            return tag;
+        }
+
+        // whether the operators are replaced, the counts stay zero otherwise
+        bool installed() const { return m_installed; }
+        void markInstalled() { m_installed = true; }
+
+        void* allocate(size_t size)
+        {
+            AllocationTag tag = currentTag();
+            unsigned char* block = static_cast<unsigned char*>(std::malloc(size + HeaderSize));
+            if (!block)
+                return nullptr;
+            Header header = { size, tag };
+            std::memcpy(block, &header, sizeof(header));
+
+            Counters& c = m_counters[static_cast<int>(tag)];
+            c.allocations.fetch_add(1, std::memory_order_relaxed);
+            c.bytes.fetch_add(size, std::memory_order_relaxed);
+            uint64_t live = c.live.fetch_add(size, std::memory_order_relaxed) + size;
+            uint64_t peak = c.peak.load(std::memory_order_relaxed);
+            while (live > peak && !c.peak.compare_exchange_weak(peak, live, std::memory_order_relaxed))
+            {
+            }
+            return block + HeaderSize;
+        }
+
+        void free(void* p)
+        {
+            if (!p)
+                return;
+            unsigned char* block = static_cast<unsigned char*>(p) - HeaderSize;
+            Header header;
+            std::memcpy(&header, block, sizeof(header));
+            Counters& c = m_counters[static_cast<int>(header.tag)];
+            c.frees.fetch_add(1, std::memory_order_relaxed);
+            c.live.fetch_sub(header.size, std::memory_order_relaxed);
+            std::free(block);
+        }
+
+        AllocationCounts counts(AllocationTag tag) const
+        {
+            const Counters& c = m_counters[static_cast<int>(tag)];
+            AllocationCounts counts;
+            counts.allocations = c.allocations.load(std::memory_order_relaxed);
+            counts.frees = c.frees.load(std::memory_order_relaxed);
+            counts.bytes = c.bytes.load(std::memory_order_relaxed);
+            counts.live = c.live.load(std::memory_order_relaxed);
+            counts.peak = c.peak.load(std::memory_order_relaxed);
+            return counts;
+        }
+
+        // summed over every tag, the peak is the sum of the tags' peaks
+        AllocationCounts total() const
+        {
+            AllocationCounts sum;
+            for (int i = 0; i < static_cast<int>(AllocationTag::Count); ++i)
+            {
+                AllocationCounts c = counts(static_cast<AllocationTag>(i));
+                sum.allocations += c.allocations;
+                sum.frees += c.frees;
+                sum.bytes += c.bytes;
+                sum.live += c.live;
+                sum.peak += c.peak;
+            }
+            return sum;
+        }
+
+        // starts the peaks over at what is live now, to measure the peak of one phase
+        void resetPeaks()
+        {
+            for (auto& it : m_counters)
+            {
+                it.peak.store(it.live.load(std::memory_order_relaxed), std::memory_order_relaxed);
+            }
+        }
+
+        // one row per tag that allocated
+        void report(std::ostream& out) const
+        {
+            if (!m_installed)
+            {
+                out << "allocation tracking is not compiled in" << std::endl;
+                return;
+            }
+            out << std::left << std::setw(12) << "tag" << std::right << std::setw(12) << "allocations" << std::setw(12) << "frees"
+                << std::setw(14) << "KB" << std::setw(12) << "live KB" << std::setw(12) << "peak KB" << "\n";
+            out << std::fixed << std::setprecision(1);
+            for (int i = 0; i < static_cast<int>(AllocationTag::Count); ++i)
+            {
+                AllocationCounts c = counts(static_cast<AllocationTag>(i));
+                if (c.allocations == 0)
+                    continue;
+                out << std::left << std::setw(12) << allocationTagName(static_cast<AllocationTag>(i)) << std::right << std::setw(12) << c.allocations
+                    << std::setw(12) << c.frees << std::setw(14) << c.bytes / 1024.0 << std::setw(12) << c.live / 1024.0 << std::setw(12) << c.peak / 1024.0 << "\n";
+            }
+            out << std::defaultfloat << std::flush;
+        }
+
+    private:
+        struct Counters
+        {
+            std::atomic<uint64_t> allocations{ 0 };
+            std::atomic<uint64_t> frees{ 0 };
+            std::atomic<uint64_t> bytes{ 0 };
+            std::atomic<uint64_t> live{ 0 };
+            std::atomic<uint64_t> peak{ 0 };
+        };
+
+        Counters m_counters[static_cast<int>(AllocationTag::Count)];
+        bool m_installed = false;
+
+        AllocationTracker() = default;
+    };
+
+    // charges the allocations of the current thread to tag until it ends, scopes nest
+    class AllocationScope
+    {
+    public:
+        explicit AllocationScope(AllocationTag tag)
+            : m_previous(AllocationTracker::currentTag())
+        {
+            AllocationTracker::currentTag() = tag;
+        }
+
+        ~AllocationScope()
+        {
+            AllocationTracker::currentTag() = m_previous;
+        }
+
+        AllocationScope(const AllocationScope& other) = delete;
+        AllocationScope& operator=(const AllocationScope& other) = delete;
+
+    private:
+        AllocationTag m_previous;
+    };
+}
+
+#define DC_ALLOCATION_CONCAT_(a, b) a##b
+#define DC_ALLOCATION_CONCAT(a, b) DC_ALLOCATION_CONCAT_(a, b)
+
+#if DC_TRACK_ALLOCATIONS
+#define DC_ALLOCATION_SCOPE(tag) dc::AllocationScope DC_ALLOCATION_CONCAT(allocationScope, __LINE__)(dc::AllocationTag::tag)
+#else
+#define DC_ALLOCATION_SCOPE(tag)
+#endif
+
+#ifdef DC_ALLOCATION_TRACKER_IMPLEMENTATION
+// replacing the throwing forms is enough for new[], but the nothrow forms may go to malloc
+// directly, and every block has to come with a header
+static const bool dcAllocationTrackerInstalled = (dc::AllocationTracker::get().markInstalled(), true);
+
+// kept out of line, inlined into their callers the optimizer sees std::free and the header
+// arithmetic on a pointer from operator new and warns about both
+#ifdef _MSC_VER
+#define DC_ALLOCATION_NOINLINE __declspec(noinline)
+#else
+#define DC_ALLOCATION_NOINLINE __attribute__((noinline))
+#endif
+
+DC_ALLOCATION_NOINLINE void* operator new(size_t size)
+{
+    void* p = dc::AllocationTracker::get().allocate(size);
+    if (!p)
+        throw std::bad_alloc();
+    return p;
+}
+
+DC_ALLOCATION_NOINLINE void* operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+DC_ALLOCATION_NOINLINE void* operator new(size_t size, const std::nothrow_t&) noexcept
+{
+    return dc::AllocationTracker::get().allocate(size);
+}
+
+DC_ALLOCATION_NOINLINE void* operator new[](size_t size, const std::nothrow_t&) noexcept
+{
+    return dc::AllocationTracker::get().allocate(size);
+}
+
+DC_ALLOCATION_NOINLINE void operator delete(void* p) noexcept
+{
+    dc::AllocationTracker::get().free(p);
+}
+
+DC_ALLOCATION_NOINLINE void operator delete[](void* p) noexcept
+{
+    dc::AllocationTracker::get().free(p);
+}
+
+DC_ALLOCATION_NOINLINE void operator delete(void* p, size_t) noexcept
+{
+    dc::AllocationTracker::get().free(p);
+}
+
+DC_ALLOCATION_NOINLINE void operator delete[](void* p, size_t) noexcept
+{
+    dc::AllocationTracker::get().free(p);
+}
+
+DC_ALLOCATION_NOINLINE void operator delete(void* p, const std::nothrow_t&) noexcept
+{
+    dc::AllocationTracker::get().free(p);
+}
+
+DC_ALLOCATION_NOINLINE void operator delete[](void* p, const std::nothrow_t&) noexcept
+{
+    dc::AllocationTracker::get().free(p);
+}
+#endif
\ No newline at end of file
@@ -0,0 +1,74 @@
+#pragma once
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <utility>
+
+namespace dc
+{
+    // Bounded multi producer, multi consumer queue. push() blocks while the queue is full,
+    // which is what keeps the memory of a pipeline bounded when a later stage falls behind.
+    template<typename T>
+    class BlockingQueue
+    {
+    public:
+        explicit BlockingQueue(size_t capacity) : m_capacity(capacity) {}
+
+        BlockingQueue(const BlockingQueue& other) = delete;
+        BlockingQueue& operator=(const BlockingQueue& other) = delete;
+
+        // returns false if the queue was closed instead
+        bool push(T value)
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_notFull.wait(lock, [&]() { return m_closed || m_items.size() < m_capacity; });
+            if (m_closed)
+                return false;
+            m_items.push_back(std::move(value));
+            m_peak = m_items.size() > m_peak ? m_items.size() : m_peak;
+            m_notEmpty.notify_one();
+            return true;
+        }
+
+        // returns false once the queue is closed and drained
+        bool pop(T& value)
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_notEmpty.wait(lock, [&]() { return m_closed || !m_items.empty(); });
+            if (m_items.empty())
+                return false;
+            value = std::move(m_items.front());
+            m_items.pop_front();
+            m_notFull.notify_one();
+            return true;
+        }
+
+        // wakes every waiting thread, pop() still returns what is left
+        void close()
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_closed = true;
+            m_notEmpty.notify_all();
+            m_notFull.notify_all();
+        }
+
+        size_t capacity() const { return m_capacity; }
+
+        // largest number of items queued at once
+        size_t peak() const
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            return m_peak;
+        }
+
+    private:
+        size_t m_capacity;
+        size_t m_peak = 0;
+        bool m_closed = false;
+        std::deque<T> m_items;
+        mutable std::mutex m_mutex;
+        std::condition_variable m_notEmpty;
+        std::condition_variable m_notFull;
+    };
+}
\ No newline at end of file
@@ -0,0 +1,86 @@
+#pragma once
+#include <glad/glad.h>
+
+#include <cstddef>
+
+#include "GpuResources.hpp"
+#include "RenderStats.hpp"
+
+namespace dc
+{
+    // Owns a GL buffer object. The target is only used for binding, so one buffer can be
+    // bound as e.g. shader storage and indirect dispatch buffer at the same time.
+    class Buffer
+    {
+    public:
+        Buffer(GLenum target, size_t size, const void* data, GLenum usage)
+            : m_target(target), m_size(size), m_usage(usage)
+        {
+            glGenBuffers(1, &m_id);
+            bind();
+            glBufferData(m_target, m_size, data, m_usage);
+            GpuResources::get().add(GpuResourceType::Buffer, m_id, m_size, "buffer");
+            if (data)
+            {
+                ++renderStats().bufferUploads;
+                renderStats().bufferBytes += m_size;
+            }
+            unbind();
+        }
+
+        ~Buffer()
+        {
+            GpuResources::get().remove(GpuResourceType::Buffer, m_id);
+            glDeleteBuffers(1, &m_id);
+        }
+
+        Buffer(const Buffer& other) = delete;
+        Buffer& operator=(const Buffer& other) = delete;
+
+        GLuint id() const { return m_id; }
+        size_t size() const { return m_size; }
+
+        void bind() const
+        {
+            glBindBuffer(m_target, m_id);
+        }
+
+        void bind(GLenum target) const
+        {
+            glBindBuffer(target, m_id);
+        }
+
+        void unbind() const
+        {
+            glBindBuffer(m_target, 0);
+        }
+
+        void bindBase(GLenum target, GLuint index) const
+        {
+            glBindBufferBase(target, index, m_id);
+        }
+
+        void upload(size_t offset, size_t size, const void* data) const
+        {
+            ++renderStats().bufferUploads;
+            renderStats().bufferBytes += size;
+            bind();
+            glBufferSubData(m_target, offset, size, data);
+            unbind();
+        }
+
+        // synchronous, waits for the GPU to finish writing the buffer
+        void read(size_t offset, size_t size, void* data) const
+        {
+            bind();
+            glGetBufferSubData(m_target, offset, size, data);
+            unbind();
+        }
+
+    private:
+        GLuint m_id;
+        GLenum m_target;
+        size_t m_size;
+        GLenum m_usage;
+    };
+}
\ No newline at end of file
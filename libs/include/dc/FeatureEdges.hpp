@@ -0,0 +1,179 @@
+#pragma once
+#include <glm/glm.hpp>
+
+#include <cmath>
+#include <cstdint>
+#include <map>
+#include <tuple>
+#include <vector>
+
+#include "Simd.hpp"
+
+namespace dc
+{
+    // Object space feature lines of a mesh. Creases and open borders are view independent
+    // and stored as a plain line list. Every other edge between two non-coplanar faces is a
+    // silhouette candidate, kept with the planes of both faces in structure of arrays
+    // layout so four candidates are tested per SSE instruction.
+    struct FeatureEdges
+    {
+        // x, y, z, w of the plane n.x * x + n.y * y + n.z * z - w of either adjacent face,
+        // padded to a multiple of 4 with planes that never produce a silhouette
+        std::vector<float> plane0[4];
+        std::vector<float> plane1[4];
+        // two endpoints per candidate
+        std::vector<glm::vec3> candidateEndpoints;
+        // two endpoints per crease or border edge
+        std::vector<glm::vec3> creases;
+
+        size_t candidateCount() const { return candidateEndpoints.size() / 2; }
+
+        void addCandidate(const glm::vec3& a, const glm::vec3& b, const glm::vec4& p0, const glm::vec4& p1)
+        {
+            // overwrite padding first
+            size_t index = candidateCount();
+            if (index == plane0[0].size())
+            {
+                for (unsigned i = 0; i < 4; ++i)
+                {
+                    plane0[i].insert(plane0[i].end(), 4, i == 3 ? -1.0f : 0.0f);
+                    plane1[i].insert(plane1[i].end(), 4, i == 3 ? -1.0f : 0.0f);
+                }
+            }
+            for (unsigned i = 0; i < 4; ++i)
+            {
+                plane0[i][index] = p0[i];
+                plane1[i][index] = p1[i];
+            }
+            candidateEndpoints.push_back(a);
+            candidateEndpoints.push_back(b);
+        }
+    };
+
+    // builds edge adjacency for a triangle list, positions are welded by value so meshes
+    // that split vertices along uv or normal seams still connect
+    inline FeatureEdges buildFeatureEdges(const std::vector<glm::vec3>& positions, const std::vector<unsigned>& triangles, float creaseAngleDegrees)
+    {
+        std::map<std::tuple<float, float, float>, unsigned> welded;
+        std::vector<unsigned> canonical(positions.size());
+        for (unsigned i = 0; i < positions.size(); ++i)
+        {
+            auto key = std::make_tuple(positions[i].x, positions[i].y, positions[i].z);
+            auto it = welded.find(key);
+            canonical[i] = (it == welded.end()) ? (welded[key] = i) : it->second;
+        }
+
+        struct EdgeFaces
+        {
+            unsigned a;
+            unsigned b;
+            unsigned faceCount;
+            glm::vec4 planes[2];
+        };
+        std::map<uint64_t, EdgeFaces> edges;
+
+        for (size_t t = 0; t + 2 < triangles.size(); t += 3)
+        {
+            unsigned v[3] = { canonical[triangles[t]], canonical[triangles[t + 1]], canonical[triangles[t + 2]] };
+            glm::vec3 n = glm::cross(positions[v[1]] - positions[v[0]], positions[v[2]] - positions[v[0]]);
+            float length = glm::length(n);
+            if (length <= 0.0f)
+                continue;
+            n /= length;
+            glm::vec4 plane(n, glm::dot(n, positions[v[0]]));
+
+            for (unsigned e = 0; e < 3; ++e)
+            {
+                unsigned a = glm::min(v[e], v[(e + 1) % 3]);
+                unsigned b = glm::max(v[e], v[(e + 1) % 3]);
+                EdgeFaces& edge = edges[(static_cast<uint64_t>(a) << 32) | b];
+                if (edge.faceCount < 2)
+                {
+                    edge.planes[edge.faceCount] = plane;
+                }
+                edge.a = a;
+                edge.b = b;
+                ++edge.faceCount;
+            }
+        }
+
+        const float coplanar = 0.9999f;
+        const float crease = std::cos(glm::radians(creaseAngleDegrees));
+
+        FeatureEdges result;
+        for (const auto& it : edges)
+        {
+            const EdgeFaces& edge = it.second;
+            const glm::vec3& a = positions[edge.a];
+            const glm::vec3& b = positions[edge.b];
+            if (edge.faceCount != 2)
+            {
+                // open border or non-manifold
+                result.creases.push_back(a);
+                result.creases.push_back(b);
+                continue;
+            }
+
+            float cosAngle = glm::dot(glm::vec3(edge.planes[0]), glm::vec3(edge.planes[1]));
+            if (cosAngle >= coplanar)
+                continue;
+            if (cosAngle < crease)
+            {
+                result.creases.push_back(a);
+                result.creases.push_back(b);
+                continue;
+            }
+            result.addCandidate(a, b, edge.planes[0], edge.planes[1]);
+        }
+        return result;
+    }
+
+    // appends the endpoints of every candidate whose faces point to different sides of eye,
+    // eye in the same space as the mesh
+    inline void extractSilhouettes(const FeatureEdges& edges, const glm::vec3& eye, std::vector<glm::vec3>& lines, bool simd = true)
+    {
+        const size_t count = edges.candidateCount();
+        size_t i = 0;
+#ifdef DC_SSE2
+        if (simd)
+        {
+            const __m128 ex = _mm_set1_ps(eye.x);
+            const __m128 ey = _mm_set1_ps(eye.y);
+            const __m128 ez = _mm_set1_ps(eye.z);
+            for (; i + 4 <= edges.plane0[0].size(); i += 4)
+            {
+                __m128 f0 = _mm_mul_ps(_mm_loadu_ps(&edges.plane0[0][i]), ex);
+                f0 = _mm_add_ps(f0, _mm_mul_ps(_mm_loadu_ps(&edges.plane0[1][i]), ey));
+                f0 = _mm_add_ps(f0, _mm_mul_ps(_mm_loadu_ps(&edges.plane0[2][i]), ez));
+                f0 = _mm_sub_ps(f0, _mm_loadu_ps(&edges.plane0[3][i]));
+
+                __m128 f1 = _mm_mul_ps(_mm_loadu_ps(&edges.plane1[0][i]), ex);
+                f1 = _mm_add_ps(f1, _mm_mul_ps(_mm_loadu_ps(&edges.plane1[1][i]), ey));
+                f1 = _mm_add_ps(f1, _mm_mul_ps(_mm_loadu_ps(&edges.plane1[2][i]), ez));
+                f1 = _mm_sub_ps(f1, _mm_loadu_ps(&edges.plane1[3][i]));
+
+                // sign bits differ where one face is front and the other back facing
+                int mask = _mm_movemask_ps(_mm_xor_ps(f0, f1));
+                for (unsigned lane = 0; mask != 0; ++lane, mask >>= 1)
+                {
+                    if (mask & 1)
+                    {
+                        lines.push_back(edges.candidateEndpoints[2 * (i + lane)]);
+                        lines.push_back(edges.candidateEndpoints[2 * (i + lane) + 1]);
+                    }
+                }
+            }
+        }
+#endif
+        for (; i < count; ++i)
+        {
+            float f0 = edges.plane0[0][i] * eye.x + edges.plane0[1][i] * eye.y + edges.plane0[2][i] * eye.z - edges.plane0[3][i];
+            float f1 = edges.plane1[0][i] * eye.x + edges.plane1[1][i] * eye.y + edges.plane1[2][i] * eye.z - edges.plane1[3][i];
+            if (std::signbit(f0) != std::signbit(f1))
+            {
+                lines.push_back(edges.candidateEndpoints[2 * i]);
+                lines.push_back(edges.candidateEndpoints[2 * i + 1]);
+            }
+        }
+    }
+}
\ No newline at end of file
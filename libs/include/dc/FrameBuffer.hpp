@@ -1,8 +1,12 @@
 #pragma once
 #include <glad/glad.h>
 
+#include <stdexcept>
+#include <string>
 #include <vector>
 
+#include "GpuResources.hpp"
+#include "RenderStats.hpp"
 #include "Texture.hpp"
 
 namespace dc
@@ -26,15 +30,22 @@ namespace dc
             : m_width(width), m_height(height)
         {
             glGenFramebuffers(1, &m_id);
+            GpuResources::get().add(GpuResourceType::FrameBuffer, m_id, 0, std::to_string(m_width) + "x" + std::to_string(m_height)
+                + ", " + std::to_string(attachments.size()) + " attachments");
             bind();
 
             unsigned currentColorAttachment = 0;
             for (const auto& it : attachments)
             {
-                Texture* texture = new Texture(m_width, m_height, it.format, dc::TextureWrap::ClampToBorder, dc::TextureFilter::Linear);
+                // integer textures are incomplete with linear filtering
+                dc::TextureFilter filter = formatDesc(it.format).integer ? dc::TextureFilter::Nearest : dc::TextureFilter::Linear;
+                Texture* texture = new Texture(m_width, m_height, it.format, dc::TextureWrap::ClampToBorder, filter);
                 m_textures.push_back(texture);
+                m_formats.push_back(it.format);
 
-                GLenum attachments[] = {GL_COLOR_ATTACHMENT0 + currentColorAttachment, GL_DEPTH_ATTACHMENT};
+                // a depth format with stencil has to be attached to both
+                GLenum depthAttachment = it.format == dc::TextureFormat::Depth24Stencil8 ? GL_DEPTH_STENCIL_ATTACHMENT : GL_DEPTH_ATTACHMENT;
+                GLenum attachments[] = {GL_COLOR_ATTACHMENT0 + currentColorAttachment, depthAttachment};
                 glFramebufferTexture2D(GL_FRAMEBUFFER, attachments[it.attachment], GL_TEXTURE_2D, texture->id(), 0);
 
                 if (it.attachment == FBAttachmentType::AttachColor)
@@ -44,10 +55,21 @@ namespace dc
                 }
             }
 
+            // bind() above ran before any attachment existed and left the draw buffers at GL_NONE,
+            // which would make this framebuffer drop blits until it is bound again
+            glDrawBuffers(m_drawBuffers.size(), m_drawBuffers.data());
+
             GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
             if (status != GL_FRAMEBUFFER_COMPLETE)
             {
-                throw std::exception("frame buffer incomplete!");
+                // the destructor does not run for a constructor that throws
+                for (auto& it : m_textures)
+                {
+                    delete it;
+                }
+                GpuResources::get().remove(GpuResourceType::FrameBuffer, m_id);
+                glDeleteFramebuffers(1, &m_id);
+                throw std::runtime_error("frame buffer incomplete!");
             }
 
             unbind();
@@ -59,6 +81,7 @@ namespace dc
             {
                 delete it;
             }
+            GpuResources::get().remove(GpuResourceType::FrameBuffer, m_id);
             glDeleteFramebuffers(1, &m_id);
         }
 
@@ -67,9 +90,11 @@ namespace dc
 
         unsigned width() const { return m_width; }
         unsigned height() const { return m_height; }
+        GLuint id() const { return m_id; }
 
         void bind() const
         {
+            ++renderStats().framebufferBinds;
             glBindFramebuffer(GL_FRAMEBUFFER, m_id);
             glDrawBuffers(m_drawBuffers.size(), m_drawBuffers.data());
         }
@@ -80,11 +105,48 @@ namespace dc
             glDrawBuffer(GL_BACK);
         }
 
+        // copies the first color attachment into the default framebuffer, scaling linearly
+        void blitToDefault(unsigned width, unsigned height) const
+        {
+            blit(0, width, height);
+        }
+
+        // same for any other framebuffer object
+        void blit(GLuint target, unsigned width, unsigned height) const
+        {
+            glBindFramebuffer(GL_READ_FRAMEBUFFER, m_id);
+            glReadBuffer(GL_COLOR_ATTACHMENT0);
+            glBindFramebuffer(GL_DRAW_FRAMEBUFFER, target);
+            glBlitFramebuffer(0, 0, m_width, m_height, 0, 0, width, height, GL_COLOR_BUFFER_BIT, GL_LINEAR);
+            glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        }
+
         const Texture* texture(unsigned index) const
         {
             return m_textures[index];
         }
 
+        dc::TextureFormat format(unsigned index) const
+        {
+            return m_formats[index];
+        }
+
+        unsigned attachmentCount() const
+        {
+            return m_textures.size();
+        }
+
+        // sum over all attachments, with the padding the driver applies
+        unsigned bytesPerPixel() const
+        {
+            unsigned bytes = 0;
+            for (const auto& it : m_formats)
+            {
+                bytes += formatDesc(it).bytesPerPixel;
+            }
+            return bytes;
+        }
+
     private:
         unsigned m_width;
         unsigned m_height;
@@ -92,5 +154,6 @@ namespace dc
 
         std::vector<GLenum> m_drawBuffers;
         std::vector<Texture*> m_textures;
+        std::vector<dc::TextureFormat> m_formats;
     };
 }
\ No newline at end of file
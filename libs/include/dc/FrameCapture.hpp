@@ -0,0 +1,267 @@
+#pragma once
+#include <glad/glad.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "BlockingQueue.hpp"
+#include "Buffer.hpp"
+#include "FrameBuffer.hpp"
+#include "PngWriter.hpp"
+#include "Profiler.hpp"
+#include "ThreadPool.hpp"
+
+namespace dc
+{
+    struct CapturedFrame
+    {
+        uint64_t frame = 0;
+        unsigned width = 0;
+        unsigned height = 0;
+        // bottom row first, as glReadPixels returns it
+        std::vector<unsigned char> rgba;
+    };
+
+    // Reads frames back without stalling the render loop. capture() only queues a
+    // glReadPixels into the next pixel buffer object of a ring and fences it; frames are
+    // mapped once their fence has signaled, usually a frame or two later, and handed to
+    // the sink on an encoder thread. The render thread only waits when the whole ring is
+    // still in flight or every encoder buffer is taken, both show up in stats().
+    class FrameCapture
+    {
+    public:
+        // runs on an encoder thread, with several encoders frames may finish out of order.
+        // Returns false when the frame could not be written
+        typedef std::function<bool(CapturedFrame&)> Sink;
+
+        struct Stats
+        {
+            // frames handed to the sink
+            uint64_t frames = 0;
+            // frames whose buffer could not be mapped, they never reach the sink
+            uint64_t dropped = 0;
+            // frames the sink failed to write
+            uint64_t failed = 0;
+            // capture() calls that found the oldest ring slot still in flight
+            uint64_t ringStalls = 0;
+            double ringStallMs = 0.0;
+            // time spent waiting for a free encoder buffer
+            double encoderWaitMs = 0.0;
+            // render thread time inside capture(), flush() excluded
+            double captureMs = 0.0;
+            // mapping the signaled buffers and copying the pixels out, flush() included
+            double readbackMs = 0.0;
+        };
+
+        FrameCapture(unsigned width, unsigned height, Sink sink, unsigned ringSize = 3, unsigned encoders = 2)
+            : m_width(width), m_height(height), m_sink(std::move(sink)),
+              m_free(encoders * 2), m_encoders(encoders)
+        {
+            if (ringSize == 0)
+                throw std::invalid_argument("capture ring needs at least one slot");
+
+            size_t bytes = static_cast<size_t>(m_width) * m_height * 4;
+            m_slots.resize(ringSize);
+            for (auto& it : m_slots)
+            {
+                it.buffer.reset(new Buffer(GL_PIXEL_PACK_BUFFER, bytes, nullptr, GL_STREAM_READ));
+            }
+            for (size_t i = 0; i < m_free.capacity(); ++i)
+            {
+                m_free.push(std::vector<unsigned char>(bytes));
+            }
+        }
+
+        // delivers what is still in flight, the encoder pool then drains its queue
+        ~FrameCapture()
+        {
+            flush();
+        }
+
+        FrameCapture(const FrameCapture& other) = delete;
+        FrameCapture& operator=(const FrameCapture& other) = delete;
+
+        unsigned width() const { return m_width; }
+        unsigned height() const { return m_height; }
+        Stats stats() const
+        {
+            Stats stats = m_stats;
+            stats.failed = m_failed.load();
+            return stats;
+        }
+
+        // queues the readback of a color attachment, nullptr reads the default framebuffer's back buffer
+        void capture(const FrameBuffer* source, unsigned attachment = 0)
+        {
+            if (source && (source->width() != m_width || source->height() != m_height))
+                throw std::invalid_argument("capture source does not match the capture size");
+
+            DC_PROFILE_FUNCTION();
+            auto start = Clock::now();
+            collect();
+
+            Slot& slot = m_slots[m_head];
+            if (slot.pending)
+            {
+                auto stallStart = Clock::now();
+                while (slot.pending)
+                    deliverOldest(true);
+                ++m_stats.ringStalls;
+                m_stats.ringStallMs += millisecondsSince(stallStart);
+            }
+
+            glBindFramebuffer(GL_READ_FRAMEBUFFER, source ? source->id() : 0);
+            glReadBuffer(source ? GL_COLOR_ATTACHMENT0 + attachment : GL_BACK);
+            slot.buffer->bind();
+            glPixelStorei(GL_PACK_ALIGNMENT, 4);
+            // with a pack buffer bound the pointer is an offset and the call returns immediately
+            glReadPixels(0, 0, m_width, m_height, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+            slot.buffer->unbind();
+            glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+
+            slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+            slot.frame = m_nextFrame++;
+            slot.pending = true;
+            m_head = (m_head + 1) % m_slots.size();
+
+            m_stats.captureMs += millisecondsSince(start);
+        }
+
+        // blocks until every queued frame went through the sink, stats() is final after it
+        void flush()
+        {
+            while (m_slots[m_tail].pending)
+                deliverOldest(true);
+            // the encoders are idle once every buffer is back
+            std::vector<std::vector<unsigned char>> buffers(m_free.capacity());
+            for (auto& it : buffers)
+            {
+                m_free.pop(it);
+            }
+            for (auto& it : buffers)
+            {
+                m_free.push(std::move(it));
+            }
+        }
+
+        // sink writing <prefix>00042.png, alpha is dropped
+        static Sink pngSequence(const std::string& prefix)
+        {
+            return [prefix](CapturedFrame& frame)
+            {
+                size_t pixels = static_cast<size_t>(frame.width) * frame.height;
+                unsigned char* data = frame.rgba.data();
+                for (size_t i = 0; i < pixels; ++i)
+                {
+                    data[i * 3 + 0] = data[i * 4 + 0];
+                    data[i * 3 + 1] = data[i * 4 + 1];
+                    data[i * 3 + 2] = data[i * 4 + 2];
+                }
+                char number[16];
+                std::snprintf(number, sizeof(number), "%05llu", static_cast<unsigned long long>(frame.frame));
+                return writePng(prefix + number + ".png", data, frame.width, frame.height, 3, true);
+            };
+        }
+
+    private:
+        typedef std::chrono::high_resolution_clock Clock;
+
+        struct Slot
+        {
+            std::unique_ptr<Buffer> buffer;
+            GLsync fence = nullptr;
+            uint64_t frame = 0;
+            bool pending = false;
+        };
+
+        unsigned m_width;
+        unsigned m_height;
+        Sink m_sink;
+        Stats m_stats;
+        // counted on the encoder threads
+        std::atomic<uint64_t> m_failed{ 0 };
+
+        std::vector<Slot> m_slots;
+        size_t m_head = 0;
+        size_t m_tail = 0;
+        uint64_t m_nextFrame = 0;
+
+        // declared before the pool, so the encoders are joined while it still exists
+        BlockingQueue<std::vector<unsigned char>> m_free;
+        ThreadPool m_encoders;
+
+        static double millisecondsSince(Clock::time_point start)
+        {
+            std::chrono::duration<double, std::milli> elapsed = Clock::now() - start;
+            return elapsed.count();
+        }
+
+        // hands every slot whose fence has signaled to the encoders, oldest first
+        void collect()
+        {
+            while (m_slots[m_tail].pending && deliverOldest(false))
+            {
+            }
+        }
+
+        bool deliverOldest(bool wait)
+        {
+            Slot& slot = m_slots[m_tail];
+            // the flush bit makes sure the fence reaches the GPU even if nothing else flushes
+            GLuint64 timeout = wait ? 1000000000ull : 0;
+            GLenum status = glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, timeout);
+            if (status == GL_TIMEOUT_EXPIRED)
+                return false;
+            if (status == GL_WAIT_FAILED)
+                throw std::runtime_error("waiting for the capture fence failed");
+
+            CapturedFrame frame;
+            frame.frame = slot.frame;
+            frame.width = m_width;
+            frame.height = m_height;
+            auto waitStart = Clock::now();
+            m_free.pop(frame.rgba);
+            m_stats.encoderWaitMs += millisecondsSince(waitStart);
+
+            auto readStart = Clock::now();
+            slot.buffer->bind();
+            const void* mapped = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, slot.buffer->size(), GL_MAP_READ_BIT);
+            if (mapped)
+            {
+                std::memcpy(frame.rgba.data(), mapped, slot.buffer->size());
+                glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+            }
+            slot.buffer->unbind();
+            m_stats.readbackMs += millisecondsSince(readStart);
+
+            glDeleteSync(slot.fence);
+            slot.fence = nullptr;
+            slot.pending = false;
+            m_tail = (m_tail + 1) % m_slots.size();
+            // the encoder buffer would only hold an older frame's pixels
+            if (!mapped)
+            {
+                ++m_stats.dropped;
+                m_free.push(std::move(frame.rgba));
+                return true;
+            }
+            ++m_stats.frames;
+
+            m_encoders.submit(std::bind([this](CapturedFrame& captured)
+            {
+                if (!m_sink(captured))
+                    ++m_failed;
+                m_free.push(std::move(captured.rgba));
+            }, std::move(frame)));
+            return true;
+        }
+    };
+}
\ No newline at end of file
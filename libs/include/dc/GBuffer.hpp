@@ -0,0 +1,216 @@
+#pragma once
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <iostream>
+#include <iomanip>
+#include <stdexcept>
+
+#include "FrameBuffer.hpp"
+#include "NormalEncoding.hpp"
+#include "Mesh.hpp"
+#include "Shader.hpp"
+
+namespace dc
+{
+    struct GBufferLayout
+    {
+        std::string name;
+        // RGB8 or RGB10A2 store Kd directly, R16UI stores a material id into the palette
+        dc::TextureFormat colorFormat;
+        // RGB8 or RGB10A2 store N * 0.5 + 0.5, RG8 or RG16 store octahedral normals
+        dc::TextureFormat normalFormat;
+        // the largest angle in degrees a stored normal may be off, checked by checkGBufferLayouts
+        float normalErrorBound;
+
+        static GBufferLayout classic() { return { "classic", dc::TextureFormat::RGB8, dc::TextureFormat::RGB8, 0.4f }; }
+        static GBufferLayout rgb10a2() { return { "rgb10a2", dc::TextureFormat::RGB8, dc::TextureFormat::RGB10A2, 0.1f }; }
+        static GBufferLayout octahedral16() { return { "oct16", dc::TextureFormat::RGB8, dc::TextureFormat::RG16, 0.005f }; }
+        static GBufferLayout octahedral8() { return { "oct8", dc::TextureFormat::RGB8, dc::TextureFormat::RG8, 1.0f }; }
+        static GBufferLayout compact() { return { "compact", dc::TextureFormat::R16UI, dc::TextureFormat::RG8, 1.0f }; }
+
+        static std::vector<GBufferLayout> all()
+        {
+            return { classic(), rgb10a2(), octahedral16(), octahedral8(), compact() };
+        }
+
+        bool octahedralNormals() const
+        {
+            return normalFormat == dc::TextureFormat::RG8 || normalFormat == dc::TextureFormat::RG16;
+        }
+
+        bool materialIds() const
+        {
+            return colorFormat == dc::TextureFormat::R16UI;
+        }
+
+        unsigned normalBits() const
+        {
+            switch (normalFormat)
+            {
+            case dc::TextureFormat::RG16: return 16;
+            case dc::TextureFormat::RGB10A2: return 10;
+            default: return 8;
+            }
+        }
+
+        std::vector<dc::FrameBuffer::AttachmentDef> attachments() const
+        {
+            bool validColor = colorFormat == dc::TextureFormat::RGB8 || colorFormat == dc::TextureFormat::RGB10A2 || materialIds();
+            bool validNormal = normalFormat == dc::TextureFormat::RGB8 || normalFormat == dc::TextureFormat::RGB10A2 || octahedralNormals();
+            if (!validColor || !validNormal)
+                throw std::invalid_argument("unsupported g-buffer layout " + name);
+
+            return {
+                { dc::FBAttachmentType::AttachColor, colorFormat },
+                { dc::FBAttachmentType::AttachColor, normalFormat },
+                // the stencil counts overdraw, it comes free with 24 bit depth padded to 32
+                { dc::FBAttachmentType::AttachDepth, dc::TextureFormat::Depth24Stencil8 }
+            };
+        }
+
+        // defines for fragment.glsl and sobel.glsl so they encode/decode matching this layout
+        std::vector<std::string> shaderDefines() const
+        {
+            std::vector<std::string> defines;
+            if (octahedralNormals())
+                defines.push_back("NORMAL_OCTAHEDRAL");
+            if (materialIds())
+                defines.push_back("MATERIAL_ID");
+            return defines;
+        }
+
+        unsigned bytesPerPixel() const
+        {
+            unsigned bytes = 0;
+            for (const auto& it : attachments())
+            {
+                bytes += formatDesc(it.format).bytesPerPixel;
+            }
+            return bytes;
+        }
+    };
+
+    class GBuffer
+    {
+    public:
+        // material ids start at 1, id 0 is the background and maps to the clear color
+        static const unsigned MaxMaterials = 64;
+
+        GBuffer(unsigned width, unsigned height, const GBufferLayout& layout)
+            : m_layout(layout), m_fbo(width, height, layout.attachments())
+        {
+        }
+
+        GBuffer(const GBuffer& other) = delete;
+        GBuffer& operator=(const GBuffer& other) = delete;
+
+        const GBufferLayout& layout() const { return m_layout; }
+        const dc::FrameBuffer& frameBuffer() const { return m_fbo; }
+        unsigned width() const { return m_fbo.width(); }
+        unsigned height() const { return m_fbo.height(); }
+
+        void bind() const { m_fbo.bind(); }
+        void unbind() const { m_fbo.unbind(); }
+
+        const Texture* colorTexture() const { return m_fbo.texture(0); }
+        const Texture* normalTexture() const { return m_fbo.texture(1); }
+        const Texture* depthTexture() const { return m_fbo.texture(2); }
+
+        // glClear is undefined for integer attachments, so every target is cleared explicitly
+        void clear(const glm::vec3& clearColor) const
+        {
+            if (m_layout.materialIds())
+            {
+                GLuint background[] = { 0, 0, 0, 0 };
+                glClearBufferuiv(GL_COLOR, 0, background);
+            }
+            else
+            {
+                GLfloat background[] = { clearColor.r, clearColor.g, clearColor.b, 1.0f };
+                glClearBufferfv(GL_COLOR, 0, background);
+            }
+
+            // the background normal is the clear color read as N * 0.5 + 0.5, like the classic layout always did
+            glm::vec3 normal = clearColor;
+            if (m_layout.octahedralNormals())
+            {
+                glm::vec2 encoded = octEncode(glm::normalize(clearColor * 2.0f - 1.0f)) * 0.5f + 0.5f;
+                normal = glm::vec3(encoded, 0.0f);
+            }
+            GLfloat backgroundNormal[] = { normal.r, normal.g, normal.b, 1.0f };
+            glClearBufferfv(GL_COLOR, 1, backgroundNormal);
+
+            glClearBufferfi(GL_DEPTH_STENCIL, 0, 1.0f, 0);
+        }
+
+        // uploads the Kd of every material group so the post process can resolve material ids
+        void setMaterialPalette(const dc::Shader& shader, const dc::Mesh& mesh, const glm::vec3& clearColor) const
+        {
+            if (!m_layout.materialIds())
+                return;
+
+            if (mesh.groups().size() + 1 > MaxMaterials)
+                std::cout << "g-buffer palette only holds " << MaxMaterials - 1 << " materials, mesh has " << mesh.groups().size() << ", the rest share the last" << std::endl;
+
+            shader.setVec3("materialColors[0]", clearColor);
+            for (unsigned i = 0; i < mesh.groups().size() && i + 1 < MaxMaterials; ++i)
+            {
+                char name[32];
+                std::snprintf(name, sizeof(name), "materialColors[%u]", i + 1);
+                shader.setVec3(name, mesh.groups()[i].material.Kd);
+            }
+        }
+
+    private:
+        GBufferLayout m_layout;
+        dc::FrameBuffer m_fbo;
+    };
+
+    // prints storage cost and normal precision for every layout
+    inline void printGBufferReport(std::ostream& out, unsigned width, unsigned height)
+    {
+        std::ios::fmtflags flags(out.flags());
+        std::streamsize precision = out.precision();
+
+        out << "g-buffer layouts at " << width << "x" << height << ":" << std::endl;
+        for (const auto& it : GBufferLayout::all())
+        {
+            unsigned bpp = it.bytesPerPixel();
+            double megabytes = static_cast<double>(bpp) * width * height / (1024.0 * 1024.0);
+            double megabytes4k = static_cast<double>(bpp) * 3840 * 2160 / (1024.0 * 1024.0);
+            float normalError = maxNormalError(it.octahedralNormals(), it.normalBits());
+
+            out << "  " << std::left << std::setw(8) << it.name << std::right
+                << std::setw(3) << bpp << " B/px "
+                << std::fixed << std::setprecision(1) << std::setw(7) << megabytes << " MB "
+                << std::setw(7) << megabytes4k << " MB @4K "
+                << "normal error " << std::setprecision(3) << normalError << " deg (at most " << it.normalErrorBound << ")" << std::endl;
+        }
+        out.flags(flags);
+        out.precision(precision);
+    }
+
+    // measures the normal error of every layout against its bound, returns how many exceed it
+    inline unsigned checkGBufferLayouts(std::ostream& out)
+    {
+        std::ios::fmtflags flags(out.flags());
+        std::streamsize precision = out.precision();
+
+        unsigned failures = 0;
+        for (const auto& it : GBufferLayout::all())
+        {
+            float normalError = maxNormalError(it.octahedralNormals(), it.normalBits());
+            bool passed = normalError <= it.normalErrorBound;
+            out << std::left << std::setw(16) << it.name << std::right << std::fixed << std::setprecision(4)
+                << "normal error " << normalError << " deg, at most " << it.normalErrorBound << "  " << (passed ? "ok" : "FAILED") << std::endl;
+            failures += passed ? 0 : 1;
+        }
+        out.flags(flags);
+        out.precision(precision);
+        return failures;
+    }
+}
\ No newline at end of file
@@ -0,0 +1,84 @@
+#pragma once
+#include <glad/glad.h>
+
+// The bundled glad loader only covers GL 3.3 core. Entry points and enums of later
+// versions are loaded here, and only used after loadGL43 reported success.
+
+#ifndef GL_COMPUTE_SHADER
+#define GL_COMPUTE_SHADER 0x91B9
+#endif
+#ifndef GL_SHADER_IMAGE_ACCESS_BARRIER_BIT
+#define GL_SHADER_IMAGE_ACCESS_BARRIER_BIT 0x00000020
+#endif
+#ifndef GL_TEXTURE_FETCH_BARRIER_BIT
+#define GL_TEXTURE_FETCH_BARRIER_BIT 0x00000008
+#endif
+#ifndef GL_FRAMEBUFFER_BARRIER_BIT
+#define GL_FRAMEBUFFER_BARRIER_BIT 0x00000400
+#endif
+#ifndef GL_COMMAND_BARRIER_BIT
+#define GL_COMMAND_BARRIER_BIT 0x00000040
+#endif
+#ifndef GL_SHADER_STORAGE_BARRIER_BIT
+#define GL_SHADER_STORAGE_BARRIER_BIT 0x00002000
+#endif
+#ifndef GL_SHADER_STORAGE_BUFFER
+#define GL_SHADER_STORAGE_BUFFER 0x90D2
+#endif
+#ifndef GL_DISPATCH_INDIRECT_BUFFER
+#define GL_DISPATCH_INDIRECT_BUFFER 0x90EE
+#endif
+#ifndef GL_DRAW_INDIRECT_BUFFER
+#define GL_DRAW_INDIRECT_BUFFER 0x8F3F
+#endif
+#ifndef GL_BUFFER_UPDATE_BARRIER_BIT
+#define GL_BUFFER_UPDATE_BARRIER_BIT 0x00000200
+#endif
+
+namespace dc
+{
+    typedef void (APIENTRYP PFNDCDISPATCHCOMPUTEPROC)(GLuint num_groups_x, GLuint num_groups_y, GLuint num_groups_z);
+    typedef void (APIENTRYP PFNDCDISPATCHCOMPUTEINDIRECTPROC)(GLintptr indirect);
+    typedef void (APIENTRYP PFNDCMEMORYBARRIERPROC)(GLbitfield barriers);
+    typedef void (APIENTRYP PFNDCBINDIMAGETEXTUREPROC)(GLuint unit, GLuint texture, GLint level, GLboolean layered, GLint layer, GLenum access, GLenum format);
+    typedef void (APIENTRYP PFNDCDRAWELEMENTSINDIRECTPROC)(GLenum mode, GLenum type, const void* indirect);
+
+    struct GL43Functions
+    {
+        bool supported = false;
+        PFNDCDISPATCHCOMPUTEPROC dispatchCompute = nullptr;
+        PFNDCDISPATCHCOMPUTEINDIRECTPROC dispatchComputeIndirect = nullptr;
+        PFNDCMEMORYBARRIERPROC memoryBarrier = nullptr;
+        PFNDCBINDIMAGETEXTUREPROC bindImageTexture = nullptr;
+        // GL 4.0, part of 4.3 anyway
+        PFNDCDRAWELEMENTSINDIRECTPROC drawElementsIndirect = nullptr;
+    };
+
+    inline GL43Functions& gl43()
+    {
+        static GL43Functions functions;
+        return functions;
+    }
+
+    // call with the same loader passed to gladLoadGLLoader, after the context is current
+    inline bool loadGL43(GLADloadproc load)
+    {
+        GL43Functions& f = gl43();
+        f = GL43Functions();
+
+        GLint major = 0, minor = 0;
+        glGetIntegerv(GL_MAJOR_VERSION, &major);
+        glGetIntegerv(GL_MINOR_VERSION, &minor);
+        if (major < 4 || (major == 4 && minor < 3))
+            return false;
+
+        f.dispatchCompute = reinterpret_cast<PFNDCDISPATCHCOMPUTEPROC>(load("glDispatchCompute"));
+        f.dispatchComputeIndirect = reinterpret_cast<PFNDCDISPATCHCOMPUTEINDIRECTPROC>(load("glDispatchComputeIndirect"));
+        f.memoryBarrier = reinterpret_cast<PFNDCMEMORYBARRIERPROC>(load("glMemoryBarrier"));
+        f.bindImageTexture = reinterpret_cast<PFNDCBINDIMAGETEXTUREPROC>(load("glBindImageTexture"));
+        f.drawElementsIndirect = reinterpret_cast<PFNDCDRAWELEMENTSINDIRECTPROC>(load("glDrawElementsIndirect"));
+
+        f.supported = f.dispatchCompute && f.dispatchComputeIndirect && f.memoryBarrier && f.bindImageTexture && f.drawElementsIndirect;
+        return f.supported;
+    }
+}
\ No newline at end of file
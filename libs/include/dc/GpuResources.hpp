@@ -0,0 +1,205 @@
+#pragma once
+#include <glad/glad.h>
+
+#include <cstdint>
+#include <iomanip>
+#include <map>
+#include <ostream>
+#include <string>
+#include <utility>
+
+namespace dc
+{
+    enum class GpuResourceType
+    {
+        Texture,
+        Buffer,
+        VertexArray,
+        FrameBuffer,
+        Program,
+        Count
+    };
+
+    inline const char* gpuResourceTypeName(GpuResourceType type)
+    {
+        const char* names[] = { "texture", "buffer", "vertex array", "framebuffer", "program" };
+        return names[static_cast<int>(type)];
+    }
+
+    // Every GL object the dc:: classes own, with the bytes it is estimated to hold, who made
+    // it and where. Objects are charged to the innermost DC_GPU_RESOURCE_SCOPE of the thread
+    // that created them, "unscoped" without one. Textures count their levels with the
+    // driver's padding, buffers their size, vertex arrays, framebuffers and programs
+    // nothing, their storage is not visible to the GL. GL thread only, like the objects.
+    class GpuResources
+    {
+    public:
+        struct Resource
+        {
+            GpuResourceType type;
+            GLuint id;
+            size_t bytes;
+            // the scope's name and where it was opened
+            const char* owner;
+            const char* file;
+            int line;
+            // what the object is, e.g. its size and format or its shader files
+            std::string detail;
+        };
+
+        struct Totals
+        {
+            size_t count = 0;
+            size_t bytes = 0;
+        };
+
+        static GpuResources& get()
+        {
+            static GpuResources resources;
+            return resources;
+        }
+
+        void add(GpuResourceType type, GLuint id, size_t bytes, const std::string& detail)
+        {
+            Resource resource = { type, id, bytes, m_owner, m_file, m_line, detail };
+            m_resources[key(type, id)] = resource;
+        }
+
+        // buffers whose storage is respecified keep their entry
+        void resize(GpuResourceType type, GLuint id, size_t bytes)
+        {
+            auto it = m_resources.find(key(type, id));
+            if (it != m_resources.end())
+                it->second.bytes = bytes;
+        }
+
+        void remove(GpuResourceType type, GLuint id)
+        {
+            m_resources.erase(key(type, id));
+        }
+
+        Totals totals(GpuResourceType type) const
+        {
+            Totals totals;
+            for (const auto& it : m_resources)
+            {
+                if (it.second.type != type)
+                    continue;
+                ++totals.count;
+                totals.bytes += it.second.bytes;
+            }
+            return totals;
+        }
+
+        Totals totals() const
+        {
+            Totals totals;
+            for (const auto& it : m_resources)
+            {
+                ++totals.count;
+                totals.bytes += it.second.bytes;
+            }
+            return totals;
+        }
+
+        size_t count() const { return m_resources.size(); }
+
+        // live objects per type and per owner
+        void report(std::ostream& out) const
+        {
+            std::ios::fmtflags flags(out.flags());
+            std::streamsize precision = out.precision();
+
+            out << std::left << std::setw(16) << "GPU resources" << std::right << std::setw(8) << "count" << std::setw(10) << "MB" << std::endl;
+            out << std::fixed << std::setprecision(2);
+            for (int i = 0; i < static_cast<int>(GpuResourceType::Count); ++i)
+            {
+                Totals t = totals(static_cast<GpuResourceType>(i));
+                out << std::left << std::setw(16) << gpuResourceTypeName(static_cast<GpuResourceType>(i)) << std::right << std::setw(8) << t.count
+                    << std::setw(10) << t.bytes / (1024.0 * 1024.0) << std::endl;
+            }
+            std::map<std::string, Totals> owners;
+            for (const auto& it : m_resources)
+            {
+                Totals& t = owners[it.second.owner];
+                ++t.count;
+                t.bytes += it.second.bytes;
+            }
+            for (const auto& it : owners)
+            {
+                out << "  " << std::left << std::setw(14) << it.first << std::right << std::setw(8) << it.second.count
+                    << std::setw(10) << it.second.bytes / (1024.0 * 1024.0) << std::endl;
+            }
+
+            out.flags(flags);
+            out.precision(precision);
+        }
+
+        // lists every object still alive, call once everything that owns one is destroyed.
+        // The number of leaked objects is returned
+        size_t reportLeaks(std::ostream& out) const
+        {
+            if (m_resources.empty())
+                return 0;
+            out << m_resources.size() << " GL objects leaked" << std::endl;
+            for (const auto& it : m_resources)
+            {
+                const Resource& r = it.second;
+                out << "  " << gpuResourceTypeName(r.type) << " " << r.id << ", " << r.detail << ", " << r.bytes << " bytes, " << r.owner;
+                if (r.file)
+                    out << " at " << r.file << ":" << r.line;
+                out << std::endl;
+            }
+            return m_resources.size();
+        }
+
+    private:
+        friend class GpuResourceScope;
+
+        std::map<std::pair<int, GLuint>, Resource> m_resources;
+        const char* m_owner = "unscoped";
+        const char* m_file = nullptr;
+        int m_line = 0;
+
+        GpuResources() = default;
+
+        static std::pair<int, GLuint> key(GpuResourceType type, GLuint id)
+        {
+            return std::make_pair(static_cast<int>(type), id);
+        }
+    };
+
+    // charges the GL objects created until it ends to owner, scopes nest
+    class GpuResourceScope
+    {
+    public:
+        GpuResourceScope(const char* owner, const char* file, int line)
+            : m_owner(GpuResources::get().m_owner), m_file(GpuResources::get().m_file), m_line(GpuResources::get().m_line)
+        {
+            GpuResources& resources = GpuResources::get();
+            resources.m_owner = owner;
+            resources.m_file = file;
+            resources.m_line = line;
+        }
+
+        ~GpuResourceScope()
+        {
+            GpuResources& resources = GpuResources::get();
+            resources.m_owner = m_owner;
+            resources.m_file = m_file;
+            resources.m_line = m_line;
+        }
+
+        GpuResourceScope(const GpuResourceScope& other) = delete;
+        GpuResourceScope& operator=(const GpuResourceScope& other) = delete;
+
+    private:
+        const char* m_owner;
+        const char* m_file;
+        int m_line;
+    };
+}
+
+#define DC_GPU_RESOURCE_CONCAT_(a, b) a##b
+#define DC_GPU_RESOURCE_CONCAT(a, b) DC_GPU_RESOURCE_CONCAT_(a, b)
+#define DC_GPU_RESOURCE_SCOPE(owner) dc::GpuResourceScope DC_GPU_RESOURCE_CONCAT(gpuResourceScope, __LINE__)(owner, __FILE__, __LINE__)
\ No newline at end of file
@@ -0,0 +1,259 @@
+#pragma once
+#include <glad/glad.h>
+
+#include <algorithm>
+#include <functional>
+#include <iomanip>
+#include <map>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "Profiler.hpp"
+
+namespace dc
+{
+    // GPU time of named passes from GL_TIMESTAMP queries written before and after each of
+    // them. Query pairs come from a ring of several frames' worth and are read in order
+    // once the GL reports them available, so nothing waits on the GPU; a pass begun while
+    // every pair is still in flight is not timed. Passes may nest. Each pass keeps its
+    // last samples for rolling statistics, and while dc::Profiler records the spans also
+    // go to its trace. Once every pass has been seen a frame allocates nothing, the rings
+    // and sample windows are sized up front and overwritten in place.
+    class GpuTimer
+    {
+    public:
+        struct Stats
+        {
+            size_t samples = 0;
+            double mean = 0.0;
+            double p50 = 0.0;
+            double p95 = 0.0;
+            double max = 0.0;
+        };
+
+        // pairs is the ring depth in passes, window the samples the statistics cover
+        explicit GpuTimer(unsigned pairs = 64, size_t window = 240)
+            : m_ids(pairs * 2), m_pending(pairs), m_window(std::max<size_t>(window, 1))
+        {
+            glGenQueries(static_cast<GLsizei>(m_ids.size()), m_ids.data());
+            m_free.reserve(pairs);
+            for (unsigned i = pairs; i-- > 0;)
+            {
+                m_free.push_back(i);
+            }
+            m_open.reserve(16);
+        }
+
+        ~GpuTimer()
+        {
+            glDeleteQueries(static_cast<GLsizei>(m_ids.size()), m_ids.data());
+        }
+
+        GpuTimer(const GpuTimer& other) = delete;
+        GpuTimer& operator=(const GpuTimer& other) = delete;
+
+        // name must outlive the timer, like a profiler zone name
+        void begin(const char* name)
+        {
+            collect(false);
+            Profiler& profiler = Profiler::get();
+            if (profiler.recording() && !profiler.gpuCalibrated())
+            {
+                GLint64 now = 0;
+                glGetInteger64v(GL_TIMESTAMP, &now);
+                profiler.calibrateGpu(now);
+            }
+
+            Span span = { name, NoPair };
+            if (!m_free.empty())
+            {
+                span.pair = m_free.back();
+                m_free.pop_back();
+                glQueryCounter(m_ids[span.pair * 2], GL_TIMESTAMP);
+            }
+            else
+            {
+                ++m_dropped;
+            }
+            m_open.push_back(span);
+        }
+
+        void end()
+        {
+            if (m_open.empty())
+                return;
+            Span span = m_open.back();
+            m_open.pop_back();
+            if (span.pair == NoPair)
+                return;
+            glQueryCounter(m_ids[span.pair * 2 + 1], GL_TIMESTAMP);
+            m_pending[(m_pendingFirst + m_pendingCount) % m_pending.size()] = span;
+            ++m_pendingCount;
+        }
+
+        // waits for every pass in flight, for the end of a run or before writing a trace
+        void flush()
+        {
+            collect(true);
+        }
+
+        Stats stats(const std::string& name) const
+        {
+            Stats stats;
+            auto it = m_samples.find(name);
+            if (it == m_samples.end() || it->second.values.empty())
+                return stats;
+            std::vector<double> values = it->second.values;
+            std::sort(values.begin(), values.end());
+            double sum = 0.0;
+            for (double value : values)
+            {
+                sum += value;
+            }
+            stats.samples = values.size();
+            stats.mean = sum / values.size();
+            stats.p50 = values[values.size() / 2];
+            stats.p95 = values[(values.size() * 95) / 100];
+            stats.max = values.back();
+            return stats;
+        }
+
+        // rolling mean
+        double milliseconds(const std::string& name) const { return stats(name).mean; }
+
+        // every pass timed so far, sorted by name
+        std::vector<std::string> passes() const
+        {
+            std::vector<std::string> names;
+            for (const auto& it : m_samples)
+            {
+                names.push_back(it.first);
+            }
+            return names;
+        }
+
+        // the samples the statistics cover, oldest first, empty for a pass never timed
+        std::vector<double> samples(const std::string& name) const
+        {
+            auto it = m_samples.find(name);
+            if (it == m_samples.end())
+                return {};
+            const Samples& samples = it->second;
+            std::vector<double> ordered(samples.values.begin() + samples.next, samples.values.end());
+            ordered.insert(ordered.end(), samples.values.begin(), samples.values.begin() + samples.next);
+            return ordered;
+        }
+
+        // the newest sample of a pass into milliseconds, returns how many the pass had so far,
+        // 0 for a pass never timed
+        uint64_t latest(const char* name, double& milliseconds) const
+        {
+            auto it = m_samples.find(name);
+            if (it == m_samples.end() || it->second.count == 0)
+                return 0;
+            const Samples& samples = it->second;
+            size_t newest = samples.values.size() < m_window ? samples.values.size() - 1 : (samples.next + m_window - 1) % m_window;
+            milliseconds = samples.values[newest];
+            return samples.count;
+        }
+
+        // passes not timed because the ring was full
+        size_t dropped() const { return m_dropped; }
+
+        void printSummary(std::ostream& out) const
+        {
+            std::ios::fmtflags flags(out.flags());
+            std::streamsize precision = out.precision();
+
+            out << std::left << std::setw(18) << "GPU ms" << std::right << std::setw(9) << "mean" << std::setw(9) << "p50"
+                << std::setw(9) << "p95" << std::setw(9) << "max" << std::setw(9) << "samples" << std::endl;
+            out << std::fixed << std::setprecision(2);
+            for (const auto& it : m_samples)
+            {
+                Stats s = stats(it.first);
+                out << std::left << std::setw(18) << it.first << std::right << std::setw(9) << s.mean << std::setw(9) << s.p50
+                    << std::setw(9) << s.p95 << std::setw(9) << s.max << std::setw(9) << s.samples << std::endl;
+            }
+            if (m_dropped > 0)
+                out << m_dropped << " passes not timed, the query ring was full" << std::endl;
+
+            out.flags(flags);
+            out.precision(precision);
+        }
+
+    private:
+        static const unsigned NoPair = ~0u;
+
+        struct Span
+        {
+            const char* name;
+            unsigned pair;
+        };
+
+        // the last window samples of a pass, next is the oldest once the window is full
+        struct Samples
+        {
+            std::vector<double> values;
+            size_t next = 0;
+            // every sample taken, not only those in the window
+            uint64_t count = 0;
+        };
+
+        std::vector<GLuint> m_ids;
+        std::vector<unsigned> m_free;
+        std::vector<Span> m_open;
+        // ring of ended passes in the order they ended, which is the order the GPU completes them
+        std::vector<Span> m_pending;
+        size_t m_pendingFirst = 0;
+        size_t m_pendingCount = 0;
+        // std::less<> finds a pass by its const char* name without building a std::string
+        std::map<std::string, Samples, std::less<>> m_samples;
+        size_t m_window;
+        size_t m_dropped = 0;
+
+        void collect(bool wait)
+        {
+            while (m_pendingCount > 0)
+            {
+                const Span& span = m_pending[m_pendingFirst];
+                GLuint beginQuery = m_ids[span.pair * 2];
+                GLuint endQuery = m_ids[span.pair * 2 + 1];
+                if (!wait)
+                {
+                    GLint available = 0;
+                    glGetQueryObjectiv(endQuery, GL_QUERY_RESULT_AVAILABLE, &available);
+                    if (!available)
+                        break;
+                }
+                GLuint64 begin = 0, end = 0;
+                glGetQueryObjectui64v(beginQuery, GL_QUERY_RESULT, &begin);
+                glGetQueryObjectui64v(endQuery, GL_QUERY_RESULT, &end);
+
+                auto it = m_samples.find(span.name);
+                if (it == m_samples.end())
+                {
+                    it = m_samples.emplace(span.name, Samples()).first;
+                    it->second.values.reserve(m_window);
+                }
+                Samples& samples = it->second;
+                if (samples.values.size() < m_window)
+                {
+                    samples.values.push_back((end - begin) / 1.0e6);
+                }
+                else
+                {
+                    samples.values[samples.next] = (end - begin) / 1.0e6;
+                    samples.next = (samples.next + 1) % m_window;
+                }
+                ++samples.count;
+                if (Profiler::get().gpuCalibrated())
+                    Profiler::get().pushGpu(span.name, static_cast<int64_t>(begin), static_cast<int64_t>(end));
+
+                m_free.push_back(span.pair);
+                m_pendingFirst = (m_pendingFirst + 1) % m_pending.size();
+                --m_pendingCount;
+            }
+        }
+    };
+}
\ No newline at end of file
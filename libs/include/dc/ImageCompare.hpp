@@ -0,0 +1,190 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+#include <ostream>
+#include <stdexcept>
+#include <vector>
+
+namespace dc
+{
+    struct ImageDifference
+    {
+        // largest channel difference, 0 - 255
+        unsigned maxError = 0;
+        double meanError = 0.0;
+        // pixels with any channel off by more than the tolerance
+        double differingShare = 0.0;
+        // infinite for identical images
+        double psnr = std::numeric_limits<double>::infinity();
+
+        void print(std::ostream& out) const
+        {
+            out << "max error " << maxError << ", mean error " << meanError << ", "
+                << differingShare * 100.0 << "% pixels differ, PSNR " << psnr << " dB";
+        }
+    };
+
+    // Compares two 8 bit images of the same size and channel count. When diff is given it
+    // receives an RGB image, black where the pixels match within tolerance and the
+    // amplified difference elsewhere.
+    inline ImageDifference compareImages(const unsigned char* a, const unsigned char* b, unsigned width, unsigned height, unsigned channels,
+        unsigned tolerance = 0, std::vector<unsigned char>* diff = nullptr)
+    {
+        if (channels == 0)
+            throw std::invalid_argument("images without channels");
+
+        size_t pixels = static_cast<size_t>(width) * height;
+        if (diff)
+            diff->assign(pixels * 3, 0);
+
+        ImageDifference result;
+        double sum = 0.0;
+        double squares = 0.0;
+        size_t differing = 0;
+        for (size_t i = 0; i < pixels; ++i)
+        {
+            unsigned pixelError = 0;
+            for (unsigned c = 0; c < channels; ++c)
+            {
+                unsigned error = static_cast<unsigned>(std::abs(a[i * channels + c] - b[i * channels + c]));
+                pixelError = std::max(pixelError, error);
+                sum += error;
+                squares += static_cast<double>(error) * error;
+            }
+            result.maxError = std::max(result.maxError, pixelError);
+            if (pixelError > tolerance)
+            {
+                ++differing;
+                if (diff)
+                {
+                    unsigned char value = static_cast<unsigned char>(std::min(255u, 64 + pixelError * 4));
+                    for (unsigned c = 0; c < 3; ++c)
+                        (*diff)[i * 3 + c] = value;
+                }
+            }
+        }
+
+        double samples = static_cast<double>(pixels) * channels;
+        if (samples > 0.0)
+        {
+            result.meanError = sum / samples;
+            result.differingShare = static_cast<double>(differing) / pixels;
+            if (squares > 0.0)
+                result.psnr = 10.0 * std::log10(255.0 * 255.0 / (squares / samples));
+        }
+        return result;
+    }
+
+    struct PerceptualDifference
+    {
+        // CIE76 delta E of the pixel pairs, about 2.3 is just noticeable
+        double maxDeltaE = 0.0;
+        double meanDeltaE = 0.0;
+        // pixels with no neighbour in the reference within the threshold
+        double differingShare = 0.0;
+
+        void print(std::ostream& out) const
+        {
+            out << "max delta E " << maxDeltaE << ", mean delta E " << meanDeltaE << ", "
+                << differingShare * 100.0 << "% pixels differ visibly";
+        }
+    };
+
+    // Compares an 8 bit sRGB image against a reference in CIELAB. A pixel only differs when
+    // no reference pixel within radius comes closer than threshold, so edges moved by a
+    // pixel and anti-aliasing noise pass while a changed color or a missing line does not.
+    // diff receives an RGB image like compareImages writes.
+    inline PerceptualDifference compareImagesPerceptual(const unsigned char* reference, const unsigned char* image, unsigned width, unsigned height, unsigned channels,
+        double threshold = 2.3, unsigned radius = 1, std::vector<unsigned char>* diff = nullptr)
+    {
+        if (channels < 3)
+            throw std::invalid_argument("perceptual comparison needs RGB images");
+
+        auto toLinear = [](unsigned char value)
+        {
+            double c = value / 255.0;
+            return c <= 0.04045 ? c / 12.92 : std::pow((c + 0.055) / 1.055, 2.4);
+        };
+        auto labPivot = [](double t)
+        {
+            return t > 0.008856 ? std::cbrt(t) : 7.787 * t + 16.0 / 116.0;
+        };
+        size_t pixels = static_cast<size_t>(width) * height;
+        auto toLab = [&](const unsigned char* rgb, std::vector<double>& lab)
+        {
+            lab.resize(pixels * 3);
+            for (size_t i = 0; i < pixels; ++i)
+            {
+                double r = toLinear(rgb[i * channels]);
+                double g = toLinear(rgb[i * channels + 1]);
+                double b = toLinear(rgb[i * channels + 2]);
+                // D65 white
+                double x = labPivot((0.4124 * r + 0.3576 * g + 0.1805 * b) / 0.95047);
+                double y = labPivot(0.2126 * r + 0.7152 * g + 0.0722 * b);
+                double z = labPivot((0.0193 * r + 0.1192 * g + 0.9505 * b) / 1.08883);
+                lab[i * 3] = 116.0 * y - 16.0;
+                lab[i * 3 + 1] = 500.0 * (x - y);
+                lab[i * 3 + 2] = 200.0 * (y - z);
+            }
+        };
+        std::vector<double> a, b;
+        toLab(reference, a);
+        toLab(image, b);
+        auto deltaE = [&](size_t i, size_t j)
+        {
+            double dl = a[j * 3] - b[i * 3];
+            double da = a[j * 3 + 1] - b[i * 3 + 1];
+            double db = a[j * 3 + 2] - b[i * 3 + 2];
+            return std::sqrt(dl * dl + da * da + db * db);
+        };
+
+        if (diff)
+            diff->assign(pixels * 3, 0);
+        PerceptualDifference result;
+        double sum = 0.0;
+        size_t differing = 0;
+        int r = static_cast<int>(radius);
+        for (unsigned y = 0; y < height; ++y)
+        {
+            for (unsigned x = 0; x < width; ++x)
+            {
+                size_t i = static_cast<size_t>(y) * width + x;
+                double error = deltaE(i, i);
+                sum += error;
+                result.maxDeltaE = std::max(result.maxDeltaE, error);
+                if (error <= threshold)
+                    continue;
+
+                double nearest = error;
+                for (int dy = -r; dy <= r && nearest > threshold; ++dy)
+                {
+                    for (int dx = -r; dx <= r && nearest > threshold; ++dx)
+                    {
+                        int nx = static_cast<int>(x) + dx;
+                        int ny = static_cast<int>(y) + dy;
+                        if (nx >= 0 && ny >= 0 && nx < static_cast<int>(width) && ny < static_cast<int>(height))
+                            nearest = std::min(nearest, deltaE(i, static_cast<size_t>(ny) * width + nx));
+                    }
+                }
+                if (nearest > threshold)
+                {
+                    ++differing;
+                    if (diff)
+                    {
+                        unsigned char value = static_cast<unsigned char>(std::min(255.0, 64.0 + nearest * 4.0));
+                        for (unsigned c = 0; c < 3; ++c)
+                            (*diff)[i * 3 + c] = value;
+                    }
+                }
+            }
+        }
+        if (pixels > 0)
+        {
+            result.meanDeltaE = sum / pixels;
+            result.differingShare = static_cast<double>(differing) / pixels;
+        }
+        return result;
+    }
+}
\ No newline at end of file
@@ -1,12 +1,31 @@
 #pragma once
+#include <algorithm>
+#include <limits>
+#include <utility>
 #include <vector>
 
+#include "GLExtensions.hpp"
+#include "GpuResources.hpp"
 #include "Materials.hpp"
+#include "Profiler.hpp"
+#include "RenderStats.hpp"
 #include "VertexData.hpp"
 #include "Shader.hpp"
+#include "FeatureEdges.hpp"
 
 namespace dc
 {
+    // CPU side of a mesh, everything exportMesh produces before touching the GL, so it can
+    // be built on worker threads and uploaded later
+    struct MeshData
+    {
+        std::vector<dc::VertexData> vertices;
+        std::vector<unsigned> indices;
+        std::vector<dc::IndexGroup> groups;
+        // empty unless the caller asked ObjLoader::exportFeatureEdges for them
+        dc::FeatureEdges featureEdges;
+    };
+
     class Mesh
     {
     public:
@@ -16,51 +35,139 @@ namespace dc
             m_indices = p_indices;
             m_groups = p_groups;
 
+            createBuffers();
             uploadToGPU();
         }
 
+        explicit Mesh(MeshData data)
+        {
+            createBuffers();
+            update(std::move(data));
+        }
+
         ~Mesh()
         {
+            GpuResources::get().remove(GpuResourceType::VertexArray, m_vaoId);
+            GpuResources::get().remove(GpuResourceType::Buffer, m_vboId);
+            GpuResources::get().remove(GpuResourceType::Buffer, m_eboId);
             glDeleteVertexArrays(1, std::addressof(m_vaoId));
+            glDeleteBuffers(1, std::addressof(m_vboId));
+            glDeleteBuffers(1, std::addressof(m_eboId));
         }
 
         Mesh(const Mesh& other) = delete;
         Mesh& operator=(const Mesh& other) = delete;
 
-        void draw(const dc::Shader& shader) const
+        // replaces the contents but keeps the GL objects, for recycling one mesh across many models
+        void update(MeshData data)
+        {
+            m_vertices = std::move(data.vertices);
+            m_indices = std::move(data.indices);
+            m_groups = std::move(data.groups);
+            m_featureEdges = std::move(data.featureEdges);
+
+            uploadToGPU();
+        }
+
+        // materialIds is the largest material id the g-buffer's palette holds, 0 for layouts
+        // without ids. Ids start at 1, 0 is the background, and groups past the palette share
+        // its last entry
+        void draw(const dc::Shader& shader, unsigned materialIds = 0) const
         {
+            DC_PROFILE_ZONE("Mesh::draw");
             glBindVertexArray(m_vaoId);
-            for (const auto& it : m_groups)
+            for (unsigned i = 0; i < m_groups.size(); ++i)
             {
+                const auto& it = m_groups[i];
+                if (materialIds > 0)
+                    shader.setInt("materialId", std::min(i + 1, materialIds));
                 shader.setVec3("Ka", it.material.Ka);
                 shader.setVec3("Kd", it.material.Kd);
                 shader.setVec3("Ks", it.material.Ks);
 
                 glDrawElements(GL_TRIANGLES, it.count, GL_UNSIGNED_INT, reinterpret_cast<const void*>(sizeof(unsigned) * it.offset));
+                ++renderStats().drawCalls;
+                renderStats().triangles += it.count / 3;
+            }
+            glBindVertexArray(0);
+        }
+
+        // every group with the instance count from a DrawElementsIndirectCommand per group,
+        // read from the bound GL_DRAW_INDIRECT_BUFFER at offset. Needs GL 4.0, see dc::gl43.
+        // materialIds as for draw
+        void drawIndirect(const dc::Shader& shader, size_t offset, unsigned materialIds = 0) const
+        {
+            glBindVertexArray(m_vaoId);
+            for (unsigned i = 0; i < m_groups.size(); ++i)
+            {
+                const auto& it = m_groups[i];
+                if (materialIds > 0)
+                    shader.setInt("materialId", std::min(i + 1, materialIds));
+                shader.setVec3("Ka", it.material.Ka);
+                shader.setVec3("Kd", it.material.Kd);
+                shader.setVec3("Ks", it.material.Ks);
+
+                dc::gl43().drawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, reinterpret_cast<const void*>(offset + sizeof(GLuint) * 5 * i));
+                // the instance count is only known to the GPU, so are the triangles
+                ++renderStats().drawCalls;
             }
             glBindVertexArray(0);
         }
 
+        const std::vector<dc::IndexGroup>& groups() const { return m_groups; }
+        size_t vertexCount() const { return m_vertices.size(); }
+        size_t triangleCount() const { return m_indices.size() / 3; }
+
+        // axis aligned bounds of all vertices, in model space
+        const glm::vec3& boundsMin() const { return m_boundsMin; }
+        const glm::vec3& boundsMax() const { return m_boundsMax; }
+
+        // creases and silhouette candidates for geometric edge rendering, empty until set
+        const dc::FeatureEdges& featureEdges() const { return m_featureEdges; }
+        void setFeatureEdges(dc::FeatureEdges edges) { m_featureEdges = std::move(edges); }
+
     private:
         std::vector<dc::VertexData> m_vertices;
         std::vector<unsigned int> m_indices;
         std::vector<dc::IndexGroup> m_groups;
+        dc::FeatureEdges m_featureEdges;
+        glm::vec3 m_boundsMin;
+        glm::vec3 m_boundsMax;
 
         GLuint m_vaoId;
+        GLuint m_vboId;
+        GLuint m_eboId;
 
-        void uploadToGPU()
+        void createBuffers()
         {
             glGenVertexArrays(1, std::addressof(m_vaoId));
+            glGenBuffers(1, std::addressof(m_vboId));
+            glGenBuffers(1, std::addressof(m_eboId));
+            GpuResources::get().add(GpuResourceType::VertexArray, m_vaoId, 0, "mesh");
+            GpuResources::get().add(GpuResourceType::Buffer, m_vboId, 0, "mesh vertices");
+            GpuResources::get().add(GpuResourceType::Buffer, m_eboId, 0, "mesh indices");
+        }
 
-            GLuint vboId, eboId;
-            glGenBuffers(1, std::addressof(vboId));
-            glGenBuffers(1, std::addressof(eboId));
+        void uploadToGPU()
+        {
+            DC_PROFILE_FUNCTION();
+            m_boundsMin = glm::vec3(m_vertices.empty() ? 0.0f : std::numeric_limits<float>::max());
+            m_boundsMax = -m_boundsMin;
+            for (const auto& it : m_vertices)
+            {
+                m_boundsMin = glm::min(m_boundsMin, it.position);
+                m_boundsMax = glm::max(m_boundsMax, it.position);
+            }
 
             glBindVertexArray(m_vaoId);
-            glBindBuffer(GL_ARRAY_BUFFER, vboId);
+            glBindBuffer(GL_ARRAY_BUFFER, m_vboId);
             glBufferData(GL_ARRAY_BUFFER, sizeof(dc::VertexData) * m_vertices.size(), m_vertices.data(), GL_STATIC_DRAW);
-            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, eboId);
+            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_eboId);
             glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(unsigned) * m_indices.size(), m_indices.data(), GL_STATIC_DRAW);
+            GpuResources::get().resize(GpuResourceType::Buffer, m_vboId, sizeof(dc::VertexData) * m_vertices.size());
+            GpuResources::get().resize(GpuResourceType::Buffer, m_eboId, sizeof(unsigned) * m_indices.size());
+            renderStats().bufferUploads += 2;
+            renderStats().bufferBytes += sizeof(dc::VertexData) * m_vertices.size() + sizeof(unsigned) * m_indices.size();
 
             // position = 0
             glEnableVertexAttribArray(0);
@@ -75,9 +182,6 @@ namespace dc
             glBindVertexArray(0);
             glBindBuffer(GL_ARRAY_BUFFER, 0);
             glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
-
-            glDeleteBuffers(1, std::addressof(vboId));
-            glDeleteBuffers(1, std::addressof(eboId));
         }
     };
 }
\ No newline at end of file
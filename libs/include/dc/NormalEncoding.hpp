@@ -0,0 +1,72 @@
+#pragma once
+#include <glm/glm.hpp>
+
+#include <cmath>
+
+namespace dc
+{
+    // CPU mirror of the octahedral encoding in fragment.glsl / sobel.glsl.
+    // Maps a unit vector onto the [-1, 1]^2 square.
+    inline glm::vec2 octEncode(glm::vec3 n)
+    {
+        n /= std::abs(n.x) + std::abs(n.y) + std::abs(n.z);
+        glm::vec2 e(n.x, n.y);
+        if (n.z < 0.0f)
+        {
+            glm::vec2 signs(e.x >= 0.0f ? 1.0f : -1.0f, e.y >= 0.0f ? 1.0f : -1.0f);
+            e = (glm::vec2(1.0f) - glm::abs(glm::vec2(e.y, e.x))) * signs;
+        }
+        return e;
+    }
+
+    inline glm::vec3 octDecode(glm::vec2 e)
+    {
+        glm::vec3 n(e.x, e.y, 1.0f - std::abs(e.x) - std::abs(e.y));
+        float t = glm::clamp(-n.z, 0.0f, 1.0f);
+        n.x += n.x >= 0.0f ? -t : t;
+        n.y += n.y >= 0.0f ? -t : t;
+        return glm::normalize(n);
+    }
+
+    // round trip through an unsigned normalized channel with the given bit count,
+    // the same way the GL stores e * 0.5 + 0.5
+    inline glm::vec2 quantizeUnorm(glm::vec2 e, unsigned bits)
+    {
+        float maxValue = static_cast<float>((1u << bits) - 1u);
+        glm::vec2 unorm = glm::clamp(e * 0.5f + 0.5f, 0.0f, 1.0f);
+        return glm::round(unorm * maxValue) / maxValue * 2.0f - 1.0f;
+    }
+
+    inline glm::vec3 quantizeUnorm(glm::vec3 n, unsigned bits)
+    {
+        float maxValue = static_cast<float>((1u << bits) - 1u);
+        glm::vec3 unorm = glm::clamp(n * 0.5f + 0.5f, 0.0f, 1.0f);
+        return glm::round(unorm * maxValue) / maxValue * 2.0f - 1.0f;
+    }
+
+    // largest angle in degrees between a normal and its stored and decoded counterpart,
+    // sampled over a uniform latitude/longitude grid on the sphere
+    inline float maxNormalError(bool octahedral, unsigned bits, unsigned steps = 256)
+    {
+        const float pi = 3.14159265358979f;
+        float maxError = 0.0f;
+        for (unsigned i = 0; i <= steps; ++i)
+        {
+            float theta = pi * i / steps;
+            for (unsigned j = 0; j < 2 * steps; ++j)
+            {
+                float phi = pi * j / steps;
+                glm::vec3 n(std::sin(theta) * std::cos(phi), std::sin(theta) * std::sin(phi), std::cos(theta));
+
+                glm::vec3 decoded = octahedral
+                    ? octDecode(quantizeUnorm(octEncode(n), bits))
+                    : glm::normalize(quantizeUnorm(n, bits));
+
+                // atan2 stays precise for the tiny angles acos would round to zero
+                float angle = std::atan2(glm::length(glm::cross(n, decoded)), glm::dot(n, decoded));
+                maxError = glm::max(maxError, angle);
+            }
+        }
+        return maxError * 180.0f / pi;
+    }
+}
\ No newline at end of file
@@ -1,6 +1,7 @@
 #pragma once
 #include <glm/glm.hpp>
 
+#include <cstdint>
 #include <string>
 #include <iostream>
 #include <sstream>
@@ -10,9 +11,11 @@
 #include <memory>
 #include <iterator>
 
+#include "AllocationTracker.hpp"
 #include "Materials.hpp"
 #include "VertexData.hpp"
 #include "Mesh.hpp"
+#include "Profiler.hpp"
 
 namespace dc
 {
@@ -87,6 +90,12 @@ namespace dc
             return f;
         }
 
+        // exporters leave trailing spaces and \r line ends, which break file names on anything but Windows
+        void trim_right(std::string& str)
+        {
+            str.erase(str.find_last_not_of(" \t\r") + 1);
+        }
+
         inline bool starts_with(const std::string& input, const std::string& match)
         {
             return input.length() >= match.length() && (input.compare(0, match.length(), match) == 0);
@@ -98,12 +107,15 @@ namespace dc
     public:
         ObjLoader(const std::string& filePath, bool normalizeNormals = true)
         {
+            DC_PROFILE_ZONE("ObjLoader parse");
+            DC_ALLOCATION_SCOPE(Loader);
             std::ifstream objFile(filePath);
 
             std::string currentMaterial = "NO_MATERIAL";
             std::string line;
             while (std::getline(objFile, line))
             {
+                trim_right(line);
                 if (line.length() == 0)
                     continue;
                 size_t ind = line.find_first_of(" ");
@@ -118,10 +130,14 @@ namespace dc
                 else if (cmd == "usemtl")
                 {
                     currentMaterial = val;
+                    mPrimitives.push_back({ currentMaterial, mIndices[currentMaterial].size(), 0 });
                 }
                 else if (cmd == "f")
                 {
+                    if (mPrimitives.empty())
+                        mPrimitives.push_back({ currentMaterial, 0, 0 });
                     mIndices[currentMaterial].push_back(parse_face(val));
+                    ++mPrimitives.back().count;
                 }
                 else if (cmd == "vn")
                 {
@@ -149,15 +165,77 @@ namespace dc
 
         std::shared_ptr<dc::Mesh> exportMesh() const
         {
-            std::vector<unsigned> indices;
-            std::vector<dc::VertexData> vertexData;
-            std::vector<dc::IndexGroup> groups;
+            return std::make_shared<dc::Mesh>(exportMeshData());
+        }
+
+        // the GL free part of exportMesh, safe to call from any thread
+        dc::MeshData exportMeshData() const
+        {
+            return exportFaces(mIndices);
+        }
+
+        // silhouette candidates and creases for the geometry edge pass, which is the only
+        // user, see dc::Mesh::setFeatureEdges. Edges whose faces meet at a sharper angle are
+        // drawn as creases from every view. Safe to call from any thread
+        dc::FeatureEdges exportFeatureEdges(float creaseAngle = 20.0f) const
+        {
+            DC_PROFILE_FUNCTION();
+            DC_ALLOCATION_SCOPE(MeshExport);
+            // obj position indices of every triangle, for edge adjacency
+            std::vector<unsigned> triangles;
+            for (const auto& indexGroup : mIndices)
+            {
+                for (const auto& face : indexGroup.second)
+                {
+                    for (unsigned v : face.vertexIndices)
+                    {
+                        triangles.push_back(v - 1);
+                    }
+                }
+            }
+            return dc::buildFeatureEdges(mVertices, triangles, creaseAngle);
+        }
+
+        // one MeshData per usemtl statement, which Asset Forge writes for every placed block
+        std::vector<dc::MeshData> exportPrimitives() const
+        {
+            std::vector<dc::MeshData> primitives;
+            for (const auto& it : mPrimitives)
+            {
+                if (it.count == 0)
+                    continue;
+                const std::vector<dc::ObjFace>& faces = mIndices.at(it.material);
+                std::map<std::string, std::vector<dc::ObjFace>> subset;
+                subset[it.material].assign(faces.begin() + it.first, faces.begin() + it.first + it.count);
+                primitives.push_back(exportFaces(subset));
+            }
+            return primitives;
+        }
 
-            std::map<unsigned, unsigned> vertexMap;
+    private:
+        // faces of one usemtl statement, a range of mIndices[material]
+        struct Primitive
+        {
+            std::string material;
+            size_t first;
+            size_t count;
+        };
+
+        dc::MeshData exportFaces(const std::map<std::string, std::vector<ObjFace>>& materialFaces) const
+        {
+            DC_PROFILE_FUNCTION();
+            DC_ALLOCATION_SCOPE(MeshExport);
+            dc::MeshData data;
+            std::vector<unsigned>& indices = data.indices;
+            std::vector<dc::VertexData>& vertexData = data.vertices;
+            std::vector<dc::IndexGroup>& groups = data.groups;
 
-            for (auto indexGroup : mIndices)
+            // 64 bit keys, position times normal times texcoord counts overflows 32 bits on large models
+            std::map<uint64_t, unsigned> vertexMap;
+
+            for (const auto& indexGroup : materialFaces)
             {
-                std::vector<dc::ObjFace> faces = indexGroup.second;
+                const std::vector<dc::ObjFace>& faces = indexGroup.second;
                 unsigned offset = indices.size();
                 unsigned count = 0;
 
@@ -169,7 +247,7 @@ namespace dc
                         unsigned n = (face.normalIndices.size() > i) ? face.normalIndices[i] : 0;
                         unsigned t = (face.texCoordIndices.size() > i) ? face.texCoordIndices[i] : 0;
 
-                        unsigned key = v + n * mVertices.size() + t * mVertices.size() * mNormals.size();
+                        uint64_t key = v + n * static_cast<uint64_t>(mVertices.size() + 1) + t * static_cast<uint64_t>(mVertices.size() + 1) * (mNormals.size() + 1);
                         if (!vertexMap.count(key))
                         {
                             // add to output list
@@ -191,16 +269,15 @@ namespace dc
                 groups.push_back({ offset, count, mMaterials.at(indexGroup.first) });
             }
 
-            return std::make_shared<dc::Mesh>(vertexData, indices, groups);
+            return data;
         }
 
-    private:
-
         std::vector<glm::vec3> mVertices;
         std::vector<glm::vec3> mNormals;
         std::vector<glm::vec2> mTexCoords;
         std::map<std::string, std::vector<ObjFace>> mIndices;
         std::map<std::string, ObjMaterial> mMaterials;
+        std::vector<Primitive> mPrimitives;
 
         void parseMaterialFile(const std::string& filePath)
         {
@@ -211,6 +288,7 @@ namespace dc
             std::string line;
             while (std::getline(matFile, line))
             {
+                trim_right(line);
                 if (line.length() == 0)
                     continue;
                 size_t ind = line.find_first_of(" ");
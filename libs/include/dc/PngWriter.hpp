@@ -0,0 +1,252 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace dc
+{
+    namespace
+    {
+        // LSB first bit stream as deflate expects it
+        class DeflateBits
+        {
+        public:
+            explicit DeflateBits(std::vector<unsigned char>& out) : m_out(out) {}
+
+            void write(uint32_t value, unsigned count)
+            {
+                m_buffer |= value << m_count;
+                m_count += count;
+                while (m_count >= 8)
+                {
+                    m_out.push_back(static_cast<unsigned char>(m_buffer));
+                    m_buffer >>= 8;
+                    m_count -= 8;
+                }
+            }
+
+            // huffman codes are stored most significant bit first
+            void writeCode(uint32_t code, unsigned length)
+            {
+                uint32_t reversed = 0;
+                for (unsigned i = 0; i < length; ++i)
+                {
+                    reversed |= ((code >> i) & 1u) << (length - 1 - i);
+                }
+                write(reversed, length);
+            }
+
+            void flush()
+            {
+                if (m_count > 0)
+                    m_out.push_back(static_cast<unsigned char>(m_buffer));
+                m_buffer = 0;
+                m_count = 0;
+            }
+
+        private:
+            std::vector<unsigned char>& m_out;
+            uint32_t m_buffer = 0;
+            unsigned m_count = 0;
+        };
+
+        void writeFixedLiteral(DeflateBits& bits, unsigned symbol)
+        {
+            if (symbol < 144)
+                bits.writeCode(0x30 + symbol, 8);
+            else if (symbol < 256)
+                bits.writeCode(0x190 + symbol - 144, 9);
+            else if (symbol < 280)
+                bits.writeCode(symbol - 256, 7);
+            else
+                bits.writeCode(0xC0 + symbol - 280, 8);
+        }
+
+        void writeFixedMatch(DeflateBits& bits, unsigned length, unsigned distance)
+        {
+            static const unsigned lengthBase[] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+            static const unsigned lengthExtra[] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+            static const unsigned distanceBase[] = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+            static const unsigned distanceExtra[] = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+
+            unsigned l = 28;
+            while (lengthBase[l] > length)
+                --l;
+            writeFixedLiteral(bits, 257 + l);
+            bits.write(length - lengthBase[l], lengthExtra[l]);
+
+            unsigned d = 29;
+            while (distanceBase[d] > distance)
+                --d;
+            bits.writeCode(d, 5);
+            bits.write(distance - distanceBase[d], distanceExtra[d]);
+        }
+
+        // zlib stream with one fixed huffman block and greedy LZ77 matching
+        std::vector<unsigned char> zlibCompress(const std::vector<unsigned char>& data)
+        {
+            const unsigned window = 32768;
+            const unsigned maxMatch = 258;
+            const unsigned hashBits = 15;
+
+            std::vector<unsigned char> out = { 0x78, 0x01 };
+            DeflateBits bits(out);
+            bits.write(1, 1); // final block
+            bits.write(1, 2); // fixed huffman codes
+
+            std::vector<int> head(1u << hashBits, -1);
+            auto hash = [&](size_t i) { return ((data[i] << 10) ^ (data[i + 1] << 5) ^ data[i + 2]) & ((1u << hashBits) - 1); };
+
+            size_t i = 0;
+            while (i < data.size())
+            {
+                unsigned bestLength = 0;
+                if (i + 2 < data.size())
+                {
+                    unsigned h = hash(i);
+                    int candidate = head[h];
+                    head[h] = static_cast<int>(i);
+                    if (candidate >= 0 && i - candidate <= window)
+                    {
+                        size_t limit = std::min<size_t>(maxMatch, data.size() - i);
+                        while (bestLength < limit && data[candidate + bestLength] == data[i + bestLength])
+                            ++bestLength;
+                        if (bestLength >= 3)
+                        {
+                            writeFixedMatch(bits, bestLength, static_cast<unsigned>(i - candidate));
+                            // keep the hash current inside the match so later matches can start there
+                            for (size_t j = i + 1; j < i + bestLength && j + 2 < data.size(); ++j)
+                                head[hash(j)] = static_cast<int>(j);
+                            i += bestLength;
+                            continue;
+                        }
+                    }
+                }
+                writeFixedLiteral(bits, data[i]);
+                ++i;
+            }
+            writeFixedLiteral(bits, 256);
+            bits.flush();
+
+            uint32_t a = 1, b = 0;
+            for (unsigned char c : data)
+            {
+                a = (a + c) % 65521;
+                b = (b + a) % 65521;
+            }
+            uint32_t adler = (b << 16) | a;
+            for (int shift = 24; shift >= 0; shift -= 8)
+                out.push_back(static_cast<unsigned char>(adler >> shift));
+            return out;
+        }
+
+        uint32_t pngCrc(const unsigned char* data, size_t size, uint32_t crc = 0xFFFFFFFFu)
+        {
+            static const std::vector<uint32_t> table = []()
+            {
+                std::vector<uint32_t> entries(256);
+                for (uint32_t n = 0; n < 256; ++n)
+                {
+                    uint32_t c = n;
+                    for (int k = 0; k < 8; ++k)
+                        c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+                    entries[n] = c;
+                }
+                return entries;
+            }();
+            for (size_t i = 0; i < size; ++i)
+                crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+            return crc;
+        }
+
+        void pngChunk(std::vector<unsigned char>& png, const char* type, const std::vector<unsigned char>& data)
+        {
+            uint32_t size = static_cast<uint32_t>(data.size());
+            for (int shift = 24; shift >= 0; shift -= 8)
+                png.push_back(static_cast<unsigned char>(size >> shift));
+            size_t start = png.size();
+            png.insert(png.end(), type, type + 4);
+            png.insert(png.end(), data.begin(), data.end());
+            uint32_t crc = pngCrc(&png[start], png.size() - start) ^ 0xFFFFFFFFu;
+            for (int shift = 24; shift >= 0; shift -= 8)
+                png.push_back(static_cast<unsigned char>(crc >> shift));
+        }
+    }
+
+    // Encodes 8 bit RGB (channels = 3) or RGBA (channels = 4) pixels as PNG. Rows are
+    // expected top to bottom unless flipVertically is set, which takes glReadPixels order.
+    inline std::vector<unsigned char> encodePng(const unsigned char* pixels, unsigned width, unsigned height, unsigned channels, bool flipVertically = false)
+    {
+        size_t stride = static_cast<size_t>(width) * channels;
+
+        // every row gets the none, sub or up filter, whichever leaves the smallest residuals
+        std::vector<unsigned char> filtered;
+        filtered.reserve((stride + 1) * height);
+        std::vector<unsigned char> candidate[3];
+        for (unsigned y = 0; y < height; ++y)
+        {
+            const unsigned char* row = pixels + stride * (flipVertically ? height - 1 - y : y);
+            const unsigned char* above = y == 0 ? nullptr : pixels + stride * (flipVertically ? height - y : y - 1);
+
+            unsigned best = 0;
+            unsigned long bestCost = ~0ul;
+            for (unsigned filter = 0; filter < 3; ++filter)
+            {
+                candidate[filter].resize(stride);
+                unsigned long cost = 0;
+                for (size_t x = 0; x < stride; ++x)
+                {
+                    unsigned char left = x >= channels ? row[x - channels] : 0;
+                    unsigned char up = above ? above[x] : 0;
+                    unsigned char value = row[x] - (filter == 1 ? left : (filter == 2 ? up : 0));
+                    candidate[filter][x] = value;
+                    cost += std::abs(static_cast<signed char>(value));
+                }
+                if (cost < bestCost)
+                {
+                    bestCost = cost;
+                    best = filter;
+                }
+            }
+            filtered.push_back(static_cast<unsigned char>(best));
+            filtered.insert(filtered.end(), candidate[best].begin(), candidate[best].end());
+        }
+
+        std::vector<unsigned char> png = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+        std::vector<unsigned char> header;
+        for (uint32_t value : { width, height })
+        {
+            for (int shift = 24; shift >= 0; shift -= 8)
+                header.push_back(static_cast<unsigned char>(value >> shift));
+        }
+        header.push_back(8);
+        header.push_back(channels == 4 ? 6 : 2);
+        header.insert(header.end(), { 0, 0, 0 });
+
+        pngChunk(png, "IHDR", header);
+        pngChunk(png, "IDAT", zlibCompress(filtered));
+        pngChunk(png, "IEND", {});
+        return png;
+    }
+
+    inline bool writeFile(const std::string& path, const std::vector<unsigned char>& data)
+    {
+        std::ofstream file(path, std::ios::binary);
+        file.write(reinterpret_cast<const char*>(data.data()), data.size());
+        if (!file)
+        {
+            std::cout << "failed to write " << path << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    inline bool writePng(const std::string& path, const unsigned char* pixels, unsigned width, unsigned height, unsigned channels, bool flipVertically = false)
+    {
+        return writeFile(path, encodePng(pixels, width, height, channels, flipVertically));
+    }
+}
\ No newline at end of file
@@ -0,0 +1,401 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#define DC_PROFILE_TSC 1
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define DC_PROFILE_TSC 1
+#endif
+
+// zones are compiled into debug builds, release builds need DC_PROFILE=1
+#ifndef DC_PROFILE
+#ifdef NDEBUG
+#define DC_PROFILE 0
+#else
+#define DC_PROFILE 1
+#endif
+#endif
+
+namespace dc
+{
+    // Records nested CPU zones of every thread for a window of frames and writes them as a
+    // Chrome trace (chrome://tracing, ui.perfetto.dev). Each thread owns a ring of events
+    // it alone writes, so recording takes no lock; outside a capture a zone costs one
+    // relaxed load. Timestamps are TSC ticks, converted with the rate measured over the
+    // capture. Zone names must outlive the trace, string literals or __FUNCTION__. A ring
+    // gets its events on the first zone a thread records, threads that never record inside
+    // a capture cost only their name, and the ring of a thread that exited goes to the next
+    // new thread once a later capture started, so its zones still reach the trace. GPU spans
+    // from dc::GpuTimer go to a track of their own, in GL nanoseconds mapped onto the TSC
+    // through one pair of timestamps taken at the start of the capture.
+    class Profiler
+    {
+    public:
+        struct Event
+        {
+            const char* name;
+            uint64_t begin;
+            uint64_t end;
+        };
+
+        // events a thread keeps, older ones are overwritten
+        static const size_t RingSize = 1 << 16;
+
+        class ThreadRing
+        {
+        public:
+            ThreadRing(unsigned id)
+                : m_id(id)
+            {
+            }
+
+            void push(const char* name, uint64_t begin, uint64_t end)
+            {
+                // readers only look at the events once the release below made head non-zero
+                if (m_events.empty())
+                    m_events.resize(RingSize);
+                uint64_t head = m_head.load(std::memory_order_relaxed);
+                Event& event = m_events[head & (RingSize - 1)];
+                event.name = name;
+                event.begin = begin;
+                event.end = end;
+                m_head.store(head + 1, std::memory_order_release);
+            }
+
+            unsigned id() const { return m_id; }
+
+        private:
+            friend class Profiler;
+
+            unsigned m_id;
+            std::string m_name;
+            // begin and end are GL timestamps in nanoseconds
+            bool m_gpuClock = false;
+            std::vector<Event> m_events;
+            std::atomic<uint64_t> m_head{ 0 };
+        };
+
+        static Profiler& get()
+        {
+            static Profiler profiler;
+            return profiler;
+        }
+
+        static uint64_t ticks()
+        {
+#ifdef DC_PROFILE_TSC
+            return __rdtsc();
+#else
+            return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+        }
+
+        // the ring of the calling thread, registered on first use and released when the thread exits
+        ThreadRing& threadRing()
+        {
+            struct Owner
+            {
+                ThreadRing* ring = nullptr;
+
+                ~Owner()
+                {
+                    if (ring)
+                        Profiler::get().release(ring);
+                }
+            };
+            static thread_local Owner owner;
+            if (!owner.ring)
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                unsigned captures = m_captures.load(std::memory_order_relaxed);
+                for (size_t i = 0; i < m_freeRings.size() && !owner.ring; ++i)
+                {
+                    // a ring still holding zones of the last capture waits for the next one
+                    ThreadRing* ring = m_freeRings[i].ring;
+                    if (ring->m_head.load(std::memory_order_relaxed) != 0 && m_freeRings[i].capture == captures)
+                        continue;
+                    m_freeRings.erase(m_freeRings.begin() + i);
+                    ring->m_name.clear();
+                    ring->m_head.store(0, std::memory_order_relaxed);
+                    owner.ring = ring;
+                }
+                if (!owner.ring)
+                {
+                    m_rings.emplace_back(new ThreadRing(static_cast<unsigned>(m_rings.size())));
+                    owner.ring = m_rings.back().get();
+                }
+            }
+            return *owner.ring;
+        }
+
+        // names the calling thread in the trace
+        void nameThread(const std::string& name)
+        {
+            ThreadRing& ring = threadRing();
+            std::lock_guard<std::mutex> lock(m_mutex);
+            ring.m_name = name;
+        }
+
+        bool recording() const { return m_recording.load(std::memory_order_relaxed); }
+
+        // GL thread only: pairs a GL timestamp taken just now with the TSC
+        void calibrateGpu(int64_t gpuNanoseconds)
+        {
+            m_gpuTick = ticks();
+            m_gpuNanoseconds = gpuNanoseconds;
+            m_gpuCalibrated = true;
+        }
+
+        // whether GPU spans can be placed in the current or last capture
+        bool gpuCalibrated() const { return m_gpuCalibrated; }
+
+        // GL thread only, spans arrive frames after they ran
+        void pushGpu(const char* name, int64_t beginNanoseconds, int64_t endNanoseconds)
+        {
+            if (!m_gpuRing)
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_rings.emplace_back(new ThreadRing(static_cast<unsigned>(m_rings.size())));
+                m_gpuRing = m_rings.back().get();
+                m_gpuRing->m_name = "GPU";
+                m_gpuRing->m_gpuClock = true;
+            }
+            m_gpuRing->push(name, static_cast<uint64_t>(beginNanoseconds), static_cast<uint64_t>(endNanoseconds));
+        }
+
+        // records the next frames, starting at the next call to frame()
+        void capture(unsigned frames)
+        {
+            m_requestedFrames = frames;
+        }
+
+        bool captured() const { return m_captureEnd != 0; }
+
+        // marks the end of a frame, call from the thread that drives the frames
+        void frame()
+        {
+            uint64_t now = ticks();
+            if (m_recording.load(std::memory_order_relaxed))
+            {
+                threadRing().push("frame", m_lastFrame, now);
+                if (--m_remainingFrames == 0)
+                    stop(now);
+            }
+            else if (m_requestedFrames > 0)
+            {
+                m_remainingFrames = m_requestedFrames;
+                m_requestedFrames = 0;
+                m_captureBegin = now;
+                m_captureEnd = 0;
+                m_gpuCalibrated = false;
+                m_captureBeginTime = std::chrono::steady_clock::now();
+                m_captures.fetch_add(1, std::memory_order_relaxed);
+                m_recording.store(true, std::memory_order_relaxed);
+            }
+            m_lastFrame = now;
+        }
+
+        // ends a capture before its frames are done
+        void stop()
+        {
+            if (m_recording.load(std::memory_order_relaxed))
+                stop(ticks());
+        }
+
+        double ticksPerMicrosecond() const { return m_ticksPerMicrosecond; }
+
+        // writes the zones of the last capture that ended, call once the threads left them
+        bool writeChromeTrace(const std::string& path)
+        {
+            if (!captured())
+            {
+                std::cout << "no profiler capture to write" << std::endl;
+                return false;
+            }
+            std::ofstream file(path);
+            // microseconds, fixed so long captures keep their nanoseconds
+            file << std::fixed << std::setprecision(3) << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+            bool first = true;
+            std::lock_guard<std::mutex> lock(m_mutex);
+            for (const auto& ring : m_rings)
+            {
+                if (!ring->m_name.empty())
+                {
+                    file << (first ? "" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << ring->m_id
+                        << ",\"args\":{\"name\":\"" << escape(ring->m_name) << "\"}}";
+                    first = false;
+                }
+                uint64_t head = ring->m_head.load(std::memory_order_acquire);
+                uint64_t oldest = head > RingSize ? head - RingSize : 0;
+                for (uint64_t i = oldest; i < head; ++i)
+                {
+                    uint64_t begin, end;
+                    const Event& event = ring->m_events[i & (RingSize - 1)];
+                    if (!inCapture(*ring, event, begin, end))
+                        continue;
+                    file << (first ? "" : ",\n") << "{\"name\":\"" << escape(event.name) << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << ring->m_id
+                        << ",\"ts\":" << microseconds(begin) << ",\"dur\":" << (end - begin) / m_ticksPerMicrosecond << "}";
+                    first = false;
+                }
+            }
+            file << "\n]}\n";
+            if (!file)
+            {
+                std::cout << "failed to write " << path << std::endl;
+                return false;
+            }
+            return true;
+        }
+
+        // zones of the last capture per name, summed over every thread
+        size_t eventCount(const std::string& name)
+        {
+            size_t count = 0;
+            std::lock_guard<std::mutex> lock(m_mutex);
+            for (const auto& ring : m_rings)
+            {
+                uint64_t head = ring->m_head.load(std::memory_order_acquire);
+                for (uint64_t i = head > RingSize ? head - RingSize : 0; i < head; ++i)
+                {
+                    uint64_t begin, end;
+                    const Event& event = ring->m_events[i & (RingSize - 1)];
+                    if (inCapture(*ring, event, begin, end) && name == event.name)
+                        ++count;
+                }
+            }
+            return count;
+        }
+
+    private:
+        std::mutex m_mutex;
+        std::vector<std::unique_ptr<ThreadRing>> m_rings;
+        // rings of threads that exited, with the number of captures started by then
+        struct FreeRing
+        {
+            ThreadRing* ring;
+            unsigned capture;
+        };
+        std::vector<FreeRing> m_freeRings;
+        std::atomic<bool> m_recording{ false };
+        std::atomic<unsigned> m_captures{ 0 };
+        unsigned m_requestedFrames = 0;
+        unsigned m_remainingFrames = 0;
+        uint64_t m_lastFrame = 0;
+        uint64_t m_captureBegin = 0;
+        uint64_t m_captureEnd = 0;
+        std::chrono::steady_clock::time_point m_captureBeginTime;
+        double m_ticksPerMicrosecond = 1.0;
+        ThreadRing* m_gpuRing = nullptr;
+        bool m_gpuCalibrated = false;
+        uint64_t m_gpuTick = 0;
+        int64_t m_gpuNanoseconds = 0;
+
+        Profiler() = default;
+
+        void release(ThreadRing* ring)
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_freeRings.push_back({ ring, m_captures.load(std::memory_order_relaxed) });
+        }
+
+        void stop(uint64_t now)
+        {
+            m_recording.store(false, std::memory_order_relaxed);
+            m_captureEnd = now;
+            double elapsed = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - m_captureBeginTime).count();
+            if (elapsed > 0.0 && m_captureEnd > m_captureBegin)
+                m_ticksPerMicrosecond = (m_captureEnd - m_captureBegin) / elapsed;
+        }
+
+        // the span of event in ticks, if it lies within the last capture
+        bool inCapture(const ThreadRing& ring, const Event& event, uint64_t& begin, uint64_t& end) const
+        {
+            begin = event.begin;
+            end = event.end;
+            if (ring.m_gpuClock)
+            {
+                if (!m_gpuCalibrated)
+                    return false;
+                double ticksPerNanosecond = m_ticksPerMicrosecond / 1000.0;
+                double gpuBegin = m_gpuTick + (static_cast<int64_t>(event.begin) - m_gpuNanoseconds) * ticksPerNanosecond;
+                double gpuEnd = m_gpuTick + (static_cast<int64_t>(event.end) - m_gpuNanoseconds) * ticksPerNanosecond;
+                if (gpuBegin < 0.0)
+                    return false;
+                begin = static_cast<uint64_t>(gpuBegin);
+                end = static_cast<uint64_t>(gpuEnd);
+                // the GPU finishes the last frames after the capture ended
+                return begin >= m_captureBegin && begin <= m_captureEnd;
+            }
+            return begin >= m_captureBegin && end <= m_captureEnd;
+        }
+
+        double microseconds(uint64_t tick) const
+        {
+            return (tick - m_captureBegin) / m_ticksPerMicrosecond;
+        }
+
+        static std::string escape(const std::string& s)
+        {
+            std::string escaped;
+            for (char c : s)
+            {
+                if (c == '"' || c == '\\')
+                    escaped += '\\';
+                escaped += c;
+            }
+            return escaped;
+        }
+    };
+
+    // times its scope into the ring of the current thread while the profiler records
+    class ProfileZone
+    {
+    public:
+        explicit ProfileZone(const char* name)
+            : m_name(Profiler::get().recording() ? name : nullptr)
+        {
+            if (m_name)
+                m_begin = Profiler::ticks();
+        }
+
+        ~ProfileZone()
+        {
+            if (m_name)
+                Profiler::get().threadRing().push(m_name, m_begin, Profiler::ticks());
+        }
+
+        ProfileZone(const ProfileZone& other) = delete;
+        ProfileZone& operator=(const ProfileZone& other) = delete;
+
+    private:
+        const char* m_name;
+        uint64_t m_begin = 0;
+    };
+}
+
+#define DC_PROFILE_CONCAT_(a, b) a##b
+#define DC_PROFILE_CONCAT(a, b) DC_PROFILE_CONCAT_(a, b)
+
+#if DC_PROFILE
+#define DC_PROFILE_ZONE(name) dc::ProfileZone DC_PROFILE_CONCAT(profileZone, __LINE__)(name)
+#define DC_PROFILE_FUNCTION() DC_PROFILE_ZONE(__FUNCTION__)
+#define DC_PROFILE_FRAME() dc::Profiler::get().frame()
+#define DC_PROFILE_THREAD(name) dc::Profiler::get().nameThread(name)
+#else
+#define DC_PROFILE_ZONE(name)
+#define DC_PROFILE_FUNCTION()
+#define DC_PROFILE_FRAME()
+#define DC_PROFILE_THREAD(name)
+#endif
\ No newline at end of file
@@ -0,0 +1,78 @@
+#pragma once
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace dc
+{
+    // What the dc:: classes submitted to the GL during one frame. Shader setters, Mesh
+    // draws, Texture and FrameBuffer binds and Buffer uploads count into renderStats(),
+    // plain increments on the GL thread, and endRenderStatsFrame() hands out the totals.
+    // Code calling the GL directly counts only where it matters, like the line uploads of
+    // GeometryEdges; the post process quad is not counted.
+    struct RenderStats
+    {
+        uint64_t drawCalls = 0;
+        uint64_t triangles = 0;
+        uint64_t programBinds = 0;
+        uint64_t uniforms = 0;
+        uint64_t textureBinds = 0;
+        uint64_t framebufferBinds = 0;
+        uint64_t bufferUploads = 0;
+        uint64_t bufferBytes = 0;
+
+        static std::vector<std::string> columns()
+        {
+            return { "draw_calls", "triangles", "program_binds", "uniforms", "texture_binds", "framebuffer_binds", "buffer_uploads", "buffer_bytes" };
+        }
+
+        std::vector<uint64_t> values() const
+        {
+            return { drawCalls, triangles, programBinds, uniforms, textureBinds, framebufferBinds, bufferUploads, bufferBytes };
+        }
+    };
+
+    // counts of the frame in progress, GL thread only
+    inline RenderStats& renderStats()
+    {
+        static RenderStats stats;
+        return stats;
+    }
+
+    // the counts since the last call, which start over
+    inline RenderStats endRenderStatsFrame()
+    {
+        RenderStats frame = renderStats();
+        renderStats() = RenderStats();
+        return frame;
+    }
+
+    // one row per frame
+    inline bool writeRenderStatsCsv(const std::string& path, const std::vector<RenderStats>& frames)
+    {
+        std::ofstream file(path);
+        file << "frame";
+        for (const auto& it : RenderStats::columns())
+        {
+            file << "," << it;
+        }
+        file << "\n";
+        for (size_t i = 0; i < frames.size(); ++i)
+        {
+            file << i;
+            for (uint64_t value : frames[i].values())
+            {
+                file << "," << value;
+            }
+            file << "\n";
+        }
+        if (!file)
+        {
+            std::cout << "failed to write " << path << std::endl;
+            return false;
+        }
+        return true;
+    }
+}
\ No newline at end of file
@@ -1,12 +1,20 @@
 #pragma once
 
 #include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include "AllocationTracker.hpp"
+#include "GLExtensions.hpp"
+#include "GpuResources.hpp"
+#include "RenderStats.hpp"
 
 #include <string>
 #include <fstream>
 #include <sstream>
 #include <iostream>
 #include <vector>
+#include <stdexcept>
 
 namespace dc
 {
@@ -14,7 +22,9 @@ namespace dc
     {
         Vertex,
         Geometry,
-        Fragment
+        Fragment,
+        // needs a GL 4.3 context, see dc::loadGL43
+        Compute
     };
 
     class Shader
@@ -26,22 +36,29 @@ namespace dc
             std::string path;
         };
 
-        Shader(const std::vector<ShaderStageDef>& stages)
+        // defines are injected right after the #version line of every stage
+        Shader(const std::vector<ShaderStageDef>& stages, const std::vector<std::string>& defines = {})
         {
             m_stages = stages;
+            m_defines = defines;
             reload();
         }
 
         ~Shader()
         {
+            if (m_id == 0)
+                return;
+            GpuResources::get().remove(GpuResourceType::Program, m_id);
             glDeleteProgram(m_id);
         }
 
         Shader(const Shader& other) = delete;
         Shader& operator=(const Shader& other) = delete;
 
+        // keeps the current program when a stage fails to compile or the program to link
         void reload()
         {
+            DC_ALLOCATION_SCOPE(Shader);
             std::vector<GLuint> shaderIDs;
 
             for (const auto& it : m_stages)
@@ -64,54 +81,78 @@ namespace dc
                 glAttachShader(pid, it);
             }
             glLinkProgram(pid);
-            checkErrors(pid, "program");
+            bool failed = checkErrors(pid, "program");
             for (const auto& ids : shaderIDs)
             {
                 glDeleteShader(ids);
             }
+            if (failed)
+            {
+                glDeleteProgram(pid);
+                return;
+            }
+            if (m_id != 0)
+            {
+                GpuResources::get().remove(GpuResourceType::Program, m_id);
+                glDeleteProgram(m_id);
+            }
             m_id = pid;
+            std::string files;
+            for (const auto& it : m_stages)
+            {
+                files += (files.empty() ? "" : " ") + it.path;
+            }
+            GpuResources::get().add(GpuResourceType::Program, m_id, 0, files);
         }
 
         void use() const
         {
+            ++renderStats().programBinds;
             glUseProgram(m_id);
         }
 
-        void setInt(const std::string& name, int value) const
+        // names are plain C strings, a std::string per call would allocate for long names
+        void setInt(const char* name, int value) const
         {
-            glUniform1i(glGetUniformLocation(m_id, name.c_str()), value);
+            ++renderStats().uniforms;
+            glUniform1i(glGetUniformLocation(m_id, name), value);
         }
 
-        void setFloat(const std::string& name, float value) const
+        void setFloat(const char* name, float value) const
         {
-            glUniform1f(glGetUniformLocation(m_id, name.c_str()), value);
+            ++renderStats().uniforms;
+            glUniform1f(glGetUniformLocation(m_id, name), value);
         }
 
-        void setVec3(const std::string& name, const glm::vec3& vec) const
+        void setVec3(const char* name, const glm::vec3& vec) const
         {
-            glUniform3f(glGetUniformLocation(m_id, name.c_str()), vec.x, vec.y, vec.z);
+            ++renderStats().uniforms;
+            glUniform3f(glGetUniformLocation(m_id, name), vec.x, vec.y, vec.z);
         }
 
-        void setMat4(const std::string& name, const glm::mat4& mat) const
+        void setMat4(const char* name, const glm::mat4& mat) const
         {
-            glUniformMatrix4fv(glGetUniformLocation(m_id, name.c_str()), 1, false, glm::value_ptr(mat));
+            ++renderStats().uniforms;
+            glUniformMatrix4fv(glGetUniformLocation(m_id, name), 1, false, glm::value_ptr(mat));
         }
 
     private:
         std::vector<ShaderStageDef> m_stages;
-        GLuint m_id;
+        std::vector<std::string> m_defines;
+        // 0 until a program linked
+        GLuint m_id = 0;
 
         bool compileShaderSource(const ShaderStageDef& ssd, GLuint& sid)
         {
-            GLuint shaderTypes[] = {GL_VERTEX_SHADER, GL_GEOMETRY_SHADER, GL_FRAGMENT_SHADER};
+            GLuint shaderTypes[] = {GL_VERTEX_SHADER, GL_GEOMETRY_SHADER, GL_FRAGMENT_SHADER, GL_COMPUTE_SHADER};
 
             GLuint id = glCreateShader(shaderTypes[ssd.stage]);
-            std::string source = loadSource(ssd.path);
+            std::string source = injectDefines(loadSource(ssd.path));
             const char* code = source.c_str();
             glShaderSource(id, 1, &code, NULL);
             glCompileShader(id);
 
-            std::string stageNames[] = {"vertex", "geometry", "fragment"};
+            std::string stageNames[] = {"vertex", "geometry", "fragment", "compute"};
             if (checkErrors(id, stageNames[ssd.stage]))
             {
                 glDeleteShader(id);
@@ -121,7 +162,36 @@ namespace dc
             return true;
         }
 
-        std::string loadSource(const std::string& path)
+        // resolves #include "file" lines relative to the including file
+        std::string loadSource(const std::string& path, unsigned depth = 0)
+        {
+            if (depth > 8)
+                throw std::runtime_error("shader include depth exceeded at " + path);
+
+            std::string dir = path.substr(0, path.find_last_of('/') + 1);
+            std::istringstream lines(readFile(path));
+            std::string source;
+            std::string line;
+            while (std::getline(lines, line))
+            {
+                if (line.compare(0, 8, "#include") == 0)
+                {
+                    size_t begin = line.find('"');
+                    size_t end = line.find('"', begin + 1);
+                    if (begin == std::string::npos || end == std::string::npos)
+                        throw std::runtime_error("malformed include in " + path + ": " + line);
+                    source += loadSource(dir + line.substr(begin + 1, end - begin - 1), depth + 1);
+                }
+                else
+                {
+                    source += line;
+                }
+                source += "\n";
+            }
+            return source;
+        }
+
+        std::string readFile(const std::string& path)
         {
             std::string source;
             std::ifstream file;
@@ -140,6 +210,26 @@ namespace dc
             }
         }
 
+        std::string injectDefines(const std::string& source) const
+        {
+            if (m_defines.empty())
+                return source;
+
+            std::string defines;
+            for (const auto& it : m_defines)
+            {
+                defines += "#define " + it + "\n";
+            }
+
+            size_t versionEnd = 0;
+            if (source.compare(0, 8, "#version") == 0)
+            {
+                versionEnd = source.find('\n');
+                versionEnd = (versionEnd == std::string::npos) ? source.length() : versionEnd + 1;
+            }
+            return source.substr(0, versionEnd) + defines + source.substr(versionEnd);
+        }
+
         bool checkErrors(GLuint shader, std::string type)
         {
             int success;
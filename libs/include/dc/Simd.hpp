@@ -0,0 +1,157 @@
+#pragma once
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+// SSE2 is part of every x64 target, 32 bit MSVC builds need /arch:SSE2
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define DC_SSE2 1
+#include <emmintrin.h>
+#endif
+
+// AVX2 only when the whole build targets it (/arch:AVX2, -mavx2), there is no runtime dispatch
+#if defined(__AVX2__)
+#define DC_AVX2 1
+#include <immintrin.h>
+#endif
+
+namespace dc
+{
+    // Thin wrappers over one, four and eight float lanes with the same interface, so a
+    // kernel written once as a template compiles to scalar, SSE2 and AVX2 code. Masks
+    // come from comparisons and are only consumed by select().
+    namespace simd
+    {
+        struct Float1
+        {
+            static const unsigned Width = 1;
+            typedef bool Mask;
+
+            float v;
+
+            Float1() = default;
+            Float1(float value) : v(value) {}
+
+            static Float1 load(const float* p) { return p[0]; }
+            void store(float* p) const { p[0] = v; }
+            // lane indices 0, 1, 2, ...
+            static Float1 ramp() { return 0.0f; }
+            // (p[i] >> shift) & 0xFF of each packed word
+            static Float1 unpackByte(const uint32_t* p, unsigned shift) { return static_cast<float>((p[0] >> shift) & 0xFF); }
+        };
+
+        inline Float1 operator+(Float1 a, Float1 b) { return a.v + b.v; }
+        inline Float1 operator-(Float1 a, Float1 b) { return a.v - b.v; }
+        inline Float1 operator*(Float1 a, Float1 b) { return a.v * b.v; }
+        inline Float1 operator/(Float1 a, Float1 b) { return a.v / b.v; }
+        inline bool operator>=(Float1 a, Float1 b) { return a.v >= b.v; }
+        inline Float1 select(bool mask, Float1 a, Float1 b) { return mask ? a : b; }
+        // one bit per lane, lane 0 lowest
+        inline unsigned bits(bool mask) { return mask ? 1u : 0u; }
+        inline Float1 min(Float1 a, Float1 b) { return a.v < b.v ? a : b; }
+        inline Float1 max(Float1 a, Float1 b) { return a.v > b.v ? a : b; }
+        inline Float1 sqrt(Float1 a) { return std::sqrt(a.v); }
+        inline Float1 abs(Float1 a) { return std::fabs(a.v); }
+
+        // r, g, b in 0 - 255, written as RGBA8 with opaque alpha, rounded to nearest
+        inline void storeRgba(unsigned char* out, Float1 r, Float1 g, Float1 b)
+        {
+            out[0] = static_cast<unsigned char>(r.v + 0.5f);
+            out[1] = static_cast<unsigned char>(g.v + 0.5f);
+            out[2] = static_cast<unsigned char>(b.v + 0.5f);
+            out[3] = 255;
+        }
+
+#ifdef DC_SSE2
+        struct Float4
+        {
+            static const unsigned Width = 4;
+            struct Mask { __m128 m; };
+
+            __m128 v;
+
+            Float4() = default;
+            Float4(float value) : v(_mm_set1_ps(value)) {}
+            Float4(__m128 value) : v(value) {}
+
+            static Float4 load(const float* p) { return _mm_loadu_ps(p); }
+            void store(float* p) const { _mm_storeu_ps(p, v); }
+            static Float4 ramp() { return _mm_set_ps(3.0f, 2.0f, 1.0f, 0.0f); }
+            static Float4 unpackByte(const uint32_t* p, unsigned shift)
+            {
+                __m128i words = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+                return _mm_cvtepi32_ps(_mm_and_si128(_mm_srl_epi32(words, _mm_cvtsi32_si128(shift)), _mm_set1_epi32(0xFF)));
+            }
+        };
+
+        inline Float4 operator+(Float4 a, Float4 b) { return _mm_add_ps(a.v, b.v); }
+        inline Float4 operator-(Float4 a, Float4 b) { return _mm_sub_ps(a.v, b.v); }
+        inline Float4 operator*(Float4 a, Float4 b) { return _mm_mul_ps(a.v, b.v); }
+        inline Float4 operator/(Float4 a, Float4 b) { return _mm_div_ps(a.v, b.v); }
+        inline Float4::Mask operator>=(Float4 a, Float4 b) { return { _mm_cmpge_ps(a.v, b.v) }; }
+        inline Float4::Mask operator&(Float4::Mask a, Float4::Mask b) { return { _mm_and_ps(a.m, b.m) }; }
+        inline Float4 select(Float4::Mask mask, Float4 a, Float4 b) { return _mm_or_ps(_mm_and_ps(mask.m, a.v), _mm_andnot_ps(mask.m, b.v)); }
+        inline unsigned bits(Float4::Mask mask) { return static_cast<unsigned>(_mm_movemask_ps(mask.m)); }
+        inline Float4 min(Float4 a, Float4 b) { return _mm_min_ps(a.v, b.v); }
+        inline Float4 max(Float4 a, Float4 b) { return _mm_max_ps(a.v, b.v); }
+        inline Float4 sqrt(Float4 a) { return _mm_sqrt_ps(a.v); }
+        inline Float4 abs(Float4 a) { return _mm_andnot_ps(_mm_set1_ps(-0.0f), a.v); }
+
+        inline void storeRgba(unsigned char* out, Float4 r, Float4 g, Float4 b)
+        {
+            const __m128 half = _mm_set1_ps(0.5f);
+            __m128i ri = _mm_cvttps_epi32(_mm_add_ps(r.v, half));
+            __m128i gi = _mm_cvttps_epi32(_mm_add_ps(g.v, half));
+            __m128i bi = _mm_cvttps_epi32(_mm_add_ps(b.v, half));
+            __m128i rgba = _mm_or_si128(_mm_or_si128(ri, _mm_slli_epi32(gi, 8)), _mm_or_si128(_mm_slli_epi32(bi, 16), _mm_set1_epi32(static_cast<int>(0xFF000000u))));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out), rgba);
+        }
+#endif
+
+#ifdef DC_AVX2
+        struct Float8
+        {
+            static const unsigned Width = 8;
+            struct Mask { __m256 m; };
+
+            __m256 v;
+
+            Float8() = default;
+            Float8(float value) : v(_mm256_set1_ps(value)) {}
+            Float8(__m256 value) : v(value) {}
+
+            static Float8 load(const float* p) { return _mm256_loadu_ps(p); }
+            void store(float* p) const { _mm256_storeu_ps(p, v); }
+            static Float8 ramp() { return _mm256_set_ps(7.0f, 6.0f, 5.0f, 4.0f, 3.0f, 2.0f, 1.0f, 0.0f); }
+            static Float8 unpackByte(const uint32_t* p, unsigned shift)
+            {
+                __m256i words = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+                return _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srl_epi32(words, _mm_cvtsi32_si128(shift)), _mm256_set1_epi32(0xFF)));
+            }
+        };
+
+        inline Float8 operator+(Float8 a, Float8 b) { return _mm256_add_ps(a.v, b.v); }
+        inline Float8 operator-(Float8 a, Float8 b) { return _mm256_sub_ps(a.v, b.v); }
+        inline Float8 operator*(Float8 a, Float8 b) { return _mm256_mul_ps(a.v, b.v); }
+        inline Float8 operator/(Float8 a, Float8 b) { return _mm256_div_ps(a.v, b.v); }
+        inline Float8::Mask operator>=(Float8 a, Float8 b) { return { _mm256_cmp_ps(a.v, b.v, _CMP_GE_OQ) }; }
+        inline Float8::Mask operator&(Float8::Mask a, Float8::Mask b) { return { _mm256_and_ps(a.m, b.m) }; }
+        inline Float8 select(Float8::Mask mask, Float8 a, Float8 b) { return _mm256_blendv_ps(b.v, a.v, mask.m); }
+        inline unsigned bits(Float8::Mask mask) { return static_cast<unsigned>(_mm256_movemask_ps(mask.m)); }
+        inline Float8 min(Float8 a, Float8 b) { return _mm256_min_ps(a.v, b.v); }
+        inline Float8 max(Float8 a, Float8 b) { return _mm256_max_ps(a.v, b.v); }
+        inline Float8 sqrt(Float8 a) { return _mm256_sqrt_ps(a.v); }
+        inline Float8 abs(Float8 a) { return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), a.v); }
+
+        inline void storeRgba(unsigned char* out, Float8 r, Float8 g, Float8 b)
+        {
+            const __m256 half = _mm256_set1_ps(0.5f);
+            __m256i ri = _mm256_cvttps_epi32(_mm256_add_ps(r.v, half));
+            __m256i gi = _mm256_cvttps_epi32(_mm256_add_ps(g.v, half));
+            __m256i bi = _mm256_cvttps_epi32(_mm256_add_ps(b.v, half));
+            __m256i rgba = _mm256_or_si256(_mm256_or_si256(ri, _mm256_slli_epi32(gi, 8)), _mm256_or_si256(_mm256_slli_epi32(bi, 16), _mm256_set1_epi32(static_cast<int>(0xFF000000u))));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(out), rgba);
+        }
+#endif
+    }
+}
\ No newline at end of file
@@ -4,6 +4,10 @@
 #define STB_IMAGE_IMPLEMENTATION
 #include <stb_image.h>
 
+#include "GpuResources.hpp"
+#include "RenderStats.hpp"
+
+#include <algorithm>
 #include <string>
 #include <iostream>
 
@@ -27,22 +31,70 @@ namespace dc
         RGB8,
         RGBA8,
         Depth24,
-        Depth24Stencil8
+        Depth24Stencil8,
+        RG8,
+        RG16,
+        RGB10A2,
+        R16UI,
+        R8,
+        RG16UI,
+        R32F
     };
 
+    struct TextureFormatDesc
+    {
+        GLint internalFormat;
+        GLenum format;
+        GLenum type;
+        // bytes per texel as stored by the driver, RGB8 and Depth24 are padded to 32 bits
+        unsigned bytesPerPixel;
+        bool integer;
+    };
+
+    inline const TextureFormatDesc& formatDesc(TextureFormat format)
+    {
+        static const TextureFormatDesc descs[] = {
+            { GL_RGB8, GL_RGB, GL_UNSIGNED_BYTE, 4, false },
+            { GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE, 4, false },
+            { GL_DEPTH_COMPONENT24, GL_DEPTH_COMPONENT, GL_FLOAT, 4, false },
+            { GL_DEPTH24_STENCIL8, GL_DEPTH_STENCIL, GL_UNSIGNED_INT_24_8, 4, false },
+            { GL_RG8, GL_RG, GL_UNSIGNED_BYTE, 2, false },
+            { GL_RG16, GL_RG, GL_UNSIGNED_SHORT, 4, false },
+            { GL_RGB10_A2, GL_RGBA, GL_UNSIGNED_INT_2_10_10_10_REV, 4, false },
+            { GL_R16UI, GL_RED_INTEGER, GL_UNSIGNED_SHORT, 2, true },
+            { GL_R8, GL_RED, GL_UNSIGNED_BYTE, 1, false },
+            { GL_RG16UI, GL_RG_INTEGER, GL_UNSIGNED_SHORT, 4, true },
+            { GL_R32F, GL_RED, GL_FLOAT, 4, false }
+        };
+        return descs[format];
+    }
+
     class Texture
     {
     public:
-        Texture(unsigned width, unsigned height, TextureFormat format, TextureWrap wrap, TextureFilter filter)
-            : m_width(width), m_height(height)
+        // levels above 1 allocate a mip chain, every level half the size of the one before rounded down
+        Texture(unsigned width, unsigned height, TextureFormat format, TextureWrap wrap, TextureFilter filter, unsigned levels = 1)
+            : m_width(width), m_height(height), m_levels(levels)
         {
             glGenTextures(1, &m_id);
             bind();
             setParameters(wrap, filter);
-            GLint internalFormats[] = {GL_RGB8, GL_RGBA8, GL_DEPTH_COMPONENT24, GL_DEPTH24_STENCIL8};
-            GLint formats[] = {GL_RGB, GL_RGBA, GL_DEPTH_COMPONENT, GL_DEPTH_STENCIL};
-            GLenum types[] = {GL_UNSIGNED_BYTE, GL_UNSIGNED_BYTE, GL_FLOAT, GL_FLOAT};
-            glTexImage2D(GL_TEXTURE_2D, 0, internalFormats[format], m_width, m_height, 0, formats[format], types[format], NULL);
+            const TextureFormatDesc& desc = formatDesc(format);
+            size_t bytes = 0;
+            for (unsigned level = 0; level < m_levels; ++level)
+            {
+                GLsizei w = std::max(m_width >> level, 1u);
+                GLsizei h = std::max(m_height >> level, 1u);
+                glTexImage2D(GL_TEXTURE_2D, level, desc.internalFormat, w, h, 0, desc.format, desc.type, NULL);
+                bytes += static_cast<size_t>(w) * h * desc.bytesPerPixel;
+            }
+            GpuResources::get().add(GpuResourceType::Texture, m_id, bytes, std::to_string(m_width) + "x" + std::to_string(m_height)
+                + ", " + std::to_string(desc.bytesPerPixel) + " bytes per texel, " + std::to_string(m_levels) + " levels");
+            if (m_levels > 1)
+            {
+                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, m_levels - 1);
+                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, filter == Nearest ? GL_NEAREST_MIPMAP_NEAREST : GL_LINEAR_MIPMAP_LINEAR);
+            }
             unbind();
         }
 
@@ -76,12 +128,14 @@ namespace dc
             m_height = height;
             glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, format, GL_UNSIGNED_BYTE, data);
             unbind();
+            GpuResources::get().add(GpuResourceType::Texture, m_id, static_cast<size_t>(width) * height * 4, path);
 
             stbi_image_free(data);
         }
 
         ~Texture()
         {
+            GpuResources::get().remove(GpuResourceType::Texture, m_id);
             glDeleteTextures(1, &m_id);
         }
 
@@ -90,6 +144,7 @@ namespace dc
 
         void bind() const
         {
+            ++renderStats().textureBinds;
             glBindTexture(GL_TEXTURE_2D, m_id);
         }
 
@@ -99,6 +154,9 @@ namespace dc
         }
 
         GLuint id() const { return m_id; }
+        unsigned width() const { return m_width; }
+        unsigned height() const { return m_height; }
+        unsigned levels() const { return m_levels; }
 
         void setParameters(TextureWrap wrap, TextureFilter filter)
         {
@@ -111,8 +169,10 @@ namespace dc
         }
 
     private:
-        GLuint m_id;
-        unsigned m_width;
-        unsigned m_height;
+        // stays 0 when loading from a file fails
+        GLuint m_id = 0;
+        unsigned m_width = 0;
+        unsigned m_height = 0;
+        unsigned m_levels = 1;
     };
 }
\ No newline at end of file
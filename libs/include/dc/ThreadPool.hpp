@@ -0,0 +1,99 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "BlockingQueue.hpp"
+#include "Profiler.hpp"
+
+namespace dc
+{
+    // Fixed set of worker threads running submitted tasks in order. The task queue is
+    // bounded, so submit() blocks when the workers fall behind.
+    class ThreadPool
+    {
+    public:
+        explicit ThreadPool(unsigned threads, size_t queueCapacity = 64)
+            : m_tasks(queueCapacity)
+        {
+            threads = threads > 0 ? threads : 1;
+            for (unsigned i = 0; i < threads; ++i)
+            {
+                m_threads.emplace_back([this]()
+                {
+                    DC_PROFILE_THREAD("pool worker");
+                    std::function<void()> task;
+                    while (m_tasks.pop(task))
+                    {
+                        DC_PROFILE_ZONE("task");
+                        task();
+                    }
+                });
+            }
+        }
+
+        // runs the tasks still queued, then joins
+        ~ThreadPool()
+        {
+            m_tasks.close();
+            for (auto& it : m_threads)
+            {
+                it.join();
+            }
+        }
+
+        ThreadPool(const ThreadPool& other) = delete;
+        ThreadPool& operator=(const ThreadPool& other) = delete;
+
+        void submit(std::function<void()> task)
+        {
+            m_tasks.push(std::move(task));
+        }
+
+        // runs body(0) ... body(count - 1) on the workers and returns when all are done.
+        // Indices are handed out one at a time, so uneven work balances itself. Must not be
+        // called from a task of the same pool.
+        void parallelFor(size_t count, const std::function<void(size_t)>& body)
+        {
+            if (count == 0)
+                return;
+
+            std::atomic<size_t> next(0);
+            unsigned tasks = static_cast<unsigned>(count < m_threads.size() ? count : m_threads.size());
+            unsigned running = tasks;
+            std::mutex mutex;
+            std::condition_variable done;
+            for (unsigned i = 0; i < tasks; ++i)
+            {
+                submit([&]()
+                {
+                    for (size_t index = next++; index < count; index = next++)
+                    {
+                        body(index);
+                    }
+                    std::lock_guard<std::mutex> lock(mutex);
+                    if (--running == 0)
+                        done.notify_one();
+                });
+            }
+            std::unique_lock<std::mutex> lock(mutex);
+            done.wait(lock, [&]() { return running == 0; });
+        }
+
+        unsigned size() const { return static_cast<unsigned>(m_threads.size()); }
+
+        // hardware threads, at least 1
+        static unsigned hardwareThreads()
+        {
+            unsigned threads = std::thread::hardware_concurrency();
+            return threads > 0 ? threads : 1;
+        }
+
+    private:
+        BlockingQueue<std::function<void()>> m_tasks;
+        std::vector<std::thread> m_threads;
+    };
+}
\ No newline at end of file
@@ -0,0 +1,113 @@
+#pragma once
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "OrbitCamera.hpp"
+
+// Keyframed OrbitCamera for scripted sequences. Keys hold azimuth and elevation in
+// degrees and the distance; between keys every channel follows a Catmull-Rom spline, so
+// the camera moves without the velocity jumps of linear interpolation.
+class CameraPath
+{
+public:
+    struct Key
+    {
+        float time;
+        float azimuth;
+        float elevation;
+        float distance;
+    };
+
+    CameraPath(glm::vec3 target, std::vector<Key> keys)
+        : m_target(target), m_keys(std::move(keys))
+    {
+        if (m_keys.empty())
+            throw std::invalid_argument("camera path without keys");
+        std::stable_sort(m_keys.begin(), m_keys.end(), [](const Key& a, const Key& b) { return a.time < b.time; });
+    }
+
+    // one full turn around the camera at constant speed
+    static CameraPath turntable(const OrbitCamera& camera, float seconds)
+    {
+        float azimuth = glm::degrees(camera.azimuth);
+        float elevation = glm::degrees(camera.elevation);
+        return CameraPath(camera.target, { { 0.0f, azimuth, elevation, camera.distance },{ seconds, azimuth + 360.0f, elevation, camera.distance } });
+    }
+
+    // "time azimuth elevation distance" per line, # starts a comment
+    static CameraPath load(const std::string& path, glm::vec3 target)
+    {
+        std::ifstream file(path);
+        if (!file)
+            throw std::runtime_error("unable to open camera path " + path);
+
+        std::vector<Key> keys;
+        std::string line;
+        while (std::getline(file, line))
+        {
+            line = line.substr(0, line.find('#'));
+            std::istringstream iss(line);
+            Key key;
+            if (!(iss >> key.time))
+                continue;
+            if (!(iss >> key.azimuth >> key.elevation >> key.distance))
+                throw std::runtime_error("unable to parse camera key " + line);
+            keys.push_back(key);
+        }
+        return CameraPath(target, keys);
+    }
+
+    float duration() const { return m_keys.back().time; }
+
+    OrbitCamera sample(float time) const
+    {
+        size_t next = std::upper_bound(m_keys.begin(), m_keys.end(), time, [](float t, const Key& key) { return t < key.time; }) - m_keys.begin();
+        if (next == 0)
+            return camera(m_keys.front());
+        if (next == m_keys.size())
+            return camera(m_keys.back());
+
+        const Key& k1 = m_keys[next - 1];
+        const Key& k2 = m_keys[next];
+        float t = k2.time > k1.time ? (time - k1.time) / (k2.time - k1.time) : 1.0f;
+        // past the first and last key the neighbour is extrapolated, which keeps evenly spaced keys at constant speed
+        auto channel = [&](float Key::* value)
+        {
+            float p1 = k1.*value;
+            float p2 = k2.*value;
+            float p0 = next >= 2 ? m_keys[next - 2].*value : 2.0f * p1 - p2;
+            float p3 = next + 1 < m_keys.size() ? m_keys[next + 1].*value : 2.0f * p2 - p1;
+            return spline(p0, p1, p2, p3, t);
+        };
+
+        Key key;
+        key.time = time;
+        key.azimuth = channel(&Key::azimuth);
+        key.elevation = channel(&Key::elevation);
+        key.distance = channel(&Key::distance);
+        return camera(key);
+    }
+
+private:
+    glm::vec3 m_target;
+    std::vector<Key> m_keys;
+
+    OrbitCamera camera(const Key& key) const
+    {
+        float elevation = glm::clamp(glm::radians(key.elevation), 0.001f, glm::pi<float>() - 0.001f);
+        return OrbitCamera{ m_target, glm::radians(key.azimuth), elevation, glm::max(key.distance, 0.01f), false, 0, 0 };
+    }
+
+    static float spline(float p0, float p1, float p2, float p3, float t)
+    {
+        float t2 = t * t;
+        float t3 = t2 * t;
+        return 0.5f * (2.0f * p1 + (p2 - p0) * t + (2.0f * p0 - 5.0f * p1 + 4.0f * p2 - p3) * t2 + (3.0f * p1 - p0 - 3.0f * p2 + p3) * t3);
+    }
+};
\ No newline at end of file
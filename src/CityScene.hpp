@@ -0,0 +1,194 @@
+#pragma once
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_inverse.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+#include <dc/Mesh.hpp>
+
+#include "OcclusionCuller.hpp"
+
+// A dense synthetic city assembled from the primitives of an Asset Forge model: every
+// block gets a ground slab including the streets, a ring of buildings along its edges and props scattered over
+// the courtyard and the streets around it. Roles are picked from the primitives' bounds,
+// the widest closed box becomes the ground, the tallest the buildings, anything about
+// one unit in size a prop. Placement is seeded, so every run builds the same city.
+class CityScene
+{
+public:
+    // block edge plus the street around it
+    static constexpr float BlockPitch = 16.0f;
+    static constexpr float StreetWidth = 4.0f;
+
+    struct Object
+    {
+        unsigned primitive;
+        glm::mat4 model;
+    };
+
+    CityScene(std::vector<dc::MeshData> primitives, unsigned blocks, unsigned seed = 1)
+        : m_primitives(std::move(primitives))
+    {
+        int ground = -1;
+        int building = -1;
+        std::vector<unsigned> props;
+        for (size_t i = 0; i < m_primitives.size(); ++i)
+        {
+            Bounds bounds = Bounds::of(m_primitives[i]);
+            m_bounds.push_back(bounds);
+            m_solid.push_back(Bounds::filledBy(m_primitives[i], bounds));
+
+            glm::vec3 size = bounds.max - bounds.min;
+            unsigned index = static_cast<unsigned>(i);
+            if (m_solid.back() && (ground < 0 || size.x * size.z > footprint(m_bounds[ground])))
+                ground = index;
+            if (m_solid.back() && (building < 0 || slenderness(bounds) > slenderness(m_bounds[building])))
+                building = index;
+            if (glm::max(size.x, glm::max(size.y, size.z)) <= 2.0f)
+                props.push_back(index);
+        }
+        if (ground < 0 || building < 0 || props.empty())
+            throw std::runtime_error("model has no box primitives to build a city from");
+
+        std::mt19937 random(seed);
+        auto uniform = [&](float lo, float hi) { return std::uniform_real_distribution<float>(lo, hi)(random); };
+        auto pick = [&]() { return props[std::uniform_int_distribution<size_t>(0, props.size() - 1)(random)]; };
+
+        float extent = blocks * BlockPitch;
+        for (unsigned bz = 0; bz < blocks; ++bz)
+        {
+            for (unsigned bx = 0; bx < blocks; ++bx)
+            {
+                glm::vec3 origin(bx * BlockPitch - extent * 0.5f + StreetWidth * 0.5f, 0.0f, bz * BlockPitch - extent * 0.5f + StreetWidth * 0.5f);
+                float side = BlockPitch - StreetWidth;
+                // paves half the street on every side
+                glm::vec3 paving(StreetWidth * 0.5f, 1.0f, StreetWidth * 0.5f);
+                place(ground, origin - paving, origin + glm::vec3(side, 0.0f, side) + paving - glm::vec3(0.0f, 1.0f, 0.0f));
+
+                // three buildings per edge, leaving the courtyard open from above only
+                for (unsigned edge = 0; edge < 4; ++edge)
+                {
+                    for (unsigned slot = 0; slot < 3; ++slot)
+                    {
+                        float depth = uniform(2.5f, 3.5f);
+                        float height = uniform(3.0f, 14.0f);
+                        float along = slot * side / 3.0f;
+                        glm::vec2 lo, hi;
+                        switch (edge)
+                        {
+                        case 0: lo = { along, 0.0f }; hi = { along + side / 3.0f, depth }; break;
+                        case 1: lo = { along, side - depth }; hi = { along + side / 3.0f, side }; break;
+                        case 2: lo = { 0.0f, along }; hi = { depth, along + side / 3.0f }; break;
+                        default: lo = { side - depth, along }; hi = { side, along + side / 3.0f }; break;
+                        }
+                        place(building, origin + glm::vec3(lo.x, 0.0f, lo.y), origin + glm::vec3(hi.x, height, hi.y));
+                    }
+                }
+
+                for (unsigned i = 0; i < 20; ++i)
+                {
+                    placeProp(pick(), origin + glm::vec3(uniform(4.0f, side - 4.0f), 0.0f, uniform(4.0f, side - 4.0f)), uniform(0.0f, 6.283f));
+                }
+                // on the street along the block's near edges
+                for (unsigned i = 0; i < 8; ++i)
+                {
+                    float along = uniform(0.0f, side);
+                    float across = -uniform(0.5f, StreetWidth - 0.5f);
+                    glm::vec3 position = i % 2 ? glm::vec3(along, 0.0f, across) : glm::vec3(across, 0.0f, along);
+                    placeProp(pick(), origin + position, uniform(0.0f, 6.283f));
+                }
+            }
+        }
+    }
+
+    const std::vector<dc::MeshData>& primitives() const { return m_primitives; }
+    const std::vector<Object>& objects() const { return m_objects; }
+
+    // input of OcclusionCuller::cull, closed boxes are occluder candidates
+    std::vector<OcclusionCuller::Object> cullObjects() const
+    {
+        std::vector<OcclusionCuller::Object> objects;
+        for (const auto& it : m_objects)
+        {
+            objects.push_back({ m_bounds[it.primitive], it.model, static_cast<bool>(m_solid[it.primitive]) });
+        }
+        return objects;
+    }
+
+    size_t triangleCount(unsigned object) const
+    {
+        return m_primitives[m_objects[object].primitive].indices.size() / 3;
+    }
+
+    // the given objects baked into one mesh in world space, for renderers drawing a single mesh
+    dc::MeshData merge(const std::vector<unsigned>& objects) const
+    {
+        dc::MeshData merged;
+        for (unsigned index : objects)
+        {
+            const Object& object = m_objects[index];
+            const dc::MeshData& primitive = m_primitives[object.primitive];
+            unsigned base = static_cast<unsigned>(merged.vertices.size());
+            unsigned offset = static_cast<unsigned>(merged.indices.size());
+            glm::mat3 normalMatrix = glm::inverseTranspose(glm::mat3(object.model));
+            for (auto vertex : primitive.vertices)
+            {
+                vertex.position = glm::vec3(object.model * glm::vec4(vertex.position, 1.0f));
+                vertex.normal = glm::normalize(normalMatrix * vertex.normal);
+                merged.vertices.push_back(vertex);
+            }
+            for (unsigned it : primitive.indices)
+            {
+                merged.indices.push_back(base + it);
+            }
+            for (auto group : primitive.groups)
+            {
+                group.offset += offset;
+                merged.groups.push_back(group);
+            }
+        }
+        return merged;
+    }
+
+private:
+    std::vector<dc::MeshData> m_primitives;
+    std::vector<Bounds> m_bounds;
+    std::vector<char> m_solid;
+    std::vector<Object> m_objects;
+
+    static float footprint(const Bounds& bounds)
+    {
+        glm::vec3 size = bounds.max - bounds.min;
+        return size.x * size.z;
+    }
+
+    static float slenderness(const Bounds& bounds)
+    {
+        glm::vec3 size = bounds.max - bounds.min;
+        return size.y / (size.x * size.z);
+    }
+
+    // stretches the primitive's bounds onto lo - hi
+    void place(unsigned primitive, const glm::vec3& lo, const glm::vec3& hi)
+    {
+        const Bounds& bounds = m_bounds[primitive];
+        glm::mat4 model = glm::translate(glm::mat4(1.0f), lo);
+        model = glm::scale(model, (hi - lo) / (bounds.max - bounds.min));
+        model = glm::translate(model, -bounds.min);
+        m_objects.push_back({ primitive, model });
+    }
+
+    // standing on the ground at position, turned by yaw around its center
+    void placeProp(unsigned primitive, const glm::vec3& position, float yaw)
+    {
+        const Bounds& bounds = m_bounds[primitive];
+        glm::vec3 center = (bounds.min + bounds.max) * 0.5f;
+        glm::mat4 model = glm::translate(glm::mat4(1.0f), position);
+        model = glm::rotate(model, yaw, { 0.0f, 1.0f, 0.0f });
+        model = glm::translate(model, -glm::vec3(center.x, bounds.min.y, center.z));
+        m_objects.push_back({ primitive, model });
+    }
+};
\ No newline at end of file
@@ -0,0 +1,388 @@
+#pragma once
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <iomanip>
+#include <ostream>
+#include <stdexcept>
+#include <vector>
+
+#include <dc/ImageCompare.hpp>
+#include <dc/Simd.hpp>
+#include <dc/ThreadPool.hpp>
+
+// G-buffer of the software renderer in the classic layout: Kd and N * 0.5 + 0.5 as RGB8
+// packed into one word each, window space depth as float. Rows go bottom to top like GL
+// textures, so the post process below can follow sobel.glsl line by line.
+struct CpuGBuffer
+{
+    unsigned width = 0;
+    unsigned height = 0;
+    // rows are padded to whole groups of four pixels, so SIMD loads and stores never reach into the next row
+    unsigned pitch = 0;
+    std::vector<uint32_t> color;
+    std::vector<uint32_t> normal;
+    std::vector<float> depth;
+
+    void resize(unsigned w, unsigned h)
+    {
+        width = w;
+        height = h;
+        pitch = (w + 3) & ~3u;
+        color.resize(static_cast<size_t>(pitch) * h);
+        normal.resize(color.size());
+        depth.resize(color.size());
+    }
+
+    size_t index(unsigned x, unsigned y) const { return static_cast<size_t>(y) * pitch + x; }
+
+    // unorm8 rounding as the GL applies it when writing RGB8
+    static uint32_t pack(const glm::vec3& value)
+    {
+        glm::vec3 c = glm::clamp(value, 0.0f, 1.0f) * 255.0f + 0.5f;
+        return static_cast<uint32_t>(c.r) | (static_cast<uint32_t>(c.g) << 8) | (static_cast<uint32_t>(c.b) << 16);
+    }
+
+    static glm::vec3 unpack(uint32_t value)
+    {
+        return glm::vec3(value & 0xFF, (value >> 8) & 0xFF, (value >> 16) & 0xFF) / 255.0f;
+    }
+};
+
+// CPU port of sobel.glsl and stylize.glsl for the classic layout, uniforms at their
+// shader defaults. Samples outside the image read 0 like the ClampToBorder textures.
+// Rows are streamed through a ring of luminance rows in strips, one strip per task. The
+// kernels are written once over dc::simd lanes and run 1, 4 or 8 pixels per step, the
+// pixels left over at the end of a row go through the scalar instance.
+class CpuStylize
+{
+public:
+    enum Path
+    {
+        Scalar,
+        Sse2,
+        Avx2
+    };
+
+    // g-buffer and output bytes a strip should stay within, about a core's share of L2
+    static const size_t StripBytes = 256 * 1024;
+    static const unsigned MinStripRows = 4;
+    static const unsigned MaxStripRows = 64;
+
+    glm::vec3 lightDirection{ -1.0f, -1.0f, 1.0f };
+    float zNear = 0.1f;
+    float zFar = 100.0f;
+    float fogStart = 90.0f;
+    float fogEnd = 100.0f;
+    float edgeThreshold = 0.05f;
+    Path path = best();
+
+    static Path best()
+    {
+#if defined(DC_AVX2)
+        return Avx2;
+#elif defined(DC_SSE2)
+        return Sse2;
+#else
+        return Scalar;
+#endif
+    }
+
+    // AVX2 needs a build targeting it, SSE2 is there on x64
+    static bool supported(Path path)
+    {
+        switch (path)
+        {
+#ifdef DC_AVX2
+        case Avx2:
+            return true;
+#endif
+#ifdef DC_SSE2
+        case Sse2:
+            return true;
+#endif
+        case Scalar:
+            return true;
+        default:
+            return false;
+        }
+    }
+
+    static const char* name(Path path)
+    {
+        switch (path)
+        {
+        case Sse2:
+            return "sse2";
+        case Avx2:
+            return "avx2";
+        default:
+            return "scalar";
+        }
+    }
+
+    // rows per task: every strip converts two rows twice for the 3x3 window, so strips are
+    // made as tall as the cache budget allows, but short enough to give each thread a few
+    static unsigned stripRows(unsigned width, unsigned height, unsigned threads)
+    {
+        // colour, normal, depth in, RGBA out
+        size_t rowBytes = static_cast<size_t>(std::max(width, 1u)) * 16;
+        unsigned rows = static_cast<unsigned>(std::min<size_t>(MaxStripRows, StripBytes / rowBytes));
+        rows = std::min(rows, height / (std::max(threads, 1u) * 4));
+        return std::max(rows, MinStripRows);
+    }
+
+    // shades the whole g-buffer into RGBA8, bottom row first
+    void run(const CpuGBuffer& gbuffer, std::vector<unsigned char>& rgba, dc::ThreadPool& pool) const
+    {
+        if (!supported(path))
+            throw std::invalid_argument(std::string("post process path not compiled in: ") + name(path));
+
+        rgba.resize(static_cast<size_t>(gbuffer.width) * gbuffer.height * 4);
+        unsigned rows = stripRows(gbuffer.width, gbuffer.height, pool.size());
+        unsigned strips = (gbuffer.height + rows - 1) / rows;
+        pool.parallelFor(strips, [&](size_t strip)
+        {
+            unsigned y0 = static_cast<unsigned>(strip) * rows;
+            shadeRows(gbuffer, rgba.data(), y0, std::min(y0 + rows, gbuffer.height));
+        });
+    }
+
+    void shadeRows(const CpuGBuffer& gbuffer, unsigned char* rgba, unsigned y0, unsigned y1) const
+    {
+        switch (path)
+        {
+#ifdef DC_AVX2
+        case Avx2:
+            shadeRows<dc::simd::Float8>(gbuffer, rgba, y0, y1);
+            break;
+#endif
+#ifdef DC_SSE2
+        case Sse2:
+            shadeRows<dc::simd::Float4>(gbuffer, rgba, y0, y1);
+            break;
+#endif
+        default:
+            shadeRows<dc::simd::Float1>(gbuffer, rgba, y0, y1);
+            break;
+        }
+    }
+
+    // Megapixels per second of every compiled path over 1, 2, 4, ... threads at the shader
+    // defaults, and how far each vector path strays from the scalar one.
+    static void benchmark(std::ostream& out, const CpuGBuffer& gbuffer)
+    {
+        const unsigned frames = 20;
+
+        std::vector<unsigned> threadCounts;
+        unsigned hardware = dc::ThreadPool::hardwareThreads();
+        for (unsigned threads = 1; threads < hardware; threads *= 2)
+        {
+            threadCounts.push_back(threads);
+        }
+        threadCounts.push_back(hardware);
+
+        std::ios::fmtflags flags(out.flags());
+        std::streamsize precision = out.precision();
+
+        double megapixels = static_cast<double>(gbuffer.width) * gbuffer.height / 1.0e6;
+        out << "post process " << gbuffer.width << "x" << gbuffer.height << ", " << frames << " frames:" << std::endl;
+        out << "  path     threads     MP/s       ms  speedup" << std::endl;
+
+        std::vector<unsigned char> reference;
+        double baseline = 0.0;
+        for (Path path : { Scalar, Sse2, Avx2 })
+        {
+            if (!supported(path))
+                continue;
+
+            CpuStylize stylize;
+            stylize.path = path;
+            std::vector<unsigned char> image;
+            for (unsigned threads : threadCounts)
+            {
+                dc::ThreadPool pool(threads);
+                // the first run touches every page of the output
+                stylize.run(gbuffer, image, pool);
+
+                auto start = Clock::now();
+                for (unsigned i = 0; i < frames; ++i)
+                {
+                    stylize.run(gbuffer, image, pool);
+                }
+                double ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count() / frames;
+                double rate = megapixels * 1000.0 / ms;
+                if (baseline == 0.0)
+                    baseline = rate;
+
+                out << "  " << std::left << std::setw(8) << name(path) << std::right << std::fixed << std::setprecision(2)
+                    << std::setw(8) << threads << std::setw(9) << rate << std::setw(9) << ms << std::setw(8) << rate / baseline << "x" << std::endl;
+            }
+
+            if (path == Scalar)
+            {
+                reference = image;
+            }
+            else
+            {
+                out << "  " << name(path) << " against scalar: ";
+                dc::compareImages(reference.data(), image.data(), gbuffer.width, gbuffer.height, 4, 1).print(out);
+                out << std::endl;
+            }
+        }
+
+        out.flags(flags);
+        out.precision(precision);
+    }
+
+private:
+    typedef std::chrono::high_resolution_clock Clock;
+
+    template<typename V>
+    void shadeRows(const CpuGBuffer& gbuffer, unsigned char* rgba, unsigned y0, unsigned y1) const
+    {
+        // luminance of both attachments is all the edge detection reads, so convert each texel once per row
+        unsigned w = gbuffer.width;
+        // whole groups of V::Width pixels, the rest of the row goes through the scalar kernels
+        unsigned wide = w - w % V::Width;
+        std::vector<float> colorLuma(static_cast<size_t>(w + 2) * 3);
+        std::vector<float> normalLuma(colorLuma.size());
+        // three row slots used as a ring, every row is converted once per strip
+        auto slot = [&](int y) { return static_cast<size_t>((y + 3) % 3) * (w + 2); };
+        auto loadRow = [&](int y)
+        {
+            float* c = &colorLuma[slot(y)];
+            float* n = &normalLuma[slot(y)];
+            if (y < 0 || y >= static_cast<int>(gbuffer.height))
+            {
+                std::fill_n(c, w + 2, 0.0f);
+                std::fill_n(n, w + 2, 0.0f);
+                return;
+            }
+            c[0] = c[w + 1] = n[0] = n[w + 1] = 0.0f;
+            size_t row = gbuffer.index(0, static_cast<unsigned>(y));
+            lumaSpan<V>(&gbuffer.color[row], c + 1, 0, wide);
+            lumaSpan<dc::simd::Float1>(&gbuffer.color[row], c + 1, wide, w);
+            lumaSpan<V>(&gbuffer.normal[row], n + 1, 0, wide);
+            lumaSpan<dc::simd::Float1>(&gbuffer.normal[row], n + 1, wide, w);
+        };
+
+        loadRow(static_cast<int>(y0) - 1);
+        loadRow(static_cast<int>(y0));
+
+        glm::vec3 L = -glm::normalize(lightDirection);
+        for (unsigned y = y0; y < y1; ++y)
+        {
+            int row = static_cast<int>(y);
+            loadRow(row + 1);
+            Window window =
+            {
+                { &colorLuma[slot(row + 1)], &colorLuma[slot(row)], &colorLuma[slot(row - 1)] },
+                { &normalLuma[slot(row + 1)], &normalLuma[slot(row)], &normalLuma[slot(row - 1)] }
+            };
+            shadeSpan<V>(gbuffer, window, L, y, 0, wide, rgba);
+            shadeSpan<dc::simd::Float1>(gbuffer, window, L, y, wide, w, rgba);
+        }
+    }
+
+    // luminance rows around the shaded one, top row first like s[0..8] of sobel.glsl
+    struct Window
+    {
+        const float* color[3];
+        const float* normal[3];
+    };
+
+    template<typename V>
+    static void lumaSpan(const uint32_t* packed, float* luma, unsigned x0, unsigned x1)
+    {
+        const V scale(1.0f / 255.0f);
+        for (unsigned x = x0; x < x1; x += V::Width)
+        {
+            V r = V::unpackByte(packed + x, 0) * scale;
+            V g = V::unpackByte(packed + x, 8) * scale;
+            V b = V::unpackByte(packed + x, 16) * scale;
+            (r * V(0.2126f) + g * V(0.7152f) + b * V(0.0722f)).store(luma + x);
+        }
+    }
+
+    // neighbours in the order top left, top, top right, left, right, bottom left, bottom, bottom right
+    template<typename V>
+    static V sobel(V s0, V s1, V s2, V s3, V s5, V s6, V s7, V s8)
+    {
+        V gx = s0 + V(2.0f) * s3 + s6 - s2 - V(2.0f) * s5 - s8;
+        V gy = s0 + V(2.0f) * s1 + s2 - s6 - V(2.0f) * s7 - s8;
+        return sqrt(gx * gx + gy * gy);
+    }
+
+    // a * (1 - t) + b * t like GLSL and glm
+    template<typename V>
+    static V mix(V a, V b, V t)
+    {
+        return a * (V(1.0f) - t) + b * t;
+    }
+
+    // stylize() of stylize.glsl for pixels x0 to x1 of row y, the luma window is offset by one pixel
+    template<typename V>
+    void shadeSpan(const CpuGBuffer& gbuffer, const Window& window, const glm::vec3& L, unsigned y, unsigned x0, unsigned x1, unsigned char* rgba) const
+    {
+        const V zero(0.0f);
+        const V one(1.0f);
+        const V two(2.0f);
+
+        const glm::vec3 leftBot(1.0f, 0.9f, 0.4f);
+        const glm::vec3 rightTop(0.9f, 0.7f, 1.0f);
+        const glm::vec3 edgeColor(0.2f, 0.0f, 0.1f);
+
+        float v = (y + 0.5f) / gbuffer.height;
+        const V vv(v * v);
+        const V width(static_cast<float>(gbuffer.width));
+        const V fogRange(fogEnd - fogStart);
+
+        for (unsigned x = x0; x < x1; x += V::Width)
+        {
+            const float* const* c = window.color;
+            const float* const* n = window.normal;
+            V colorEdge = sobel(V::load(c[0] + x), V::load(c[0] + x + 1), V::load(c[0] + x + 2), V::load(c[1] + x), V::load(c[1] + x + 2),
+                V::load(c[2] + x), V::load(c[2] + x + 1), V::load(c[2] + x + 2));
+            V normalEdge = sobel(V::load(n[0] + x), V::load(n[0] + x + 1), V::load(n[0] + x + 2), V::load(n[1] + x), V::load(n[1] + x + 2),
+                V::load(n[2] + x), V::load(n[2] + x + 1), V::load(n[2] + x + 2));
+            V edge = select((colorEdge + normalEdge) * two >= V(edgeThreshold), one, zero);
+
+            size_t i = gbuffer.index(x, y);
+            const uint32_t* packed = &gbuffer.normal[i];
+            V nx = V::unpackByte(packed, 0) * V(1.0f / 255.0f) * two - one;
+            V ny = V::unpackByte(packed, 8) * V(1.0f / 255.0f) * two - one;
+            V nz = V::unpackByte(packed, 16) * V(1.0f / 255.0f) * two - one;
+            V invLength = one / sqrt(nx * nx + ny * ny + nz * nz);
+            nx = nx * invLength;
+            ny = ny * invLength;
+            nz = nz * invLength;
+
+            V u = (V(static_cast<float>(x)) + V::ramp() + V(0.5f)) / width;
+            V luv2 = u * u + vv;
+            V faceWeight = abs(ny);
+
+            V diffuse = max(zero, nx * V(L.x) + ny * V(L.y) + nz * V(L.z));
+            V shadow = V(0.7f) + diffuse * V(0.3f);
+
+            V ndc = two * V::load(&gbuffer.depth[i]) - one;
+            V depth = V(2.0f * zNear * zFar) / (V(zFar + zNear) - ndc * V(zFar - zNear));
+            V t = min(max((depth - V(fogStart)) / fogRange, zero), one);
+            V fog = t * t * (V(3.0f) - two * t);
+
+            V channels[3];
+            for (int k = 0; k < 3; ++k)
+            {
+                V mixColor = mix(V(leftBot[k]), V(rightTop[k]), luv2);
+                V faceColor = mix(one, mixColor, faceWeight);
+                V finalColor = mix(faceColor, V(edgeColor[k]), edge) * shadow;
+                V color = mix(finalColor, mixColor * V(0.2f), fog);
+                channels[k] = min(max(color, zero), one) * V(255.0f);
+            }
+            storeRgba(rgba + (static_cast<size_t>(y) * gbuffer.width + x) * 4, channels[0], channels[1], channels[2]);
+        }
+    }
+};
\ No newline at end of file
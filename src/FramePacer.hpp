@@ -0,0 +1,233 @@
+#pragma once
+#include <glad/glad.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <deque>
+#include <thread>
+#include <vector>
+
+// Frame pacing of the window loop and the latency it costs. Every frame reports when it
+// read its input (latched), finished submitting and was presented; from those the pacer
+// keeps input-to-submit and input-to-present latency and the jitter of the present
+// interval over the last frames, whichever way the loop runs.
+//
+// In latency mode the pacer also decides when a frame starts. waitToLatch() first waits
+// on the fences of older frames until fewer than framesInFlight are still on the GPU,
+// then until the frame cap's next deadline minus what recent frames needed from latch to
+// swap, so input is read as late as possible and the frame is done just in time.
+// waitToPresent() holds the swap until the deadline itself. Waits sleep most of the way
+// and spin the last two milliseconds, a sleep can overshoot by a scheduler quantum.
+class FramePacer
+{
+public:
+    typedef std::chrono::steady_clock Clock;
+
+    struct Stats
+    {
+        size_t frames = 0;
+        double submitMean = 0.0;
+        double submitP99 = 0.0;
+        double presentMean = 0.0;
+        double presentP99 = 0.0;
+        double intervalMean = 0.0;
+        // standard deviation of the present interval
+        double intervalJitter = 0.0;
+    };
+
+    FramePacer() = default;
+
+    ~FramePacer()
+    {
+        for (GLsync fence : m_fences)
+        {
+            glDeleteSync(fence);
+        }
+    }
+
+    FramePacer(const FramePacer& other) = delete;
+    FramePacer& operator=(const FramePacer& other) = delete;
+
+    // frameCap in frames per second, 0 leaves the pace to the swap
+    void configure(bool latencyMode, unsigned framesInFlight, double frameCap)
+    {
+        m_latencyMode = latencyMode;
+        m_framesInFlight = std::max(framesInFlight, 1u);
+        m_frameCap = frameCap;
+        m_period = frameCap > 0.0 ? std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / frameCap)) : Clock::duration::zero();
+        m_deadline = Clock::time_point();
+    }
+
+    bool latencyMode() const { return m_latencyMode; }
+    unsigned framesInFlight() const { return m_framesInFlight; }
+    double frameCap() const { return m_frameCap; }
+
+    // latency mode only, returns right away otherwise
+    void waitToLatch()
+    {
+        if (!m_latencyMode)
+            return;
+        while (m_fences.size() >= m_framesInFlight)
+        {
+            // flushes so a fence still in the command queue can signal at all
+            if (glClientWaitSync(m_fences.front(), GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000) == GL_TIMEOUT_EXPIRED)
+                continue;
+            glDeleteSync(m_fences.front());
+            m_fences.pop_front();
+        }
+        if (m_period == Clock::duration::zero())
+            return;
+        Clock::time_point now = Clock::now();
+        // fell behind by more than a frame: start over from now instead of rushing to catch up
+        if (m_deadline + m_period < now)
+            m_deadline = now;
+        m_deadline += m_period;
+        waitUntil(m_deadline - std::min(latchBudget(), m_period));
+    }
+
+    void latched()
+    {
+        m_latch = Clock::now();
+    }
+
+    void submitted()
+    {
+        m_submit.push(milliseconds(Clock::now() - m_latch));
+    }
+
+    // right before the swap
+    void waitToPresent()
+    {
+        m_work.push(milliseconds(Clock::now() - m_latch));
+        if (m_latencyMode && m_period != Clock::duration::zero())
+            waitUntil(m_deadline);
+    }
+
+    // right after the swap
+    void presented()
+    {
+        Clock::time_point now = Clock::now();
+        m_present.push(milliseconds(now - m_latch));
+        if (m_lastPresent != Clock::time_point())
+            m_interval.push(milliseconds(now - m_lastPresent));
+        m_lastPresent = now;
+        if (m_latencyMode)
+            m_fences.push_back(glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0));
+    }
+
+    Stats stats() const
+    {
+        Stats stats;
+        stats.frames = m_present.total;
+        double p99;
+        m_submit.summarize(stats.submitMean, stats.submitP99);
+        m_present.summarize(stats.presentMean, stats.presentP99);
+        m_interval.summarize(stats.intervalMean, p99);
+        double variance = 0.0;
+        for (double value : m_interval.values)
+        {
+            variance += (value - stats.intervalMean) * (value - stats.intervalMean);
+        }
+        stats.intervalJitter = m_interval.values.empty() ? 0.0 : std::sqrt(variance / m_interval.values.size());
+        return stats;
+    }
+
+    // starts the statistics over, e.g. after switching modes
+    void reset()
+    {
+        m_submit = Samples();
+        m_work = Samples();
+        m_present = Samples();
+        m_interval = Samples();
+        m_lastPresent = Clock::time_point();
+    }
+
+    static void waitUntil(Clock::time_point time)
+    {
+        const Clock::duration spin = std::chrono::milliseconds(2);
+        Clock::time_point now = Clock::now();
+        if (time - now > spin)
+            std::this_thread::sleep_for(time - now - spin);
+        while (Clock::now() < time)
+        {
+            std::this_thread::yield();
+        }
+    }
+
+private:
+    // the last Window values in milliseconds, overwritten in place once full
+    struct Samples
+    {
+        static const size_t Window = 600;
+
+        std::vector<double> values;
+        size_t next = 0;
+        size_t total = 0;
+
+        void push(double value)
+        {
+            if (values.size() < Window)
+                values.push_back(value);
+            else
+                values[next] = value;
+            next = (next + 1) % Window;
+            ++total;
+        }
+
+        // the largest of the newest count values
+        double newestMax(size_t count) const
+        {
+            double largest = 0.0;
+            for (size_t i = 1; i <= std::min(count, values.size()); ++i)
+            {
+                largest = std::max(largest, values[(next + Window - i) % Window]);
+            }
+            return largest;
+        }
+
+        void summarize(double& mean, double& p99) const
+        {
+            mean = 0.0;
+            p99 = 0.0;
+            if (values.empty())
+                return;
+            std::vector<double> sorted = values;
+            std::sort(sorted.begin(), sorted.end());
+            for (double value : sorted)
+            {
+                mean += value;
+            }
+            mean /= sorted.size();
+            p99 = sorted[(sorted.size() * 99) / 100];
+        }
+    };
+
+    bool m_latencyMode = false;
+    unsigned m_framesInFlight = 1;
+    double m_frameCap = 0.0;
+    Clock::duration m_period = Clock::duration::zero();
+    Clock::time_point m_deadline;
+    Clock::time_point m_latch;
+    Clock::time_point m_lastPresent;
+    std::deque<GLsync> m_fences;
+    Samples m_submit;
+    // from the latch until the frame was ready to swap, what the latch has to leave room for
+    Samples m_work;
+    Samples m_present;
+    Samples m_interval;
+
+    // the slowest of the last second's frames and a millisecond to spare
+    Clock::duration latchBudget() const
+    {
+        if (m_work.values.empty())
+            return m_period;
+        double budget = m_work.newestMax(static_cast<size_t>(std::max(m_frameCap, 1.0))) + 1.0;
+        return std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double, std::milli>(budget));
+    }
+
+    static double milliseconds(Clock::duration duration)
+    {
+        return std::chrono::duration<double, std::milli>(duration).count();
+    }
+};
\ No newline at end of file
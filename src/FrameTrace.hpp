@@ -0,0 +1,94 @@
+#pragma once
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Per-frame timings in named columns, written as CSV and summarized as mean, median,
+// 95th percentile and maximum. The percentiles are what show stalls, a mean hides them.
+class FrameTrace
+{
+public:
+    explicit FrameTrace(std::vector<std::string> columns)
+        : m_columns(std::move(columns))
+    {
+    }
+
+    void add(const std::vector<double>& row)
+    {
+        if (row.size() != m_columns.size())
+            throw std::invalid_argument("frame trace row does not match the columns");
+        m_rows.push_back(row);
+    }
+
+    size_t size() const { return m_rows.size(); }
+    double value(size_t frame, size_t column) const { return m_rows[frame][column]; }
+
+    bool writeCsv(const std::string& path) const
+    {
+        std::ofstream file(path);
+        file << "frame";
+        for (const auto& it : m_columns)
+        {
+            file << "," << it;
+        }
+        file << "\n" << std::fixed << std::setprecision(3);
+        for (size_t i = 0; i < m_rows.size(); ++i)
+        {
+            file << i;
+            for (double value : m_rows[i])
+            {
+                file << "," << value;
+            }
+            file << "\n";
+        }
+        if (!file)
+        {
+            std::cout << "failed to write " << path << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    // skip leaves warm-up frames out of the statistics
+    void printSummary(std::ostream& out, size_t skip = 0) const
+    {
+        std::ios::fmtflags flags(out.flags());
+        std::streamsize precision = out.precision();
+
+        out << std::left << std::setw(14) << "ms" << std::right << std::setw(9) << "mean" << std::setw(9) << "p50"
+            << std::setw(9) << "p95" << std::setw(9) << "max" << std::endl;
+        out << std::fixed << std::setprecision(2);
+        for (size_t c = 0; c < m_columns.size(); ++c)
+        {
+            std::vector<double> values;
+            for (size_t i = skip; i < m_rows.size(); ++i)
+            {
+                values.push_back(m_rows[i][c]);
+            }
+            if (values.empty())
+                continue;
+            std::sort(values.begin(), values.end());
+            double sum = 0.0;
+            for (double value : values)
+            {
+                sum += value;
+            }
+            out << std::left << std::setw(14) << m_columns[c] << std::right
+                << std::setw(9) << sum / values.size()
+                << std::setw(9) << values[values.size() / 2]
+                << std::setw(9) << values[(values.size() * 95) / 100]
+                << std::setw(9) << values.back() << std::endl;
+        }
+
+        out.flags(flags);
+        out.precision(precision);
+    }
+
+private:
+    std::vector<std::string> m_columns;
+    std::vector<std::vector<double>> m_rows;
+};
\ No newline at end of file
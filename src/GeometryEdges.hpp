@@ -0,0 +1,186 @@
+#pragma once
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <chrono>
+#include <iomanip>
+#include <memory>
+#include <ostream>
+#include <random>
+#include <vector>
+
+#include <dc/FeatureEdges.hpp>
+#include <dc/FrameBuffer.hpp>
+#include <dc/GpuResources.hpp>
+#include <dc/Mesh.hpp>
+#include <dc/RenderStats.hpp>
+#include <dc/Shader.hpp>
+
+// Edges from the mesh instead of the image. Every frame the creases of each instance and
+// the silhouettes found for the current eye are collected into one line list, rasterized
+// into an edge mask at g-buffer resolution and composited by sobel.glsl (EDGE_MASK).
+class GeometryEdges
+{
+public:
+    GeometryEdges(unsigned width, unsigned height)
+        : m_shader({ { dc::ShaderStage::Vertex, "line_vertex.glsl" },{ dc::ShaderStage::Fragment, "line_fragment.glsl" } }),
+          m_mask(width, height, { { dc::FBAttachmentType::AttachColor, dc::TextureFormat::R8 } })
+    {
+        glGenVertexArrays(1, std::addressof(m_vaoId));
+        glGenBuffers(1, std::addressof(m_vboId));
+        dc::GpuResources::get().add(dc::GpuResourceType::VertexArray, m_vaoId, 0, "geometry edge lines");
+        dc::GpuResources::get().add(dc::GpuResourceType::Buffer, m_vboId, 0, "geometry edge lines");
+
+        glBindVertexArray(m_vaoId);
+        glBindBuffer(GL_ARRAY_BUFFER, m_vboId);
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), nullptr);
+        glBindVertexArray(0);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+
+    ~GeometryEdges()
+    {
+        dc::GpuResources::get().remove(dc::GpuResourceType::Buffer, m_vboId);
+        dc::GpuResources::get().remove(dc::GpuResourceType::VertexArray, m_vaoId);
+        glDeleteBuffers(1, std::addressof(m_vboId));
+        glDeleteVertexArrays(1, std::addressof(m_vaoId));
+    }
+
+    GeometryEdges(const GeometryEdges& other) = delete;
+    GeometryEdges& operator=(const GeometryEdges& other) = delete;
+
+    void reload()
+    {
+        m_shader.reload();
+    }
+
+    const dc::Texture* edgeMask() const { return m_mask.texture(0); }
+    size_t lineCount() const { return m_lines.size() / 2; }
+
+    void begin()
+    {
+        m_lines.clear();
+        m_draws.clear();
+    }
+
+    // queues the feature lines of one instance, eye in world space
+    void add(const dc::Mesh& mesh, const glm::mat4& model, const glm::vec3& eye)
+    {
+        const dc::FeatureEdges& edges = mesh.featureEdges();
+        size_t first = m_lines.size();
+        m_lines.insert(m_lines.end(), edges.creases.begin(), edges.creases.end());
+        // plane side tests are invariant under the model transform, so test in object space
+        glm::vec3 objectEye = glm::vec3(glm::inverse(model) * glm::vec4(eye, 1.0f));
+        dc::extractSilhouettes(edges, objectEye, m_lines);
+        m_draws.push_back({ model, first, m_lines.size() - first });
+    }
+
+    // draws the queued lines into the edge mask, occluded by the g-buffer depth
+    void draw(const glm::mat4& view, const glm::mat4& projection, const dc::Texture* depthTexture)
+    {
+        glBindBuffer(GL_ARRAY_BUFFER, m_vboId);
+        // orphan the previous frame's lines instead of waiting for the GPU to finish with them
+        glBufferData(GL_ARRAY_BUFFER, sizeof(glm::vec3) * m_lines.size(), m_lines.data(), GL_STREAM_DRAW);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        dc::GpuResources::get().resize(dc::GpuResourceType::Buffer, m_vboId, sizeof(glm::vec3) * m_lines.size());
+        ++dc::renderStats().bufferUploads;
+        dc::renderStats().bufferBytes += sizeof(glm::vec3) * m_lines.size();
+
+        m_mask.bind();
+        glViewport(0, 0, m_mask.width(), m_mask.height());
+        GLfloat background[] = { 0.0f, 0.0f, 0.0f, 0.0f };
+        glClearBufferfv(GL_COLOR, 0, background);
+
+        glActiveTexture(GL_TEXTURE2);
+        depthTexture->bind();
+        m_shader.use();
+        m_shader.setInt("depthTexture", 2);
+        m_shader.setMat4("view", view);
+        m_shader.setMat4("projection", projection);
+
+        glBindVertexArray(m_vaoId);
+        for (const auto& it : m_draws)
+        {
+            m_shader.setMat4("model", it.model);
+            glDrawArrays(GL_LINES, static_cast<GLint>(it.first), static_cast<GLsizei>(it.count));
+            ++dc::renderStats().drawCalls;
+        }
+        glBindVertexArray(0);
+
+        glActiveTexture(GL_TEXTURE0);
+        m_mask.unbind();
+    }
+
+    // silhouette extraction throughput on a million random candidate edges, SSE against scalar
+    static void benchmark(std::ostream& out, const dc::Mesh& mesh)
+    {
+        const unsigned edgeCount = 1000000;
+        const unsigned views = 32;
+
+        std::mt19937 random(42);
+        std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+        auto randomDirection = [&]() { return glm::normalize(glm::vec3(unit(random), unit(random), unit(random)) + glm::vec3(0.0f, 0.0f, 1e-3f)); };
+
+        dc::FeatureEdges edges;
+        for (unsigned i = 0; i < edgeCount; ++i)
+        {
+            glm::vec3 a(unit(random), unit(random), unit(random));
+            glm::vec3 b = a + randomDirection() * 0.01f;
+            glm::vec3 n0 = randomDirection();
+            glm::vec3 n1 = randomDirection();
+            edges.addCandidate(a, b, glm::vec4(n0, glm::dot(n0, a)), glm::vec4(n1, glm::dot(n1, a)));
+        }
+        std::vector<glm::vec3> eyes(views);
+        for (auto& it : eyes)
+        {
+            it = randomDirection() * 10.0f;
+        }
+
+        std::ios::fmtflags flags(out.flags());
+        std::streamsize precision = out.precision();
+
+        out << "silhouette extraction, " << views << " views of " << edgeCount << " candidate edges:" << std::endl;
+        std::vector<glm::vec3> lines;
+        lines.reserve(edgeCount * 2);
+        for (bool simd : { false, true })
+        {
+            size_t found = 0;
+            auto start = std::chrono::high_resolution_clock::now();
+            for (const auto& eye : eyes)
+            {
+                lines.clear();
+                dc::extractSilhouettes(edges, eye, lines, simd);
+                found += lines.size() / 2;
+            }
+            std::chrono::duration<double, std::milli> elapsed = std::chrono::high_resolution_clock::now() - start;
+            double msPerView = elapsed.count() / views;
+
+            out << "  " << std::left << std::setw(7) << (simd ? "simd" : "scalar") << std::right
+                << std::fixed << std::setprecision(3) << std::setw(8) << msPerView << " ms per million edges "
+                << std::setprecision(1) << std::setw(8) << edgeCount / (msPerView * 1000.0) << " Medges/s "
+                << found / views << " silhouettes per view" << std::endl;
+        }
+        out << "  mesh: " << mesh.featureEdges().creases.size() / 2 << " creases, "
+            << mesh.featureEdges().candidateCount() << " silhouette candidates" << std::endl;
+
+        out.flags(flags);
+        out.precision(precision);
+    }
+
+private:
+    struct InstanceLines
+    {
+        glm::mat4 model;
+        size_t first;
+        size_t count;
+    };
+
+    dc::Shader m_shader;
+    dc::FrameBuffer m_mask;
+    GLuint m_vaoId;
+    GLuint m_vboId;
+
+    std::vector<glm::vec3> m_lines;
+    std::vector<InstanceLines> m_draws;
+};
\ No newline at end of file
@@ -0,0 +1,134 @@
+#pragma once
+#include <glad/glad.h>
+
+#include <iostream>
+
+#ifdef DC_USE_EGL
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#else
+#include <GLFW/glfw3.h>
+#endif
+
+// GL context without a visible window. Built with DC_USE_EGL it is a surfaceless EGL
+// context (link with -lEGL), which Mesa's llvmpipe provides on machines with neither a
+// display nor a GPU. Otherwise it falls back to an invisible GLFW window, which still
+// needs a display. Like the window, it asks for 4.3 core first and settles for 3.3.
+class HeadlessContext
+{
+public:
+    HeadlessContext() = default;
+
+    ~HeadlessContext()
+    {
+#ifdef DC_USE_EGL
+        if (m_display != EGL_NO_DISPLAY)
+        {
+            eglMakeCurrent(m_display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+            if (m_context != EGL_NO_CONTEXT)
+                eglDestroyContext(m_display, m_context);
+            eglTerminate(m_display);
+        }
+#else
+        if (m_window)
+            glfwDestroyWindow(m_window);
+        glfwTerminate();
+#endif
+    }
+
+    HeadlessContext(const HeadlessContext& other) = delete;
+    HeadlessContext& operator=(const HeadlessContext& other) = delete;
+
+    // makes the context current and loads glad
+    bool create()
+    {
+        if (!createContext())
+            return false;
+        if (!gladLoadGLLoader(loader()))
+        {
+            std::cout << "Failed to initialize GLAD" << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    GLADloadproc loader() const
+    {
+#ifdef DC_USE_EGL
+        return [](const char* name) { return reinterpret_cast<void*>(eglGetProcAddress(name)); };
+#else
+        return reinterpret_cast<GLADloadproc>(glfwGetProcAddress);
+#endif
+    }
+
+private:
+#ifdef DC_USE_EGL
+    EGLDisplay m_display = EGL_NO_DISPLAY;
+    EGLContext m_context = EGL_NO_CONTEXT;
+
+    bool createContext()
+    {
+        // the surfaceless platform needs no X server or DRM device, the default display is the fallback
+        auto getPlatformDisplay = reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(eglGetProcAddress("eglGetPlatformDisplayEXT"));
+        if (getPlatformDisplay)
+            m_display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+        if (m_display == EGL_NO_DISPLAY)
+            m_display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+
+        EGLint major = 0, minor = 0;
+        if (m_display == EGL_NO_DISPLAY || !eglInitialize(m_display, &major, &minor))
+        {
+            std::cout << "Failed to initialize EGL" << std::endl;
+            m_display = EGL_NO_DISPLAY;
+            return false;
+        }
+        eglBindAPI(EGL_OPENGL_API);
+
+        // rendering only goes to framebuffer objects, so no config or surface is needed
+        const EGLint versions[][2] = { { 4, 3 },{ 3, 3 } };
+        for (const auto& it : versions)
+        {
+            const EGLint attributes[] = {
+                EGL_CONTEXT_MAJOR_VERSION, it[0],
+                EGL_CONTEXT_MINOR_VERSION, it[1],
+                EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+                EGL_NONE
+            };
+            m_context = eglCreateContext(m_display, EGL_NO_CONFIG_KHR, EGL_NO_CONTEXT, attributes);
+            if (m_context != EGL_NO_CONTEXT)
+                break;
+        }
+        if (m_context == EGL_NO_CONTEXT || !eglMakeCurrent(m_display, EGL_NO_SURFACE, EGL_NO_SURFACE, m_context))
+        {
+            std::cout << "Failed to create EGL context (0x" << std::hex << eglGetError() << std::dec << ")" << std::endl;
+            return false;
+        }
+        return true;
+    }
+#else
+    GLFWwindow* m_window = nullptr;
+
+    bool createContext()
+    {
+        glfwInit();
+        glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+        glfwWindowHint(GLFW_VISIBLE, GL_FALSE);
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+        m_window = glfwCreateWindow(1, 1, "Mesh Rendering", NULL, NULL);
+        if (m_window == NULL)
+        {
+            glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+            glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+            m_window = glfwCreateWindow(1, 1, "Mesh Rendering", NULL, NULL);
+        }
+        if (m_window == NULL)
+        {
+            std::cout << "Failed to create GLFW window" << std::endl;
+            return false;
+        }
+        glfwMakeContextCurrent(m_window);
+        return true;
+    }
+#endif
+};
\ No newline at end of file
@@ -0,0 +1,269 @@
+#pragma once
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+#include <dc/Buffer.hpp>
+#include <dc/GLExtensions.hpp>
+#include <dc/GpuResources.hpp>
+#include <dc/Mesh.hpp>
+#include <dc/Shader.hpp>
+#include <dc/Texture.hpp>
+
+// GPU occlusion culling of mesh instances against a hierarchical depth buffer, in two
+// passes per frame. The first tests every instance against the Hi-Z of the previous
+// frame and draws what passes through indirect draw commands the cull shader filled; the
+// second rebuilds the Hi-Z from that depth and retests what the first found occluded,
+// drawing instances that just came into view. Only the late pass has to be right, so a
+// stale or missing history costs time but never pixels. Needs GL 4.3, see dc::gl43.
+class HiZCulling
+{
+public:
+    // per instance result of the last frame, as read back by readStates
+    enum State
+    {
+        Culled,
+        Drawn,
+        Occluded,
+        DrawnLate
+    };
+
+    // texture units used while culling and drawing, above the post process inputs
+    static const unsigned DepthUnit = 7;
+    static const unsigned VisibleIdsUnit = 8;
+    static const unsigned InstanceModelsUnit = 9;
+
+    HiZCulling(unsigned width, unsigned height)
+        : m_buildShader({ { dc::ShaderStage::Compute, "hiz_build.glsl" } }),
+          m_copyShader({ { dc::ShaderStage::Compute, "hiz_build.glsl" } }, { "FROM_DEPTH" }),
+          m_cullShader({ { dc::ShaderStage::Compute, "hiz_cull.glsl" } }),
+          // half the depth's resolution, a box smaller than a texel there is not worth culling
+          m_hiZ(std::max(width / 2, 1u), std::max(height / 2, 1u), dc::TextureFormat::R32F, dc::TextureWrap::ClampToEdge, dc::TextureFilter::Nearest,
+              levelCount(std::max(width / 2, 1u), std::max(height / 2, 1u)))
+    {
+        glGenTextures(1, std::addressof(m_visibleIdsTexture));
+        glGenTextures(1, std::addressof(m_instanceModelsTexture));
+        // views of the buffers below, which hold the storage
+        dc::GpuResources::get().add(dc::GpuResourceType::Texture, m_visibleIdsTexture, 0, "visible ids buffer texture");
+        dc::GpuResources::get().add(dc::GpuResourceType::Texture, m_instanceModelsTexture, 0, "instance models buffer texture");
+    }
+
+    ~HiZCulling()
+    {
+        dc::GpuResources::get().remove(dc::GpuResourceType::Texture, m_visibleIdsTexture);
+        dc::GpuResources::get().remove(dc::GpuResourceType::Texture, m_instanceModelsTexture);
+        glDeleteTextures(1, std::addressof(m_visibleIdsTexture));
+        glDeleteTextures(1, std::addressof(m_instanceModelsTexture));
+    }
+
+    HiZCulling(const HiZCulling& other) = delete;
+    HiZCulling& operator=(const HiZCulling& other) = delete;
+
+    void reload()
+    {
+        m_buildShader.reload();
+        m_copyShader.reload();
+        m_cullShader.reload();
+    }
+
+    // levels down to 1x1
+    static unsigned levelCount(unsigned width, unsigned height)
+    {
+        unsigned levels = 1;
+        while ((std::max(width, height) >> levels) > 0)
+        {
+            ++levels;
+        }
+        return levels;
+    }
+
+    const dc::Texture* hiZ() const { return &m_hiZ; }
+    size_t instanceCount() const { return m_instanceCount; }
+
+    // frustum and previous frame's Hi-Z test of every instance, fills the commands of pass 0
+    void cullEarly(const dc::Mesh& mesh, const std::vector<glm::mat4>& instances, const glm::mat4& viewProjection)
+    {
+        upload(mesh, instances);
+        m_viewProjection = viewProjection;
+        dispatchCull(mesh, 0, m_hasHistory);
+    }
+
+    // retests the instances the early pass found occluded against the depth drawn since, fills the commands of pass 1
+    void cullLate(const dc::Mesh& mesh, const dc::Texture* depth)
+    {
+        build(depth);
+        dispatchCull(mesh, 1, true);
+    }
+
+    // keeps the final depth of the frame as the history of the next one
+    void endFrame(const dc::Texture* depth)
+    {
+        build(depth);
+        m_depthViewProjection = m_viewProjection;
+        m_hasHistory = true;
+    }
+
+    // draws the instances one pass found visible, shader being vertex.glsl built with GPU_INSTANCES,
+    // materialIds as for dc::Mesh::draw
+    void draw(const dc::Mesh& mesh, const dc::Shader& shader, unsigned pass, unsigned materialIds) const
+    {
+        glActiveTexture(GL_TEXTURE0 + VisibleIdsUnit);
+        glBindTexture(GL_TEXTURE_BUFFER, m_visibleIdsTexture);
+        glActiveTexture(GL_TEXTURE0 + InstanceModelsUnit);
+        glBindTexture(GL_TEXTURE_BUFFER, m_instanceModelsTexture);
+        glActiveTexture(GL_TEXTURE0);
+
+        shader.setInt("visibleIds", VisibleIdsUnit);
+        shader.setInt("instanceModels", InstanceModelsUnit);
+        shader.setInt("visibleOffset", static_cast<int>(pass * m_instanceCount));
+        m_commands->bind(GL_DRAW_INDIRECT_BUFFER);
+        mesh.drawIndirect(shader, pass * mesh.groups().size() * CommandSize, materialIds);
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+    }
+
+    // synchronous, the states of the last culled frame
+    std::vector<State> readStates() const
+    {
+        std::vector<GLuint> states(m_instanceCount);
+        dc::gl43().memoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+        if (!states.empty())
+            m_states->read(0, sizeof(GLuint) * states.size(), states.data());
+        std::vector<State> result;
+        for (GLuint it : states)
+        {
+            result.push_back(static_cast<State>(it));
+        }
+        return result;
+    }
+
+private:
+    // DrawElementsIndirectCommand
+    static const size_t CommandSize = sizeof(GLuint) * 5;
+
+    dc::Shader m_buildShader;
+    dc::Shader m_copyShader;
+    dc::Shader m_cullShader;
+    dc::Texture m_hiZ;
+
+    std::unique_ptr<dc::Buffer> m_instances;
+    std::unique_ptr<dc::Buffer> m_states;
+    std::unique_ptr<dc::Buffer> m_commands;
+    std::unique_ptr<dc::Buffer> m_visibleIds;
+    GLuint m_visibleIdsTexture;
+    GLuint m_instanceModelsTexture;
+    size_t m_instanceCount = 0;
+    size_t m_capacity = 0;
+    size_t m_groupCapacity = 0;
+    std::vector<glm::mat4> m_uploaded;
+    std::vector<GLuint> m_resetCommands;
+
+    glm::mat4 m_viewProjection;
+    glm::mat4 m_depthViewProjection;
+    bool m_hasHistory = false;
+
+    // instance matrices are only uploaded when they changed, commands are reset every frame
+    void upload(const dc::Mesh& mesh, const std::vector<glm::mat4>& instances)
+    {
+        size_t groups = mesh.groups().size();
+        if (instances.size() > m_capacity)
+        {
+            m_capacity = instances.size();
+            m_instances.reset(new dc::Buffer(GL_SHADER_STORAGE_BUFFER, sizeof(glm::mat4) * m_capacity, nullptr, GL_DYNAMIC_DRAW));
+            m_states.reset(new dc::Buffer(GL_SHADER_STORAGE_BUFFER, sizeof(GLuint) * m_capacity, nullptr, GL_DYNAMIC_COPY));
+            // the ids of both passes
+            m_visibleIds.reset(new dc::Buffer(GL_SHADER_STORAGE_BUFFER, sizeof(GLuint) * 2 * m_capacity, nullptr, GL_DYNAMIC_COPY));
+            m_uploaded.clear();
+        }
+        if (!m_commands || groups > m_groupCapacity)
+        {
+            m_groupCapacity = std::max<size_t>(groups, 1);
+            m_commands.reset(new dc::Buffer(GL_SHADER_STORAGE_BUFFER, CommandSize * 2 * m_groupCapacity, nullptr, GL_DYNAMIC_COPY));
+        }
+        if (instances != m_uploaded && !instances.empty())
+        {
+            m_instances->upload(0, sizeof(glm::mat4) * instances.size(), instances.data());
+            m_uploaded = instances;
+        }
+        m_instanceCount = instances.size();
+
+        // views are rebound since the buffers may have been recreated, which is cheap
+        glBindTexture(GL_TEXTURE_BUFFER, m_visibleIdsTexture);
+        glTexBuffer(GL_TEXTURE_BUFFER, GL_R32UI, m_visibleIds ? m_visibleIds->id() : 0);
+        glBindTexture(GL_TEXTURE_BUFFER, m_instanceModelsTexture);
+        glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, m_instances ? m_instances->id() : 0);
+        glBindTexture(GL_TEXTURE_BUFFER, 0);
+
+        m_resetCommands.clear();
+        for (unsigned pass = 0; pass < 2; ++pass)
+        {
+            for (const auto& it : mesh.groups())
+            {
+                m_resetCommands.insert(m_resetCommands.end(), { static_cast<GLuint>(it.count), 0u, static_cast<GLuint>(it.offset), 0u, 0u });
+            }
+        }
+        if (!m_resetCommands.empty())
+            m_commands->upload(0, sizeof(GLuint) * m_resetCommands.size(), m_resetCommands.data());
+    }
+
+    void dispatchCull(const dc::Mesh& mesh, unsigned pass, bool testDepth)
+    {
+        if (m_instanceCount == 0)
+            return;
+
+        m_instances->bindBase(GL_SHADER_STORAGE_BUFFER, 0);
+        m_states->bindBase(GL_SHADER_STORAGE_BUFFER, 1);
+        m_commands->bindBase(GL_SHADER_STORAGE_BUFFER, 2);
+        m_visibleIds->bindBase(GL_SHADER_STORAGE_BUFFER, 3);
+        glActiveTexture(GL_TEXTURE0 + DepthUnit);
+        m_hiZ.bind();
+        glActiveTexture(GL_TEXTURE0);
+
+        m_cullShader.use();
+        m_cullShader.setInt("instanceCount", static_cast<int>(m_instanceCount));
+        m_cullShader.setInt("groupCount", static_cast<int>(mesh.groups().size()));
+        m_cullShader.setInt("pass", static_cast<int>(pass));
+        m_cullShader.setInt("testDepth", testDepth);
+        m_cullShader.setInt("hiZ", DepthUnit);
+        m_cullShader.setVec3("boundsMin", mesh.boundsMin());
+        m_cullShader.setVec3("boundsMax", mesh.boundsMax());
+        m_cullShader.setMat4("viewProjection", m_viewProjection);
+        m_cullShader.setMat4("depthViewProjection", m_depthViewProjection);
+        dc::gl43().dispatchCompute(static_cast<GLuint>((m_instanceCount + 63) / 64), 1, 1);
+        // the commands and ids are read by the draw, the buffer textures of the vertex shader and the next pass
+        dc::gl43().memoryBarrier(GL_COMMAND_BARRIER_BIT | GL_SHADER_STORAGE_BARRIER_BIT | GL_TEXTURE_FETCH_BARRIER_BIT);
+        glUseProgram(0);
+    }
+
+    // level 0 is the maximum of every 2x2 depth texels, every further level that of the one above
+    void build(const dc::Texture* depth)
+    {
+        const unsigned groupSize = 8;
+        glActiveTexture(GL_TEXTURE0 + DepthUnit);
+        depth->bind();
+        glActiveTexture(GL_TEXTURE0);
+
+        m_copyShader.use();
+        m_copyShader.setInt("depthTexture", DepthUnit);
+        m_copyShader.setInt("targetLevel", 1);
+        dc::gl43().bindImageTexture(1, m_hiZ.id(), 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_R32F);
+        dc::gl43().dispatchCompute((m_hiZ.width() + groupSize - 1) / groupSize, (m_hiZ.height() + groupSize - 1) / groupSize, 1);
+
+        m_buildShader.use();
+        m_buildShader.setInt("sourceLevel", 0);
+        m_buildShader.setInt("targetLevel", 1);
+        for (unsigned level = 1; level < m_hiZ.levels(); ++level)
+        {
+            unsigned w = std::max(m_hiZ.width() >> level, 1u);
+            unsigned h = std::max(m_hiZ.height() >> level, 1u);
+            dc::gl43().memoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+            dc::gl43().bindImageTexture(0, m_hiZ.id(), level - 1, GL_FALSE, 0, GL_READ_ONLY, GL_R32F);
+            dc::gl43().bindImageTexture(1, m_hiZ.id(), level, GL_FALSE, 0, GL_WRITE_ONLY, GL_R32F);
+            dc::gl43().dispatchCompute((w + groupSize - 1) / groupSize, (h + groupSize - 1) / groupSize, 1);
+        }
+        dc::gl43().memoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+        glUseProgram(0);
+    }
+};
\ No newline at end of file
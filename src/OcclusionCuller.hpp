@@ -0,0 +1,460 @@
+#pragma once
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include <dc/Mesh.hpp>
+#include <dc/Simd.hpp>
+
+// Axis aligned bounds of a mesh in its own space
+struct Bounds
+{
+    glm::vec3 min{ std::numeric_limits<float>::max() };
+    glm::vec3 max{ -std::numeric_limits<float>::max() };
+
+    static Bounds of(const dc::MeshData& mesh)
+    {
+        Bounds bounds;
+        for (const auto& it : mesh.vertices)
+        {
+            bounds.min = glm::min(bounds.min, it.position);
+            bounds.max = glm::max(bounds.max, it.position);
+        }
+        return bounds;
+    }
+
+    // true for closed boxes, whose bounds are their exact geometry and so a safe occluder
+    static bool filledBy(const dc::MeshData& mesh, const Bounds& bounds)
+    {
+        if (mesh.indices.size() < 36)
+            return false;
+        std::vector<glm::vec3> corners;
+        for (const auto& it : mesh.vertices)
+        {
+            glm::bvec3 onMin = glm::equal(it.position, bounds.min);
+            glm::bvec3 onMax = glm::equal(it.position, bounds.max);
+            if (!(onMin.x || onMax.x) || !(onMin.y || onMax.y) || !(onMin.z || onMax.z))
+                return false;
+            if (std::find(corners.begin(), corners.end(), it.position) == corners.end())
+                corners.push_back(it.position);
+        }
+        return corners.size() == 8;
+    }
+
+    glm::vec3 corner(unsigned i) const
+    {
+        return { i & 1 ? max.x : min.x, i & 2 ? max.y : min.y, i & 4 ? max.z : min.z };
+    }
+};
+
+// Masked software occlusion culling after Hasselgren et al.: a few large occluders are
+// rasterized into a low resolution buffer of 8x8 pixel tiles, and object bounds are tested
+// against it before anything is submitted. A tile keeps no per-pixel depth, only
+//  - zMax0, the farthest occluder depth over the whole tile,
+//  - a working layer of the pixels covered since zMax0 was last lowered, as a 64 bit
+//    coverage mask and the farthest depth zMax1 among them.
+// Once the working layer covers the whole tile, zMax1 becomes the new zMax0. Coverage is
+// computed several pixels per step over dc::simd lanes, the tile test compares whole rows
+// of tiles at once. Depth is window depth, 0 at the near plane.
+class OcclusionCuller
+{
+public:
+    static const unsigned TileSize = 8;
+
+    struct Object
+    {
+        Bounds bounds;
+        glm::mat4 model;
+        // its bounds may be rasterized as an occluder, see Bounds::filledBy
+        bool occluder;
+    };
+
+    struct Stats
+    {
+        size_t objects = 0;
+        size_t frustumCulled = 0;
+        size_t occluded = 0;
+        size_t occluders = 0;
+        size_t occluderTriangles = 0;
+        // bounds tested against the depth tiles, i.e. objects inside the frustum
+        size_t tested = 0;
+        double projectMs = 0.0;
+        double rasterMs = 0.0;
+        double testMs = 0.0;
+
+        size_t visible() const { return objects - frustumCulled - occluded; }
+        double totalMs() const { return projectMs + rasterMs + testMs; }
+    };
+
+    // occluders whose bounding sphere covers less of the view than this are not rasterized
+    float minOccluderSize = 0.05f;
+    size_t maxOccluders = 128;
+
+    OcclusionCuller(unsigned width = 320, unsigned height = 180)
+        : m_width(width), m_height(height),
+          m_tilesX((width + TileSize - 1) / TileSize),
+          m_tilesY((height + TileSize - 1) / TileSize),
+          m_zMax0(m_tilesX * m_tilesY),
+          m_zMax1(m_zMax0.size()),
+          m_mask(m_zMax0.size())
+    {
+    }
+
+    unsigned width() const { return m_width; }
+    unsigned height() const { return m_height; }
+    const Stats& stats() const { return m_stats; }
+
+    // indices of the objects that may be visible from view, in their original order
+    const std::vector<unsigned>& cull(const std::vector<Object>& objects, const glm::mat4& view, const glm::mat4& projection)
+    {
+        m_stats = Stats();
+        m_stats.objects = objects.size();
+        m_visible.clear();
+
+        auto start = Clock::now();
+        glm::mat4 viewProjection = projection * view;
+        m_rects.resize(objects.size());
+        for (size_t i = 0; i < objects.size(); ++i)
+        {
+            m_rects[i] = project(objects[i], viewProjection);
+            if (m_rects[i].outside)
+                ++m_stats.frustumCulled;
+        }
+        auto projected = Clock::now();
+
+        clear();
+        glm::vec3 eye = glm::vec3(glm::inverse(view)[3]);
+        for (unsigned i : selectOccluders(objects, eye))
+        {
+            rasterizeBox(objects[i], viewProjection);
+        }
+        auto rasterized = Clock::now();
+
+        for (size_t i = 0; i < objects.size(); ++i)
+        {
+            const ScreenRect& rect = m_rects[i];
+            if (rect.outside)
+                continue;
+            ++m_stats.tested;
+            if (!rect.nearClipped && occluded(rect))
+            {
+                ++m_stats.occluded;
+                continue;
+            }
+            m_visible.push_back(static_cast<unsigned>(i));
+        }
+        auto tested = Clock::now();
+
+        m_stats.projectMs = milliseconds(start, projected);
+        m_stats.rasterMs = milliseconds(projected, rasterized);
+        m_stats.testMs = milliseconds(rasterized, tested);
+        return m_visible;
+    }
+
+    // zMax0 of every tile as 8 bit grey, 255 where nothing occludes, bottom row first
+    std::vector<unsigned char> depthImage() const
+    {
+        std::vector<unsigned char> image(static_cast<size_t>(m_width) * m_height);
+        for (unsigned y = 0; y < m_height; ++y)
+        {
+            for (unsigned x = 0; x < m_width; ++x)
+            {
+                float z = m_zMax0[(y / TileSize) * m_tilesX + x / TileSize];
+                image[static_cast<size_t>(y) * m_width + x] = static_cast<unsigned char>(z * 255.0f + 0.5f);
+            }
+        }
+        return image;
+    }
+
+private:
+    typedef std::chrono::high_resolution_clock Clock;
+
+    // screen footprint of an object's bounds in tiles, with its nearest depth
+    struct ScreenRect
+    {
+        int tileX0, tileY0, tileX1, tileY1;
+        float zMin;
+        bool outside;
+        // some corner lies behind the near plane, the object is kept without a test
+        bool nearClipped;
+    };
+
+    static double milliseconds(Clock::time_point from, Clock::time_point to)
+    {
+        return std::chrono::duration<double, std::milli>(to - from).count();
+    }
+
+    ScreenRect project(const Object& object, const glm::mat4& viewProjection) const
+    {
+        ScreenRect rect = { 0, 0, -1, -1, 1.0f, false, false };
+        glm::mat4 mvp = viewProjection * object.model;
+        // corners outside each of the six clip planes, all eight outside one plane culls
+        unsigned outside[6] = {};
+        glm::vec2 lo(std::numeric_limits<float>::max());
+        glm::vec2 hi(-std::numeric_limits<float>::max());
+        for (unsigned i = 0; i < 8; ++i)
+        {
+            glm::vec4 clip = mvp * glm::vec4(object.bounds.corner(i), 1.0f);
+            outside[0] += clip.x < -clip.w;
+            outside[1] += clip.x > clip.w;
+            outside[2] += clip.y < -clip.w;
+            outside[3] += clip.y > clip.w;
+            outside[4] += clip.z < -clip.w;
+            outside[5] += clip.z > clip.w;
+            if (clip.w <= NearW)
+            {
+                rect.nearClipped = true;
+                continue;
+            }
+            glm::vec3 ndc = glm::vec3(clip) / clip.w;
+            lo = glm::min(lo, glm::vec2(ndc));
+            hi = glm::max(hi, glm::vec2(ndc));
+            rect.zMin = std::min(rect.zMin, ndc.z * 0.5f + 0.5f);
+        }
+        for (unsigned count : outside)
+        {
+            rect.outside = rect.outside || count == 8;
+        }
+        if (rect.outside || rect.nearClipped)
+            return rect;
+
+        // pixels whose centers could be touched, then the tiles holding them
+        float x0 = std::floor((lo.x * 0.5f + 0.5f) * m_width);
+        float y0 = std::floor((lo.y * 0.5f + 0.5f) * m_height);
+        float x1 = std::ceil((hi.x * 0.5f + 0.5f) * m_width);
+        float y1 = std::ceil((hi.y * 0.5f + 0.5f) * m_height);
+        rect.tileX0 = static_cast<int>(std::max(x0, 0.0f)) / TileSize;
+        rect.tileY0 = static_cast<int>(std::max(y0, 0.0f)) / TileSize;
+        rect.tileX1 = static_cast<int>(std::min(x1, static_cast<float>(m_width - 1))) / TileSize;
+        rect.tileY1 = static_cast<int>(std::min(y1, static_cast<float>(m_height - 1))) / TileSize;
+        return rect;
+    }
+
+    // the largest occluders by how much of the view their bounding sphere spans
+    std::vector<unsigned> selectOccluders(const std::vector<Object>& objects, const glm::vec3& eye) const
+    {
+        std::vector<std::pair<float, unsigned>> candidates;
+        for (size_t i = 0; i < objects.size(); ++i)
+        {
+            const Object& object = objects[i];
+            if (!object.occluder || m_rects[i].outside)
+                continue;
+            glm::vec3 center = glm::vec3(object.model * glm::vec4((object.bounds.min + object.bounds.max) * 0.5f, 1.0f));
+            float radius = glm::length(glm::mat3(object.model) * (object.bounds.max - object.bounds.min)) * 0.5f;
+            float size = radius / std::max(glm::length(center - eye), 1e-3f);
+            if (size >= minOccluderSize)
+                candidates.push_back({ size, static_cast<unsigned>(i) });
+        }
+        size_t count = std::min(candidates.size(), maxOccluders);
+        std::partial_sort(candidates.begin(), candidates.begin() + count, candidates.end(),
+            [](const std::pair<float, unsigned>& a, const std::pair<float, unsigned>& b) { return a.first > b.first; });
+
+        std::vector<unsigned> occluders;
+        for (size_t i = 0; i < count; ++i)
+        {
+            occluders.push_back(candidates[i].second);
+        }
+        return occluders;
+    }
+
+    void clear()
+    {
+        std::fill(m_zMax0.begin(), m_zMax0.end(), 1.0f);
+        std::fill(m_zMax1.begin(), m_zMax1.end(), 0.0f);
+        std::fill(m_mask.begin(), m_mask.end(), 0);
+    }
+
+    void rasterizeBox(const Object& object, const glm::mat4& viewProjection)
+    {
+        // counter-clockwise from outside, corner i has bit 0 for x, 1 for y, 2 for z
+        static const unsigned char faces[36] =
+        {
+            0, 4, 6, 0, 6, 2,  1, 3, 7, 1, 7, 5,
+            0, 1, 5, 0, 5, 4,  2, 6, 7, 2, 7, 3,
+            0, 2, 3, 0, 3, 1,  4, 5, 7, 4, 7, 6
+        };
+
+        glm::mat4 mvp = viewProjection * object.model;
+        glm::vec4 clip[8];
+        for (unsigned i = 0; i < 8; ++i)
+        {
+            clip[i] = mvp * glm::vec4(object.bounds.corner(i), 1.0f);
+        }
+        ++m_stats.occluders;
+        for (unsigned i = 0; i < 36; i += 3)
+        {
+            const glm::vec4& a = clip[faces[i]];
+            const glm::vec4& b = clip[faces[i + 1]];
+            const glm::vec4& c = clip[faces[i + 2]];
+            // dropping triangles that reach behind the near plane only ever occludes less
+            if (a.w <= NearW || b.w <= NearW || c.w <= NearW)
+                continue;
+            rasterizeTriangle(toScreen(a), toScreen(b), toScreen(c));
+        }
+    }
+
+    glm::vec3 toScreen(const glm::vec4& clip) const
+    {
+        glm::vec3 ndc = glm::vec3(clip) / clip.w;
+        return { (ndc.x * 0.5f + 0.5f) * m_width, (ndc.y * 0.5f + 0.5f) * m_height, ndc.z * 0.5f + 0.5f };
+    }
+
+    void rasterizeTriangle(const glm::vec3& v0, const glm::vec3& v1, const glm::vec3& v2)
+    {
+        float area = (v1.x - v0.x) * (v2.y - v0.y) - (v2.x - v0.x) * (v1.y - v0.y);
+        if (area <= 0.0f)
+            return;
+
+        int tileX0 = std::max(static_cast<int>(std::floor(std::min({ v0.x, v1.x, v2.x }))), 0) / static_cast<int>(TileSize);
+        int tileY0 = std::max(static_cast<int>(std::floor(std::min({ v0.y, v1.y, v2.y }))), 0) / static_cast<int>(TileSize);
+        int tileX1 = std::min(static_cast<int>(std::ceil(std::max({ v0.x, v1.x, v2.x }))), static_cast<int>(m_width) - 1) / static_cast<int>(TileSize);
+        int tileY1 = std::min(static_cast<int>(std::ceil(std::max({ v0.y, v1.y, v2.y }))), static_cast<int>(m_height) - 1) / static_cast<int>(TileSize);
+        if (tileX0 > tileX1 || tileY0 > tileY1)
+            return;
+        ++m_stats.occluderTriangles;
+
+        Triangle triangle;
+        const glm::vec3* v[3] = { &v0, &v1, &v2 };
+        for (unsigned i = 0; i < 3; ++i)
+        {
+            const glm::vec3& p = *v[i];
+            const glm::vec3& q = *v[(i + 1) % 3];
+            triangle.a[i] = p.y - q.y;
+            triangle.b[i] = q.x - p.x;
+            triangle.c[i] = p.x * q.y - q.x * p.y;
+        }
+        // z = zx * x + zy * y + z0, window depth is affine in screen space
+        triangle.zx = ((v1.z - v0.z) * (v2.y - v0.y) - (v2.z - v0.z) * (v1.y - v0.y)) / area;
+        triangle.zy = ((v2.z - v0.z) * (v1.x - v0.x) - (v1.z - v0.z) * (v2.x - v0.x)) / area;
+        triangle.z0 = v0.z - triangle.zx * v0.x - triangle.zy * v0.y;
+        triangle.zMax = std::max({ v0.z, v1.z, v2.z });
+
+        for (int ty = tileY0; ty <= tileY1; ++ty)
+        {
+            for (int tx = tileX0; tx <= tileX1; ++tx)
+            {
+                uint64_t coverage = tileCoverage(triangle, tx * TileSize, ty * TileSize);
+                if (coverage != 0)
+                    updateTile(ty * m_tilesX + tx, coverage, tileDepth(triangle, tx * TileSize, ty * TileSize));
+            }
+        }
+    }
+
+    struct Triangle
+    {
+        // edge functions a * x + b * y + c, positive inside
+        float a[3], b[3], c[3];
+        float zx, zy, z0;
+        float zMax;
+    };
+
+    // farthest depth of the triangle's plane over the tile, which is at one of its corners
+    static float tileDepth(const Triangle& triangle, unsigned x0, unsigned y0)
+    {
+        float x1 = static_cast<float>(x0 + TileSize);
+        float y1 = static_cast<float>(y0 + TileSize);
+        float z = std::max({ triangle.zx * x0 + triangle.zy * y0, triangle.zx * x1 + triangle.zy * y0,
+            triangle.zx * x0 + triangle.zy * y1, triangle.zx * x1 + triangle.zy * y1 }) + triangle.z0;
+        return std::min(z, triangle.zMax);
+    }
+
+    static uint64_t tileCoverage(const Triangle& triangle, unsigned x0, unsigned y0)
+    {
+#if defined(DC_AVX2)
+        return tileCoverage<dc::simd::Float8>(triangle, x0, y0);
+#elif defined(DC_SSE2)
+        return tileCoverage<dc::simd::Float4>(triangle, x0, y0);
+#else
+        return tileCoverage<dc::simd::Float1>(triangle, x0, y0);
+#endif
+    }
+
+    // bit y * 8 + x set where the pixel center lies inside the triangle
+    template<typename V>
+    static uint64_t tileCoverage(const Triangle& triangle, unsigned x0, unsigned y0)
+    {
+        uint64_t coverage = 0;
+        for (unsigned lane = 0; lane < TileSize; lane += V::Width)
+        {
+            V x = V(x0 + lane + 0.5f) + V::ramp();
+            V ea[3];
+            for (unsigned e = 0; e < 3; ++e)
+            {
+                ea[e] = V(triangle.a[e]) * x + V(triangle.c[e]);
+            }
+            for (unsigned row = 0; row < TileSize; ++row)
+            {
+                float y = y0 + row + 0.5f;
+                unsigned inside = dc::simd::bits((ea[0] + V(triangle.b[0] * y) >= V(0.0f)) & (ea[1] + V(triangle.b[1] * y) >= V(0.0f))
+                    & (ea[2] + V(triangle.b[2] * y) >= V(0.0f)));
+                coverage |= static_cast<uint64_t>(inside) << (row * TileSize + lane);
+            }
+        }
+        return coverage;
+    }
+
+    void updateTile(unsigned tile, uint64_t coverage, float zMax)
+    {
+        // nothing nearer than what already occludes the whole tile
+        if (zMax >= m_zMax0[tile])
+            return;
+        m_mask[tile] |= coverage;
+        m_zMax1[tile] = std::max(m_zMax1[tile], zMax);
+        if (m_mask[tile] == ~uint64_t(0))
+        {
+            m_zMax0[tile] = m_zMax1[tile];
+            m_zMax1[tile] = 0.0f;
+            m_mask[tile] = 0;
+        }
+    }
+
+    bool occluded(const ScreenRect& rect) const
+    {
+        unsigned count = rect.tileX1 - rect.tileX0 + 1;
+        for (int ty = rect.tileY0; ty <= rect.tileY1; ++ty)
+        {
+            const float* row = &m_zMax0[ty * m_tilesX + rect.tileX0];
+            if (anyNotNearer(row, count, rect.zMin))
+                return false;
+        }
+        return true;
+    }
+
+    // whether some tile's occluders reach as far back as zMin
+    static bool anyNotNearer(const float* zMax, unsigned count, float zMin)
+    {
+        unsigned x = 0;
+#if defined(DC_SSE2)
+        for (; x + 4 <= count; x += 4)
+        {
+            if (dc::simd::bits(dc::simd::Float4::load(zMax + x) >= dc::simd::Float4(zMin)))
+                return true;
+        }
+#endif
+        for (; x < count; ++x)
+        {
+            if (zMax[x] >= zMin)
+                return true;
+        }
+        return false;
+    }
+
+    // clip w below which a point counts as behind the camera
+    static constexpr float NearW = 1e-3f;
+
+    unsigned m_width;
+    unsigned m_height;
+    unsigned m_tilesX;
+    unsigned m_tilesY;
+    std::vector<float> m_zMax0;
+    std::vector<float> m_zMax1;
+    std::vector<uint64_t> m_mask;
+    std::vector<ScreenRect> m_rects;
+    std::vector<unsigned> m_visible;
+    Stats m_stats;
+};
\ No newline at end of file
@@ -0,0 +1,25 @@
+#pragma once
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <cmath>
+
+// Orbits target at distance, elevation is the angle from the up axis in radians
+struct OrbitCamera
+{
+    glm::vec3 target;
+    float azimuth;
+    float elevation;
+    float distance;
+    bool moving;
+
+    int lastX;
+    int lastY;
+
+    glm::mat4 getViewMatrix() const
+    {
+        glm::vec3 eyePos{ std::sin(elevation) * std::cos(azimuth), std::cos(elevation), std::sin(elevation) * std::sin(azimuth) };
+        eyePos *= distance;
+        return glm::lookAt(target + eyePos, target, { 0.0f, 1.0f, 0.0f });
+    }
+};
\ No newline at end of file
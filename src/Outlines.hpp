@@ -0,0 +1,218 @@
+#pragma once
+#include <glad/glad.h>
+
+#include <cmath>
+#include <functional>
+#include <iomanip>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include <dc/FrameBuffer.hpp>
+#include <dc/Shader.hpp>
+
+// Wide outlines from a jump flood distance field. The edge detection of sobel.glsl seeds
+// the field with the coordinates of edge pixels, log2(width) flood passes propagate the
+// nearest seed to every pixel, and sobel.glsl (OUTLINE_DISTANCE) draws a stroke of the
+// requested width around the seeds. Cost grows with log2 of the width instead of the
+// width squared of a wide kernel.
+class JumpFloodOutlines
+{
+public:
+    // post process inputs (g-buffer samplers and palette) are bound through setInputs
+    typedef std::function<void(const dc::Shader&)> InputBinder;
+
+    JumpFloodOutlines(unsigned width, unsigned height, std::vector<std::string> gbufferDefines)
+        : m_floodShader({ { dc::ShaderStage::Vertex, "quad.glsl" },{ dc::ShaderStage::Fragment, "jump_flood.glsl" } }),
+          m_naiveShader({ { dc::ShaderStage::Vertex, "quad.glsl" },{ dc::ShaderStage::Fragment, "outline_naive.glsl" } })
+    {
+        gbufferDefines.push_back("EDGE_SEEDS");
+        m_seedShader.reset(new dc::Shader({ { dc::ShaderStage::Vertex, "quad.glsl" },{ dc::ShaderStage::Fragment, "sobel.glsl" } }, gbufferDefines));
+
+        for (auto& it : m_targets)
+        {
+            it.reset(new dc::FrameBuffer(width, height, { { dc::FBAttachmentType::AttachColor, dc::TextureFormat::RG16UI } }));
+        }
+    }
+
+    JumpFloodOutlines(const JumpFloodOutlines& other) = delete;
+    JumpFloodOutlines& operator=(const JumpFloodOutlines& other) = delete;
+
+    void reload()
+    {
+        m_seedShader->reload();
+        m_floodShader.reload();
+        m_naiveShader.reload();
+    }
+
+    // flood steps needed to cover a stroke of the given width, equals log2(width) rounded up
+    static unsigned passCount(float width)
+    {
+        unsigned passes = 0;
+        for (int step = firstStep(width); step >= 1; step /= 2)
+        {
+            ++passes;
+        }
+        return passes;
+    }
+
+    // runs edge detection into the seed target, expects quadVAO to be bound
+    void seed(const InputBinder& setInputs)
+    {
+        m_targets[0]->bind();
+        glViewport(0, 0, m_targets[0]->width(), m_targets[0]->height());
+        setInputs(*m_seedShader);
+        glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+        m_targets[0]->unbind();
+        m_current = 0;
+    }
+
+    // floods from the last seed() and returns the nearest seed texture, expects quadVAO to be bound
+    const dc::Texture* flood(float width)
+    {
+        m_current = 0;
+        m_floodShader.use();
+        glActiveTexture(GL_TEXTURE4);
+        m_floodShader.setInt("seedTexture", 4);
+        for (int step = firstStep(width); step >= 1; step /= 2)
+        {
+            m_floodShader.setInt("stepSize", step);
+            pingPong();
+        }
+        glActiveTexture(GL_TEXTURE0);
+        return m_targets[m_current]->texture(0);
+    }
+
+    // brute force reference for flood()
+    const dc::Texture* floodNaive(float width)
+    {
+        m_current = 0;
+        m_naiveShader.use();
+        glActiveTexture(GL_TEXTURE4);
+        m_naiveShader.setInt("seedTexture", 4);
+        m_naiveShader.setInt("radius", searchRadius(width));
+        pingPong();
+        glActiveTexture(GL_TEXTURE0);
+        return m_targets[m_current]->texture(0);
+    }
+
+    // times flood() against floodNaive() for widths 1 to 16 on the current seeds and counts the
+    // pixels whose stroke coverage differs between the two, expects quadVAO to be bound
+    void benchmark(std::ostream& out, const InputBinder& setInputs)
+    {
+        const unsigned repetitions = 10;
+        unsigned width = m_targets[0]->width();
+        unsigned height = m_targets[0]->height();
+        std::vector<GLushort> jumpFlood(width * height * 2);
+        std::vector<GLushort> naive(width * height * 2);
+
+        GLuint query;
+        glGenQueries(1, &query);
+        std::ios::fmtflags flags(out.flags());
+        std::streamsize precision = out.precision();
+
+        out << "outline width  passes  jump flood ms  naive ms  differing px" << std::endl;
+        for (unsigned strokeWidth = 1; strokeWidth <= 16; ++strokeWidth)
+        {
+            double jumpFloodMs = 0.0;
+            double naiveMs = 0.0;
+            for (unsigned i = 0; i < repetitions; ++i)
+            {
+                seed(setInputs);
+                jumpFloodMs += timed(query, [&]() { flood(static_cast<float>(strokeWidth)); });
+            }
+            readSeeds(jumpFlood);
+            for (unsigned i = 0; i < repetitions; ++i)
+            {
+                seed(setInputs);
+                naiveMs += timed(query, [&]() { floodNaive(static_cast<float>(strokeWidth)); });
+            }
+            readSeeds(naive);
+
+            unsigned differing = 0;
+            for (unsigned y = 0; y < height; ++y)
+            {
+                for (unsigned x = 0; x < width; ++x)
+                {
+                    unsigned index = (y * width + x) * 2;
+                    bool a = covered(&jumpFlood[index], x, y, static_cast<float>(strokeWidth));
+                    bool b = covered(&naive[index], x, y, static_cast<float>(strokeWidth));
+                    differing += (a != b) ? 1 : 0;
+                }
+            }
+
+            out << std::setw(13) << strokeWidth << std::setw(8) << passCount(static_cast<float>(strokeWidth))
+                << std::fixed << std::setprecision(3) << std::setw(15) << jumpFloodMs / repetitions
+                << std::setw(10) << naiveMs / repetitions << std::setw(14) << differing << std::endl;
+        }
+        out.flags(flags);
+        out.precision(precision);
+
+        glDeleteQueries(1, &query);
+    }
+
+private:
+    static const GLushort NoSeed = 0xFFFF;
+
+    std::unique_ptr<dc::Shader> m_seedShader;
+    dc::Shader m_floodShader;
+    dc::Shader m_naiveShader;
+    std::unique_ptr<dc::FrameBuffer> m_targets[2];
+    unsigned m_current = 0;
+
+    // farthest pixel that still gets stroke coverage in sobel.glsl
+    static int searchRadius(float width)
+    {
+        return static_cast<int>(std::ceil(width * 0.5f + 0.5f));
+    }
+
+    static int firstStep(float width)
+    {
+        int step = 1;
+        while (step * 2 <= searchRadius(width))
+        {
+            step *= 2;
+        }
+        return step;
+    }
+
+    void pingPong()
+    {
+        unsigned next = 1 - m_current;
+        m_targets[next]->bind();
+        glViewport(0, 0, m_targets[next]->width(), m_targets[next]->height());
+        m_targets[m_current]->texture(0)->bind();
+        glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+        m_targets[next]->unbind();
+        m_current = next;
+    }
+
+    void readSeeds(std::vector<GLushort>& seeds) const
+    {
+        m_targets[m_current]->bind();
+        glPixelStorei(GL_PACK_ALIGNMENT, 1);
+        glReadPixels(0, 0, m_targets[m_current]->width(), m_targets[m_current]->height(), GL_RG_INTEGER, GL_UNSIGNED_SHORT, seeds.data());
+        m_targets[m_current]->unbind();
+    }
+
+    static bool covered(const GLushort* seed, unsigned x, unsigned y, float width)
+    {
+        if (seed[0] == NoSeed)
+            return false;
+        float dx = static_cast<float>(seed[0]) - x;
+        float dy = static_cast<float>(seed[1]) - y;
+        return width * 0.5f + 0.5f - std::sqrt(dx * dx + dy * dy) > 0.0f;
+    }
+
+    // blocks until the GPU time of the commands issued by pass is known
+    static double timed(GLuint query, const std::function<void()>& pass)
+    {
+        glBeginQuery(GL_TIME_ELAPSED, query);
+        pass();
+        glEndQuery(GL_TIME_ELAPSED);
+        GLuint64 nanoseconds = 0;
+        glGetQueryObjectui64v(query, GL_QUERY_RESULT, &nanoseconds);
+        return nanoseconds / 1.0e6;
+    }
+};
\ No newline at end of file
@@ -0,0 +1,282 @@
+#pragma once
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include <imgui_helper.h>
+
+#include <cfloat>
+#include <chrono>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <dc/AllocationTracker.hpp>
+#include <dc/GpuResources.hpp>
+#include <dc/RenderStats.hpp>
+
+#include "FramePacer.hpp"
+#include "Renderer.hpp"
+
+#ifndef GL_GPU_MEMORY_INFO_TOTAL_AVAILABLE_MEMORY_NVX
+#define GL_GPU_MEMORY_INFO_TOTAL_AVAILABLE_MEMORY_NVX 0x9048
+#define GL_GPU_MEMORY_INFO_CURRENT_AVAILABLE_VIDMEM_NVX 0x9049
+#endif
+#ifndef GL_TEXTURE_FREE_MEMORY_ATI
+#define GL_TEXTURE_FREE_MEMORY_ATI 0x87FC
+#endif
+
+// Performance window drawn with ImGui over the finished frame: CPU and GPU frame time
+// graphs, the GPU timer's passes, the submission counters, memory and the loaded model,
+// plus sliders for the settings worth tuning live. The graphs only advance on rendered
+// frames, so the window renders every frame while it is shown. The GPU graph takes the
+// newest sample per frame and the pass and latency statistics, which sort their windows,
+// are only refreshed twice a second like the title. Its own CPU and GPU time are measured like
+// everything else and shown at the bottom.
+class PerfOverlay
+{
+public:
+    // what the last model load cost, filled in by the window loop
+    struct LoadStats
+    {
+        std::string model;
+        double milliseconds = 0.0;
+        size_t vertices = 0;
+        size_t triangles = 0;
+        size_t groups = 0;
+    };
+
+    explicit PerfOverlay(GLFWwindow* window)
+    {
+        // the window's own callbacks forward to ImGui, see mouseButton and scroll
+        ImGuiHelper_Init(window, false);
+        ImGui::GetIO().IniFilename = nullptr;
+
+        GLint extensions = 0;
+        glGetIntegerv(GL_NUM_EXTENSIONS, &extensions);
+        for (GLint i = 0; i < extensions; ++i)
+        {
+            const char* name = reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, i));
+            if (std::strcmp(name, "GL_NVX_gpu_memory_info") == 0)
+                m_memoryInfo = Nvx;
+            else if (std::strcmp(name, "GL_ATI_meminfo") == 0)
+                m_memoryInfo = Ati;
+        }
+    }
+
+    ~PerfOverlay()
+    {
+        ImGuiHelper_Shutdown();
+    }
+
+    PerfOverlay(const PerfOverlay& other) = delete;
+    PerfOverlay& operator=(const PerfOverlay& other) = delete;
+
+    bool visible() const { return m_visible; }
+    void toggle() { m_visible = !m_visible; }
+
+    // true when ImGui takes the click, the camera should not see it then
+    bool mouseButton(GLFWwindow* window, int button, int action, int mods)
+    {
+        if (!m_visible)
+            return false;
+        ImGui_ImplGlfwGL3_MouseButtonCallback(window, button, action, mods);
+        return ImGui::GetIO().WantCaptureMouse;
+    }
+
+    bool scroll(GLFWwindow* window, double xoffset, double yoffset)
+    {
+        if (!m_visible)
+            return false;
+        ImGui_ImplGlfwGL3_ScrollCallback(window, xoffset, yoffset);
+        return ImGui::GetIO().WantCaptureMouse;
+    }
+
+    bool wantsMouse() const { return m_visible && ImGui::GetIO().WantCaptureMouse; }
+
+    // one rendered frame: the CPU time spent submitting it and the time since the last one
+    void addFrame(double cpuMilliseconds, double frameMilliseconds)
+    {
+        m_cpu[m_next] = static_cast<float>(cpuMilliseconds);
+        m_interval[m_next] = static_cast<float>(frameMilliseconds);
+        m_next = (m_next + 1) % HistorySize;
+    }
+
+    // builds and draws the window into the bound framebuffer, after the frame itself. The
+    // sliders write settings, which the next frame picks up, and fboDownscale, for which
+    // true is returned because the renderer has to be rebuilt
+    bool draw(Renderer& renderer, Renderer::Settings& settings, int& fboDownscale, const dc::RenderStats& stats, const LoadStats& load, const FramePacer& pacer)
+    {
+        if (!m_visible)
+            return false;
+
+        bool rebuild = false;
+        auto start = std::chrono::high_resolution_clock::now();
+        dc::GpuTimer& gpuTimer = renderer.gpuTimer();
+        gpuTimer.begin("overlay");
+        ImGuiHelper_NewFrame();
+
+        ImGui::SetNextWindowPos(ImVec2(10.0f, 10.0f), ImGuiCond_FirstUseEver);
+        ImGui::Begin("Performance", &m_visible, ImGuiWindowFlags_AlwaysAutoResize);
+
+        ImGui::PlotLines("CPU ms", m_cpu, HistorySize, m_next, nullptr, 0.0f, FLT_MAX, ImVec2(240.0f, 40.0f));
+        ImGui::PlotLines("frame ms", m_interval, HistorySize, m_next, nullptr, 0.0f, FLT_MAX, ImVec2(240.0f, 40.0f));
+        // the timer's samples lag a few frames behind, a frame only counts once its g-buffer pass arrived
+        double gbuffer = 0.0, post = 0.0;
+        uint64_t gpuSamples = gpuTimer.latest("g-buffer", gbuffer);
+        if (gpuSamples != m_gpuSamples)
+        {
+            gpuTimer.latest("post", post);
+            m_gpu[m_gpuNext] = static_cast<float>(gbuffer + post);
+            m_gpuNext = (m_gpuNext + 1) % HistorySize;
+            m_gpuSamples = gpuSamples;
+        }
+        ImGui::PlotLines("GPU ms", m_gpu, HistorySize, m_gpuNext, nullptr, 0.0f, FLT_MAX, ImVec2(240.0f, 40.0f));
+
+        if (std::chrono::duration<double>(start - m_statsTime).count() > StatsInterval)
+        {
+            m_passes.clear();
+            for (const auto& it : gpuTimer.passes())
+            {
+                m_passes.push_back({ it, gpuTimer.stats(it) });
+            }
+            m_latency = pacer.stats();
+            m_statsTime = start;
+        }
+
+        if (ImGui::CollapsingHeader("GPU passes", ImGuiTreeNodeFlags_DefaultOpen))
+        {
+            ImGui::Columns(4, "passes", false);
+            ImGui::Text("ms"); ImGui::NextColumn();
+            ImGui::Text("mean"); ImGui::NextColumn();
+            ImGui::Text("p95"); ImGui::NextColumn();
+            ImGui::Text("max"); ImGui::NextColumn();
+            for (const auto& it : m_passes)
+            {
+                const dc::GpuTimer::Stats& s = it.stats;
+                ImGui::Text("%s", it.name.c_str()); ImGui::NextColumn();
+                ImGui::Text("%.2f", s.mean); ImGui::NextColumn();
+                ImGui::Text("%.2f", s.p95); ImGui::NextColumn();
+                ImGui::Text("%.2f", s.max); ImGui::NextColumn();
+            }
+            ImGui::Columns(1);
+        }
+
+        if (ImGui::CollapsingHeader("Submission", ImGuiTreeNodeFlags_DefaultOpen))
+        {
+            ImGui::Text("%llu draw calls, %llu triangles", static_cast<unsigned long long>(stats.drawCalls), static_cast<unsigned long long>(stats.triangles));
+            ImGui::Text("%llu program binds, %llu uniforms", static_cast<unsigned long long>(stats.programBinds), static_cast<unsigned long long>(stats.uniforms));
+            ImGui::Text("%llu texture, %llu framebuffer binds", static_cast<unsigned long long>(stats.textureBinds), static_cast<unsigned long long>(stats.framebufferBinds));
+            ImGui::Text("%llu uploads, %.1f KB", static_cast<unsigned long long>(stats.bufferUploads), stats.bufferBytes / 1024.0);
+            // with DC_TRACK_ALLOCATIONS, what the renderer allocated since the last window
+            dc::AllocationTracker& tracker = dc::AllocationTracker::get();
+            if (tracker.installed())
+            {
+                dc::AllocationCounts frame = tracker.counts(dc::AllocationTag::Frame);
+                ImGui::Text("%llu heap allocations, %.1f KB", static_cast<unsigned long long>(frame.allocations - m_frameAllocations.allocations),
+                    (frame.bytes - m_frameAllocations.bytes) / 1024.0);
+                m_frameAllocations = frame;
+            }
+            // measured from reading the input, GLFW's events carry no time of their own
+            const FramePacer::Stats& latency = m_latency;
+            ImGui::Text("input to submit %.1f ms, to present %.1f ms, p99 %.1f", latency.submitMean, latency.presentMean, latency.presentP99);
+            ImGui::Text("frame interval %.2f ms, jitter %.2f ms", latency.intervalMean, latency.intervalJitter);
+            if (pacer.latencyMode())
+                ImGui::Text("latency mode, %u frames in flight, %.0f fps cap", pacer.framesInFlight(), pacer.frameCap());
+            else
+                ImGui::Text("vsync, latency mode off (L)");
+        }
+
+        if (ImGui::CollapsingHeader("Memory and model"))
+        {
+            const dc::GBuffer& g = renderer.gbuffer();
+            ImGui::Text("g-buffer %.1f MB", static_cast<double>(g.layout().bytesPerPixel()) * g.width() * g.height() / (1024.0 * 1024.0));
+            const dc::GpuResources& resources = dc::GpuResources::get();
+            dc::GpuResources::Totals tracked = resources.totals();
+            ImGui::Text("%zu GL objects, %.1f MB", tracked.count, tracked.bytes / (1024.0 * 1024.0));
+            for (int i = 0; i < static_cast<int>(dc::GpuResourceType::Count); ++i)
+            {
+                dc::GpuResources::Totals t = resources.totals(static_cast<dc::GpuResourceType>(i));
+                ImGui::BulletText("%s %zu, %.1f MB", dc::gpuResourceTypeName(static_cast<dc::GpuResourceType>(i)), t.count, t.bytes / (1024.0 * 1024.0));
+            }
+            GLint kilobytes[4] = {};
+            if (m_memoryInfo == Nvx)
+            {
+                GLint total = 0;
+                glGetIntegerv(GL_GPU_MEMORY_INFO_TOTAL_AVAILABLE_MEMORY_NVX, &total);
+                glGetIntegerv(GL_GPU_MEMORY_INFO_CURRENT_AVAILABLE_VIDMEM_NVX, kilobytes);
+                ImGui::Text("video memory %.0f of %.0f MB used", (total - kilobytes[0]) / 1024.0, total / 1024.0);
+            }
+            else if (m_memoryInfo == Ati)
+            {
+                glGetIntegerv(GL_TEXTURE_FREE_MEMORY_ATI, kilobytes);
+                ImGui::Text("%.0f MB free for textures", kilobytes[0] / 1024.0);
+            }
+            else
+            {
+                ImGui::Text("the driver does not report video memory");
+            }
+            ImGui::Text("%s", load.model.c_str());
+            ImGui::Text("loaded in %.1f ms, %zu vertices", load.milliseconds, load.vertices);
+            ImGui::Text("%zu triangles in %zu groups", load.triangles, load.groups);
+        }
+
+        if (ImGui::CollapsingHeader("Tuning", ImGuiTreeNodeFlags_DefaultOpen))
+        {
+            rebuild = ImGui::SliderInt("fbo downscale", &fboDownscale, 1, 4);
+            ImGui::SliderFloat("edge threshold", &settings.edgeThreshold, 0.005f, 0.5f, "%.3f", 2.0f);
+            ImGui::SliderFloat("fog start", &settings.fogStart, 1.0f, 200.0f, "%.0f");
+            ImGui::SliderFloat("fog end", &settings.fogEnd, 1.0f, 200.0f, "%.0f");
+            if (settings.fogEnd < settings.fogStart + 1.0f)
+                settings.fogEnd = settings.fogStart + 1.0f;
+        }
+
+        ImGui::Separator();
+        double overlayGpu = 0.0;
+        for (const auto& it : m_passes)
+        {
+            if (it.name == "overlay")
+                overlayGpu = it.stats.mean;
+        }
+        ImGui::Text("overlay %.3f ms CPU, %.3f ms GPU", m_ownMilliseconds, overlayGpu);
+        ImGui::End();
+
+        ImGui::Render();
+        gpuTimer.end();
+        m_ownMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+        return rebuild;
+    }
+
+    // CPU time of the last draw, building the window and submitting it
+    double ownMilliseconds() const { return m_ownMilliseconds; }
+
+private:
+    enum MemoryInfo
+    {
+        None,
+        Nvx,
+        Ati
+    };
+
+    struct PassStats
+    {
+        std::string name;
+        dc::GpuTimer::Stats stats;
+    };
+
+    static const size_t HistorySize = 120;
+    // seconds between refreshes of the statistics
+    static constexpr double StatsInterval = 0.5;
+
+    bool m_visible = false;
+    MemoryInfo m_memoryInfo = None;
+    float m_cpu[HistorySize] = {};
+    float m_interval[HistorySize] = {};
+    size_t m_next = 0;
+    float m_gpu[HistorySize] = {};
+    size_t m_gpuNext = 0;
+    uint64_t m_gpuSamples = 0;
+    std::vector<PassStats> m_passes;
+    FramePacer::Stats m_latency;
+    std::chrono::high_resolution_clock::time_point m_statsTime;
+    double m_ownMilliseconds = 0.0;
+    dc::AllocationCounts m_frameAllocations;
+};
\ No newline at end of file
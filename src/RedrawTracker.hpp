@@ -0,0 +1,86 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+// CPU time this process has used on all its threads, in seconds
+inline double processCpuSeconds()
+{
+#ifdef _WIN32
+    FILETIME creation, exit, kernel, user;
+    if (!GetProcessTimes(GetCurrentProcess(), &creation, &exit, &kernel, &user))
+        return 0.0;
+    auto seconds = [](const FILETIME& time) { return (static_cast<unsigned long long>(time.dwHighDateTime) << 32 | time.dwLowDateTime) * 1e-7; };
+    return seconds(kernel) + seconds(user);
+#else
+    timespec time;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &time);
+    return time.tv_sec + time.tv_nsec * 1e-9;
+#endif
+}
+
+// What changed since the window last presented a frame. Input, reloads and settings mark
+// it, and the render loop only renders what is marked: the whole frame when the camera,
+// the instances, the mesh or the geometry shaders changed, the post process alone when
+// only its settings did, and nothing at all otherwise, waiting for events instead.
+class RedrawTracker
+{
+public:
+    enum Level
+    {
+        Clean,
+        Post,
+        Full
+    };
+
+    struct Stats
+    {
+        size_t fullFrames = 0;
+        size_t postFrames = 0;
+        // loop iterations that rendered nothing
+        size_t idleWakeups = 0;
+    };
+
+    Level level() const { return m_level; }
+    const Stats& stats() const { return m_stats; }
+
+    // camera, instances, mesh or anything else the g-buffer depends on
+    void markScene()
+    {
+        m_level = Full;
+    }
+
+    // post process settings, or a window that needs its contents again
+    void markPost()
+    {
+        m_level = std::max(m_level, Post);
+    }
+
+    // call once per loop iteration after rendering what level() asked for
+    void presented()
+    {
+        if (m_level == Full)
+            ++m_stats.fullFrames;
+        else if (m_level == Post)
+            ++m_stats.postFrames;
+        else
+            ++m_stats.idleWakeups;
+        m_level = Clean;
+    }
+
+private:
+    // the first frame has to be rendered
+    Level m_level = Full;
+    Stats m_stats;
+};
\ No newline at end of file
@@ -0,0 +1,506 @@
+#pragma once
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <iostream>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include <dc/AllocationTracker.hpp>
+#include <dc/Buffer.hpp>
+#include <dc/FrameBuffer.hpp>
+#include <dc/GBuffer.hpp>
+#include <dc/GLExtensions.hpp>
+#include <dc/GpuResources.hpp>
+#include <dc/GpuTimer.hpp>
+#include <dc/Mesh.hpp>
+#include <dc/Profiler.hpp>
+#include <dc/Shader.hpp>
+
+#include "GeometryEdges.hpp"
+#include "HiZCulling.hpp"
+#include "Outlines.hpp"
+
+// The g-buffer and post process passes, shared by the window and the headless modes.
+// render() fills the g-buffer from a list of mesh instances and shades it into either the
+// default framebuffer or any dc::FrameBuffer of the output size.
+class Renderer
+{
+public:
+    // 8 or 16, tile size of the classified post process
+    static const unsigned ClassifyTileSize = 16;
+
+    struct Settings
+    {
+        // compute post process, only honored when GL 4.3 is available
+        bool useCompute = false;
+        // classification only pays off where skipped tiles skip real work, which llvmpipe does not
+        bool useTiles = false;
+        // creases and silhouettes from the mesh instead of sobel on the g-buffer
+        bool useGeometryEdges = false;
+        // stroke width in pixels, widths above 1 go through the jump flood
+        float outlineWidth = 1.0f;
+        // instances culled on the GPU against the previous frame's depth, only honored when GL 4.3 is available
+        bool useHiZ = false;
+        // depth of the instances sorted front to back first, so the g-buffer pass shades every
+        // pixel once. Not combined with useHiZ, which draws in the order the cull shader found
+        bool useDepthPrepass = false;
+        // counts the fragments the g-buffer pass shades per pixel in the stencil, see overdraw()
+        bool countOverdraw = false;
+        // gradient above which sobel draws an edge, and the linear depth range fog blends in over
+        float edgeThreshold = 0.05f;
+        float fogStart = 90.0f;
+        float fogEnd = 100.0f;
+    };
+
+    struct Overdraw
+    {
+        // shaded fragments over all pixels and over the pixels covered by any geometry
+        double perPixel;
+        double perCoveredPixel;
+        double coveredShare;
+    };
+
+    Settings settings;
+
+    Renderer(unsigned width, unsigned height, unsigned fboDownscale, const dc::GBufferLayout& layout, const glm::vec3& clearColor, bool computeSupported)
+        : m_width(width), m_height(height),
+          m_fboWidth(width / fboDownscale), m_fboHeight(height / fboDownscale),
+          m_tilesX((m_fboWidth + ClassifyTileSize - 1) / ClassifyTileSize),
+          m_tilesY((m_fboHeight + ClassifyTileSize - 1) / ClassifyTileSize),
+          m_clearColor(clearColor),
+          m_computeSupported(computeSupported),
+          m_shader({ { dc::ShaderStage::Vertex, "vertex.glsl" },{ dc::ShaderStage::Fragment, "fragment.glsl" } }, layout.shaderDefines()),
+          m_depthShader({ { dc::ShaderStage::Vertex, "vertex.glsl" },{ dc::ShaderStage::Fragment, "depth_only.glsl" } }, layout.shaderDefines()),
+          m_quadShader({ { dc::ShaderStage::Vertex, "quad.glsl" },{ dc::ShaderStage::Fragment, "sobel.glsl" } }, layout.shaderDefines()),
+          m_quadOutlineShader({ { dc::ShaderStage::Vertex, "quad.glsl" },{ dc::ShaderStage::Fragment, "sobel.glsl" } }, withDefines(layout.shaderDefines(), { "OUTLINE_DISTANCE" })),
+          m_quadEdgeMaskShader({ { dc::ShaderStage::Vertex, "quad.glsl" },{ dc::ShaderStage::Fragment, "sobel.glsl" } }, withDefines(layout.shaderDefines(), { "EDGE_MASK" })),
+          m_tileMaskShader({ { dc::ShaderStage::Vertex, "quad.glsl" },{ dc::ShaderStage::Fragment, "tile_mask.glsl" } }, tiledDefines(layout, {})),
+          m_quadTiledShader({ { dc::ShaderStage::Vertex, "quad.glsl" },{ dc::ShaderStage::Fragment, "sobel.glsl" } }, tiledDefines(layout, { "TILE_MASK" })),
+          m_gbuffer(m_fboWidth, m_fboHeight, layout),
+          // target of the compute post process, blitted to the output afterwards
+          m_postFbo(m_fboWidth, m_fboHeight, { { dc::FBAttachmentType::AttachColor, dc::TextureFormat::RGBA8 } }),
+          // one texel per tile, 1 where the fragment post process has to run edge detection
+          m_tileMaskFbo(m_tilesX, m_tilesY, { { dc::FBAttachmentType::AttachColor, dc::TextureFormat::R8 } }),
+          m_tileMask(m_tilesX * m_tilesY),
+          m_stencil(m_fboWidth * m_fboHeight),
+          m_outlines(m_fboWidth, m_fboHeight, layout.shaderDefines()),
+          m_geometryEdges(m_fboWidth, m_fboHeight),
+          // indirect dispatch arguments followed by the packed coordinates of every tile that needs edge detection
+          m_tileList(GL_SHADER_STORAGE_BUFFER, sizeof(GLuint) * (3 + m_tilesX * m_tilesY), nullptr, GL_DYNAMIC_DRAW)
+    {
+        if (m_computeSupported)
+        {
+            m_sobelComputeShader.reset(new dc::Shader({ { dc::ShaderStage::Compute, "sobel_compute.glsl" } }, layout.shaderDefines()));
+            m_tileClassifyShader.reset(new dc::Shader({ { dc::ShaderStage::Compute, "tile_classify.glsl" } }, tiledDefines(layout, {})));
+            m_sobelTiledShader.reset(new dc::Shader({ { dc::ShaderStage::Compute, "sobel_compute.glsl" } }, tiledDefines(layout, { "TILE_LIST" })));
+            m_instancedShader.reset(new dc::Shader({ { dc::ShaderStage::Vertex, "vertex.glsl" },{ dc::ShaderStage::Fragment, "fragment.glsl" } }, withDefines(layout.shaderDefines(), { "GPU_INSTANCES" })));
+            m_hiZ.reset(new HiZCulling(m_fboWidth, m_fboHeight));
+        }
+        settings.useCompute = m_computeSupported;
+
+        glGenVertexArrays(1, std::addressof(m_quadVAO));
+        dc::GpuResources::get().add(dc::GpuResourceType::VertexArray, m_quadVAO, 0, "post process quad");
+    }
+
+    ~Renderer()
+    {
+        dc::GpuResources::get().remove(dc::GpuResourceType::VertexArray, m_quadVAO);
+        glDeleteVertexArrays(1, std::addressof(m_quadVAO));
+    }
+
+    Renderer(const Renderer& other) = delete;
+    Renderer& operator=(const Renderer& other) = delete;
+
+    unsigned width() const { return m_width; }
+    unsigned height() const { return m_height; }
+    bool computeSupported() const { return m_computeSupported; }
+    const dc::GBuffer& gbuffer() const { return m_gbuffer; }
+    // null without GL 4.3
+    const HiZCulling* hiZ() const { return m_hiZ.get(); }
+
+    // rolling means of the GPU timer, a few frames behind
+    double gbufferMilliseconds() const { return m_gpuTimer.milliseconds("g-buffer"); }
+    double postMilliseconds() const { return m_gpuTimer.milliseconds("post"); }
+    // every timed pass, nested ones included
+    dc::GpuTimer& gpuTimer() { return m_gpuTimer; }
+    size_t geometryLineCount() const { return m_geometryEdges.lineCount(); }
+
+    std::string postName() const
+    {
+        if (settings.useGeometryEdges)
+            return "geometry edges";
+        if (settings.outlineWidth > 1.0f)
+            return "jump flood";
+        return settings.useCompute && m_computeSupported ? "compute" : "fragment";
+    }
+
+    void reloadShaders()
+    {
+        m_shader.reload();
+        m_depthShader.reload();
+        m_quadShader.reload();
+        m_tileMaskShader.reload();
+        m_quadTiledShader.reload();
+        m_quadOutlineShader.reload();
+        m_quadEdgeMaskShader.reload();
+        m_outlines.reload();
+        m_geometryEdges.reload();
+        if (m_computeSupported)
+        {
+            m_sobelComputeShader->reload();
+            m_tileClassifyShader->reload();
+            m_sobelTiledShader->reload();
+            m_instancedShader->reload();
+            m_hiZ->reload();
+        }
+    }
+
+    // the outline and silhouette benchmarks run on the inputs of the next render()
+    void requestBenchmarks()
+    {
+        m_runBenchmarks = true;
+    }
+
+    // share of tiles whose edge detection was skipped in the last classified frame, stalls on it
+    double skippedTileShare()
+    {
+        GLuint edgeTiles = 0;
+        if (settings.useCompute && m_computeSupported)
+        {
+            m_tileList.read(0, sizeof(GLuint), &edgeTiles);
+        }
+        else
+        {
+            m_tileMaskFbo.bind();
+            glPixelStorei(GL_PACK_ALIGNMENT, 1);
+            glReadPixels(0, 0, m_tilesX, m_tilesY, GL_RED, GL_UNSIGNED_BYTE, m_tileMask.data());
+            m_tileMaskFbo.unbind();
+            for (const auto& it : m_tileMask)
+            {
+                edgeTiles += it > 0 ? 1 : 0;
+            }
+        }
+        return static_cast<double>(m_tilesX * m_tilesY - edgeTiles) / (m_tilesX * m_tilesY);
+    }
+
+    // fragments shaded in the last frame rendered with countOverdraw, stalls on it
+    Overdraw overdraw()
+    {
+        m_gbuffer.bind();
+        glPixelStorei(GL_PACK_ALIGNMENT, 1);
+        glReadPixels(0, 0, m_fboWidth, m_fboHeight, GL_STENCIL_INDEX, GL_UNSIGNED_BYTE, m_stencil.data());
+        m_gbuffer.unbind();
+
+        size_t fragments = 0;
+        size_t covered = 0;
+        for (const auto& it : m_stencil)
+        {
+            fragments += it;
+            covered += it > 0 ? 1 : 0;
+        }
+        return { static_cast<double>(fragments) / m_stencil.size(), static_cast<double>(fragments) / std::max<size_t>(covered, 1),
+            static_cast<double>(covered) / m_stencil.size() };
+    }
+
+    // renders every instance of mesh into the g-buffer and shades it into target,
+    // nullptr draws into the default framebuffer
+    void render(const dc::Mesh& mesh, const std::vector<glm::mat4>& instances, const glm::mat4& view, const glm::mat4& projection, const dc::FrameBuffer* target = nullptr)
+    {
+        renderGBuffer(mesh, instances, view, projection);
+        renderPost(mesh, instances, view, projection, target);
+    }
+
+    void renderGBuffer(const dc::Mesh& mesh, const std::vector<glm::mat4>& instances, const glm::mat4& view, const glm::mat4& projection)
+    {
+        DC_PROFILE_FUNCTION();
+        DC_ALLOCATION_SCOPE(Frame);
+        m_gpuTimer.begin("g-buffer");
+        bool useHiZ = settings.useHiZ && m_hiZ;
+        if (useHiZ)
+            m_hiZ->cullEarly(mesh, instances, projection * view);
+
+        m_gbuffer.bind();
+        glViewport(0, 0, m_gbuffer.width(), m_gbuffer.height());
+        m_gbuffer.clear(m_clearColor);
+
+        glEnable(GL_CULL_FACE);
+        glEnable(GL_DEPTH_TEST);
+        if (settings.countOverdraw)
+        {
+            // incremented by every fragment passing the depth test of the shading pass
+            glEnable(GL_STENCIL_TEST);
+            glStencilFunc(GL_ALWAYS, 0, 0xFF);
+            glStencilOp(GL_KEEP, GL_KEEP, GL_KEEP);
+        }
+
+        unsigned materialIds = m_gbuffer.layout().materialIds() ? dc::GBuffer::MaxMaterials - 1 : 0;
+        if (useHiZ)
+        {
+            glStencilOp(GL_KEEP, GL_KEEP, GL_INCR);
+            // what was visible last frame, then what the depth of that shows to be visible now
+            for (unsigned pass = 0; pass < 2; ++pass)
+            {
+                if (pass == 1)
+                    m_hiZ->cullLate(mesh, m_gbuffer.depthTexture());
+                m_instancedShader->use();
+                m_instancedShader->setMat4("view", view);
+                m_instancedShader->setMat4("projection", projection);
+                m_hiZ->draw(mesh, *m_instancedShader, pass, materialIds);
+            }
+            m_hiZ->endFrame(m_gbuffer.depthTexture());
+        }
+        else
+        {
+            if (settings.useDepthPrepass)
+            {
+                DC_PROFILE_ZONE("depth pre-pass");
+                m_gpuTimer.begin("depth pre-pass");
+                m_depthShader.use();
+                m_depthShader.setMat4("view", view);
+                m_depthShader.setMat4("projection", projection);
+
+                glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+                for (unsigned i : sortFrontToBack(mesh, instances, view))
+                {
+                    m_depthShader.setMat4("model", instances[i]);
+                    mesh.draw(m_depthShader);
+                }
+                m_gpuTimer.end();
+                glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+                glDepthFunc(GL_EQUAL);
+                glDepthMask(GL_FALSE);
+            }
+            glStencilOp(GL_KEEP, GL_KEEP, GL_INCR);
+
+            m_shader.use();
+            m_shader.setMat4("view", view);
+            m_shader.setMat4("projection", projection);
+
+            for (const auto& model : instances)
+            {
+                m_shader.setMat4("model", model);
+                mesh.draw(m_shader, materialIds);
+            }
+            glDepthFunc(GL_LESS);
+            glDepthMask(GL_TRUE);
+        }
+        glDisable(GL_STENCIL_TEST);
+
+        glUseProgram(0);
+        m_gbuffer.unbind();
+        m_gpuTimer.end();
+    }
+
+    // shades the g-buffer of the last renderGBuffer into target, on its own when only post
+    // process settings changed. Geometry edges still need the instances and the camera
+    void renderPost(const dc::Mesh& mesh, const std::vector<glm::mat4>& instances, const glm::mat4& view, const glm::mat4& projection, const dc::FrameBuffer* target = nullptr)
+    {
+        DC_PROFILE_FUNCTION();
+        DC_ALLOCATION_SCOPE(Frame);
+        m_gpuTimer.begin("post");
+        glDisable(GL_DEPTH_TEST);
+
+        glActiveTexture(GL_TEXTURE0);
+        m_gbuffer.colorTexture()->bind();
+        glActiveTexture(GL_TEXTURE1);
+        m_gbuffer.normalTexture()->bind();
+        glActiveTexture(GL_TEXTURE2);
+        m_gbuffer.depthTexture()->bind();
+
+        auto usePostShader = [&](const dc::Shader& postShader)
+        {
+            postShader.use();
+            m_gbuffer.setMaterialPalette(postShader, mesh, m_clearColor);
+            postShader.setInt("colorTexture", 0);
+            postShader.setInt("normalTexture", 1);
+            postShader.setInt("depthTexture", 2);
+            postShader.setInt("outputImage", 0);
+            postShader.setInt("tileMask", 3);
+            postShader.setFloat("edgeThreshold", settings.edgeThreshold);
+            postShader.setFloat("fogStart", settings.fogStart);
+            postShader.setFloat("fogEnd", settings.fogEnd);
+        };
+
+        glBindVertexArray(m_quadVAO);
+        if (m_runBenchmarks)
+        {
+            m_outlines.benchmark(std::cout, usePostShader);
+            GeometryEdges::benchmark(std::cout, mesh);
+            m_runBenchmarks = false;
+        }
+
+        if (settings.useGeometryEdges)
+        {
+            DC_PROFILE_ZONE("geometry edges");
+            glm::vec3 eye = glm::vec3(glm::inverse(view)[3]);
+            m_geometryEdges.begin();
+            for (const auto& model : instances)
+            {
+                m_geometryEdges.add(mesh, model, eye);
+            }
+            m_gpuTimer.begin("geometry edges");
+            m_geometryEdges.draw(view, projection, m_gbuffer.depthTexture());
+            m_gpuTimer.end();
+
+            // the line draws unbound the quad's vertex array, core profiles draw nothing without one
+            glBindVertexArray(m_quadVAO);
+            bindTarget(target);
+            glActiveTexture(GL_TEXTURE6);
+            m_geometryEdges.edgeMask()->bind();
+            usePostShader(m_quadEdgeMaskShader);
+            m_quadEdgeMaskShader.setInt("edgeMask", 6);
+            glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+            glActiveTexture(GL_TEXTURE0);
+        }
+        else if (settings.outlineWidth > 1.0f)
+        {
+            m_gpuTimer.begin("outline flood");
+            m_outlines.seed(usePostShader);
+            const dc::Texture* nearestSeeds = m_outlines.flood(settings.outlineWidth);
+            m_gpuTimer.end();
+
+            bindTarget(target);
+            glActiveTexture(GL_TEXTURE5);
+            nearestSeeds->bind();
+            usePostShader(m_quadOutlineShader);
+            m_quadOutlineShader.setInt("outlineSeeds", 5);
+            m_quadOutlineShader.setFloat("outlineWidth", settings.outlineWidth);
+            glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+        }
+        else if (settings.useCompute && m_computeSupported)
+        {
+            dc::gl43().bindImageTexture(0, m_postFbo.texture(0)->id(), 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA8);
+            if (settings.useTiles)
+            {
+                // indirect dispatch of zero groups, the classification pass counts up the x dimension
+                const GLuint resetTileList[] = { 0, 1, 1 };
+                m_tileList.upload(0, sizeof(resetTileList), resetTileList);
+                m_tileList.bindBase(GL_SHADER_STORAGE_BUFFER, 0);
+
+                // flat tiles are finished by the classification pass itself
+                usePostShader(*m_tileClassifyShader);
+                dc::gl43().dispatchCompute(m_tilesX, m_tilesY, 1);
+                dc::gl43().memoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT | GL_COMMAND_BARRIER_BIT);
+
+                usePostShader(*m_sobelTiledShader);
+                m_tileList.bind(GL_DISPATCH_INDIRECT_BUFFER);
+                dc::gl43().dispatchComputeIndirect(0);
+                glBindBuffer(GL_DISPATCH_INDIRECT_BUFFER, 0);
+            }
+            else
+            {
+                const unsigned tileSize = 16;
+                usePostShader(*m_sobelComputeShader);
+                dc::gl43().dispatchCompute((m_fboWidth + tileSize - 1) / tileSize, (m_fboHeight + tileSize - 1) / tileSize, 1);
+            }
+            dc::gl43().memoryBarrier(GL_FRAMEBUFFER_BARRIER_BIT);
+            m_postFbo.blit(target ? target->id() : 0, m_width, m_height);
+        }
+        else
+        {
+            if (settings.useTiles)
+            {
+                m_tileMaskFbo.bind();
+                glViewport(0, 0, m_tilesX, m_tilesY);
+                usePostShader(m_tileMaskShader);
+                glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+                m_tileMaskFbo.unbind();
+
+                glActiveTexture(GL_TEXTURE3);
+                m_tileMaskFbo.texture(0)->bind();
+            }
+
+            bindTarget(target);
+            usePostShader(settings.useTiles ? m_quadTiledShader : m_quadShader);
+            glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+        }
+        glBindVertexArray(0);
+
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, 0);
+        glUseProgram(0);
+        if (target)
+        {
+            target->unbind();
+        }
+        m_gpuTimer.end();
+    }
+
+private:
+    unsigned m_width;
+    unsigned m_height;
+    unsigned m_fboWidth;
+    unsigned m_fboHeight;
+    unsigned m_tilesX;
+    unsigned m_tilesY;
+    glm::vec3 m_clearColor;
+    bool m_computeSupported;
+    bool m_runBenchmarks = false;
+
+    dc::Shader m_shader;
+    dc::Shader m_depthShader;
+    dc::Shader m_quadShader;
+    dc::Shader m_quadOutlineShader;
+    dc::Shader m_quadEdgeMaskShader;
+    dc::Shader m_tileMaskShader;
+    dc::Shader m_quadTiledShader;
+    std::unique_ptr<dc::Shader> m_sobelComputeShader;
+    std::unique_ptr<dc::Shader> m_tileClassifyShader;
+    std::unique_ptr<dc::Shader> m_sobelTiledShader;
+    std::unique_ptr<dc::Shader> m_instancedShader;
+
+    dc::GBuffer m_gbuffer;
+    dc::FrameBuffer m_postFbo;
+    dc::FrameBuffer m_tileMaskFbo;
+    std::vector<unsigned char> m_tileMask;
+    std::vector<unsigned char> m_stencil;
+    std::vector<unsigned> m_drawOrder;
+    std::vector<float> m_drawDepth;
+    JumpFloodOutlines m_outlines;
+    GeometryEdges m_geometryEdges;
+    std::unique_ptr<HiZCulling> m_hiZ;
+    dc::Buffer m_tileList;
+
+    GLuint m_quadVAO;
+    dc::GpuTimer m_gpuTimer;
+
+    static std::vector<std::string> withDefines(std::vector<std::string> defines, const std::vector<std::string>& extra)
+    {
+        defines.insert(defines.end(), extra.begin(), extra.end());
+        return defines;
+    }
+
+    static std::vector<std::string> tiledDefines(const dc::GBufferLayout& layout, const std::vector<std::string>& extra)
+    {
+        return withDefines(withDefines(layout.shaderDefines(), { "TILE_SIZE " + std::to_string(ClassifyTileSize) }), extra);
+    }
+
+    // instance indices by the view depth of their bounds' center, nearest first
+    const std::vector<unsigned>& sortFrontToBack(const dc::Mesh& mesh, const std::vector<glm::mat4>& instances, const glm::mat4& view)
+    {
+        glm::vec4 center((mesh.boundsMin() + mesh.boundsMax()) * 0.5f, 1.0f);
+        m_drawOrder.resize(instances.size());
+        m_drawDepth.resize(instances.size());
+        for (unsigned i = 0; i < instances.size(); ++i)
+        {
+            m_drawOrder[i] = i;
+            m_drawDepth[i] = -(view * instances[i] * center).z;
+        }
+        std::sort(m_drawOrder.begin(), m_drawOrder.end(), [&](unsigned a, unsigned b) { return m_drawDepth[a] < m_drawDepth[b]; });
+        return m_drawOrder;
+    }
+
+    // the post process covers every pixel, so the target is not cleared
+    void bindTarget(const dc::FrameBuffer* target) const
+    {
+        if (target)
+            target->bind();
+        else
+            glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        glViewport(0, 0, m_width, m_height);
+    }
+};
\ No newline at end of file
@@ -0,0 +1,50 @@
+#pragma once
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <cmath>
+#include <vector>
+
+#include <dc/Mesh.hpp>
+
+#include "OrbitCamera.hpp"
+
+// The scenes shared by the application and the benchmark
+
+inline OrbitCamera defaultCamera()
+{
+    return OrbitCamera{ { 0.0f, 0.5f, 0.0f }, 0.0f, 0.5f, 4.0f, false, 0, 0 };
+}
+
+// 3x3 grid of the model
+inline std::vector<glm::mat4> sceneInstances()
+{
+    std::vector<glm::mat4> instances;
+    for (int z = -1; z < 2; ++z)
+    {
+        for (int x = -1; x < 2; ++x)
+        {
+            instances.push_back(glm::rotate(glm::translate(glm::mat4(1.0f), { 15.0f * x, 0, 15.0f * z }), (x + z)*2.0f, { 0, 1, 0 }));
+        }
+    }
+    return instances;
+}
+
+// count copies of mesh on a square grid around the origin, row by row, turned in quarter
+// steps so neighbours differ. The pitch leaves a tenth of the mesh between them
+inline std::vector<glm::mat4> gridInstances(const dc::Mesh& mesh, unsigned count)
+{
+    glm::vec3 size = mesh.boundsMax() - mesh.boundsMin();
+    float pitch = glm::max(size.x, size.z) * 1.1f;
+    unsigned side = static_cast<unsigned>(std::ceil(std::sqrt(static_cast<double>(count))));
+    std::vector<glm::mat4> instances;
+    instances.reserve(count);
+    for (unsigned i = 0; i < count; ++i)
+    {
+        unsigned x = i % side;
+        unsigned z = i / side;
+        glm::vec3 position((x - side * 0.5f) * pitch, 0.0f, (z - side * 0.5f) * pitch);
+        instances.push_back(glm::rotate(glm::translate(glm::mat4(1.0f), position), 1.5708f * ((x + z) % 4), { 0, 1, 0 }));
+    }
+    return instances;
+}
\ No newline at end of file
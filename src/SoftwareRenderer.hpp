@@ -0,0 +1,575 @@
+#pragma once
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <iomanip>
+#include <memory>
+#include <ostream>
+#include <vector>
+
+#include <dc/Mesh.hpp>
+#include <dc/Simd.hpp>
+#include <dc/ThreadPool.hpp>
+
+#include "CpuStylize.hpp"
+
+// The stylized look without a GPU. Renders dc::MeshData the way Renderer renders a
+// dc::Mesh, with the classic g-buffer layout and the fragment post process:
+//  - vertices of every instance are transformed in parallel blocks,
+//  - triangles are clipped, set up and binned into 64x64 tiles, one bin list per chunk
+//    of triangles so binning needs no locks and keeps submission order,
+//  - every tile is rasterized by one thread, four pixels per step with SSE2 edge
+//    functions and depth test, into the tile's part of the g-buffer,
+//  - CpuStylize shades the g-buffer in strips of rows.
+class SoftwareRenderer
+{
+public:
+    static const unsigned TileSize = 64;
+    // triangles set up and binned per task
+    static const unsigned ChunkTriangles = 2048;
+
+    struct Timings
+    {
+        double transform = 0.0;
+        double bin = 0.0;
+        double raster = 0.0;
+        double post = 0.0;
+
+        double total() const { return transform + bin + raster + post; }
+    };
+
+    SoftwareRenderer(unsigned width, unsigned height, const glm::vec3& clearColor, unsigned threads = dc::ThreadPool::hardwareThreads())
+        : m_clearColor(clearColor),
+          m_tilesX((width + TileSize - 1) / TileSize),
+          m_tilesY((height + TileSize - 1) / TileSize),
+          m_pool(threads)
+    {
+        m_gbuffer.resize(width, height);
+    }
+
+    SoftwareRenderer(const SoftwareRenderer& other) = delete;
+    SoftwareRenderer& operator=(const SoftwareRenderer& other) = delete;
+
+    // post process parameters, the shader defaults unless changed
+    CpuStylize stylize;
+
+    unsigned width() const { return m_gbuffer.width; }
+    unsigned height() const { return m_gbuffer.height; }
+    unsigned threads() const { return m_pool.size(); }
+    const CpuGBuffer& gbuffer() const { return m_gbuffer; }
+    const Timings& timings() const { return m_timings; }
+    // after clipping and culling, in the last frame
+    size_t triangleCount() const { return m_triangleCount; }
+
+    // final image as RGBA8, bottom row first like glReadPixels
+    const std::vector<unsigned char>& image() const { return m_image; }
+
+    void render(const dc::MeshData& mesh, const std::vector<glm::mat4>& instances, const glm::mat4& view, const glm::mat4& projection)
+    {
+        auto start = Clock::now();
+        transform(mesh, instances, projection * view);
+        auto transformed = Clock::now();
+        setupAndBin(mesh, instances.size());
+        auto binned = Clock::now();
+        m_pool.parallelFor(static_cast<size_t>(m_tilesX) * m_tilesY, [&](size_t tile) { rasterizeTile(static_cast<unsigned>(tile)); });
+        auto rasterized = Clock::now();
+        stylize.run(m_gbuffer, m_image, m_pool);
+        auto shaded = Clock::now();
+
+        m_timings.transform = milliseconds(start, transformed);
+        m_timings.bin = milliseconds(transformed, binned);
+        m_timings.raster = milliseconds(binned, rasterized);
+        m_timings.post = milliseconds(rasterized, shaded);
+    }
+
+    // frames per second and per-stage times for 1, 2, 4, ... threads up to the hardware threads
+    static void benchmark(std::ostream& out, const dc::MeshData& mesh, const std::vector<glm::mat4>& instances, const glm::mat4& view, const glm::mat4& projection,
+        unsigned width, unsigned height, const glm::vec3& clearColor)
+    {
+        const unsigned frames = 10;
+
+        std::vector<unsigned> threadCounts;
+        unsigned hardware = dc::ThreadPool::hardwareThreads();
+        for (unsigned threads = 1; threads < hardware; threads *= 2)
+        {
+            threadCounts.push_back(threads);
+        }
+        threadCounts.push_back(hardware);
+
+        std::ios::fmtflags flags(out.flags());
+        std::streamsize precision = out.precision();
+
+        out << "software renderer " << width << "x" << height << ", " << instances.size() << " instances of "
+            << mesh.indices.size() / 3 << " triangles, " << frames << " frames:" << std::endl;
+        out << "  threads      fps  speedup  transform      bin   raster     post" << std::endl;
+        double baseline = 0.0;
+        for (unsigned threads : threadCounts)
+        {
+            SoftwareRenderer renderer(width, height, clearColor, threads);
+            // the first frame allocates bins and touches every page of the g-buffer
+            renderer.render(mesh, instances, view, projection);
+
+            Timings sum;
+            auto start = Clock::now();
+            for (unsigned i = 0; i < frames; ++i)
+            {
+                renderer.render(mesh, instances, view, projection);
+                sum.transform += renderer.timings().transform;
+                sum.bin += renderer.timings().bin;
+                sum.raster += renderer.timings().raster;
+                sum.post += renderer.timings().post;
+            }
+            double fps = frames * 1000.0 / milliseconds(start, Clock::now());
+            if (baseline == 0.0)
+                baseline = fps;
+
+            out << std::fixed << std::setprecision(2) << std::setw(9) << threads << std::setw(9) << fps << std::setw(8) << fps / baseline << "x"
+                << std::setw(11) << sum.transform / frames << std::setw(9) << sum.bin / frames
+                << std::setw(9) << sum.raster / frames << std::setw(9) << sum.post / frames << " ms" << std::endl;
+        }
+
+        out.flags(flags);
+        out.precision(precision);
+    }
+
+private:
+    typedef std::chrono::high_resolution_clock Clock;
+
+    struct ClipVertex
+    {
+        glm::vec4 position;
+        glm::vec3 normal;
+    };
+
+    // E(p) = a * (p.x - x) + b * (p.y - y), positive inside. Both triangles of a shared
+    // edge measure from the same endpoint, so their values are exact negations of each
+    // other and no pixel along the edge is drawn twice or skipped
+    struct Edge
+    {
+        float a;
+        float b;
+        float x;
+        float y;
+        // top-left rule, pixels exactly on the edge belong to the triangle
+        bool inclusive;
+    };
+
+    // value = dx * x + dy * y + c over window coordinates
+    struct Plane
+    {
+        float dx;
+        float dy;
+        float c;
+
+        float at(float x, float y) const { return dx * x + dy * y + c; }
+    };
+
+    struct Triangle
+    {
+        Edge edges[3];
+        Plane z;
+        // 1 / w and normal / w, interpolated linearly and divided per pixel for perspective correction
+        Plane invW;
+        Plane normal[3];
+        uint32_t color;
+        int minX;
+        int minY;
+        int maxX;
+        int maxY;
+    };
+
+    struct Chunk
+    {
+        std::vector<Triangle> triangles;
+        // per tile, indices into triangles
+        std::vector<std::vector<uint32_t>> bins;
+    };
+
+    glm::vec3 m_clearColor;
+    unsigned m_tilesX;
+    unsigned m_tilesY;
+    dc::ThreadPool m_pool;
+
+    CpuGBuffer m_gbuffer;
+    std::vector<unsigned char> m_image;
+    std::vector<ClipVertex> m_vertices;
+    std::vector<uint32_t> m_triangleColors;
+    std::vector<Chunk> m_chunks;
+    size_t m_triangleCount = 0;
+    Timings m_timings;
+
+    static double milliseconds(Clock::time_point from, Clock::time_point to)
+    {
+        return std::chrono::duration<double, std::milli>(to - from).count();
+    }
+
+    void transform(const dc::MeshData& mesh, const std::vector<glm::mat4>& instances, const glm::mat4& viewProjection)
+    {
+        const size_t block = 4096;
+        size_t count = mesh.vertices.size();
+        size_t blocks = (count + block - 1) / block;
+        m_vertices.resize(count * instances.size());
+        m_pool.parallelFor(blocks * instances.size(), [&](size_t task)
+        {
+            size_t instance = task / blocks;
+            size_t first = (task % blocks) * block;
+            size_t last = std::min(first + block, count);
+            glm::mat4 mvp = viewProjection * instances[instance];
+            ClipVertex* out = &m_vertices[instance * count];
+            for (size_t i = first; i < last; ++i)
+            {
+                // vertex.glsl passes the object space normal on untransformed
+                out[i].position = mvp * glm::vec4(mesh.vertices[i].position, 1.0f);
+                out[i].normal = mesh.vertices[i].normal;
+            }
+        });
+
+        m_triangleColors.assign(mesh.indices.size() / 3, CpuGBuffer::pack(m_clearColor));
+        for (const auto& it : mesh.groups)
+        {
+            uint32_t color = CpuGBuffer::pack(it.material.Kd);
+            for (unsigned t = it.offset / 3; t < (it.offset + it.count) / 3 && t < m_triangleColors.size(); ++t)
+            {
+                m_triangleColors[t] = color;
+            }
+        }
+    }
+
+    void setupAndBin(const dc::MeshData& mesh, size_t instances)
+    {
+        size_t perInstance = mesh.indices.size() / 3;
+        size_t total = perInstance * instances;
+        size_t chunks = (total + ChunkTriangles - 1) / ChunkTriangles;
+        m_chunks.resize(chunks);
+        m_pool.parallelFor(chunks, [&](size_t c)
+        {
+            Chunk& chunk = m_chunks[c];
+            chunk.triangles.clear();
+            chunk.bins.resize(static_cast<size_t>(m_tilesX) * m_tilesY);
+            for (auto& it : chunk.bins)
+            {
+                it.clear();
+            }
+
+            size_t last = std::min((c + 1) * ChunkTriangles, total);
+            for (size_t t = c * ChunkTriangles; t < last; ++t)
+            {
+                size_t instance = t / perInstance;
+                size_t local = t % perInstance;
+                const ClipVertex* vertices = &m_vertices[instance * mesh.vertices.size()];
+                ClipVertex triangle[3] = {
+                    vertices[mesh.indices[local * 3 + 0]],
+                    vertices[mesh.indices[local * 3 + 1]],
+                    vertices[mesh.indices[local * 3 + 2]]
+                };
+                clipAndSetup(triangle, m_triangleColors[local], chunk);
+            }
+        });
+
+        m_triangleCount = 0;
+        for (size_t c = 0; c < chunks; ++c)
+        {
+            m_triangleCount += m_chunks[c].triangles.size();
+        }
+    }
+
+    // clips against the near plane and a guard band four viewports wide, the other
+    // frustum planes are left to the scissoring of the bounding box and the depth test
+    void clipAndSetup(const ClipVertex (&triangle)[3], uint32_t color, Chunk& chunk) const
+    {
+        const float guardBand = 4.0f;
+        auto distance = [&](const glm::vec4& p, unsigned plane)
+        {
+            switch (plane)
+            {
+            case 0: return p.z + p.w;
+            case 1: return guardBand * p.w - p.x;
+            case 2: return guardBand * p.w + p.x;
+            case 3: return guardBand * p.w - p.y;
+            default: return guardBand * p.w + p.y;
+            }
+        };
+
+        // outside one frustum plane with all three vertices, nothing to draw
+        for (unsigned axis = 0; axis < 3; ++axis)
+        {
+            if ((triangle[0].position[axis] > triangle[0].position.w && triangle[1].position[axis] > triangle[1].position.w && triangle[2].position[axis] > triangle[2].position.w) ||
+                (triangle[0].position[axis] < -triangle[0].position.w && triangle[1].position[axis] < -triangle[1].position.w && triangle[2].position[axis] < -triangle[2].position.w))
+                return;
+        }
+
+        unsigned outside = 0;
+        for (unsigned plane = 0; plane < 5; ++plane)
+        {
+            for (const auto& it : triangle)
+            {
+                if (distance(it.position, plane) < 0.0f)
+                    outside |= 1u << plane;
+            }
+        }
+        if (outside == 0)
+        {
+            setup(triangle[0], triangle[1], triangle[2], color, chunk);
+            return;
+        }
+
+        // Sutherland-Hodgman, a triangle gains at most one vertex per plane
+        ClipVertex buffers[2][8];
+        unsigned count = 3;
+        std::copy(triangle, triangle + 3, buffers[0]);
+        unsigned current = 0;
+        for (unsigned plane = 0; plane < 5 && count > 0; ++plane)
+        {
+            if (!(outside & (1u << plane)))
+                continue;
+            const ClipVertex* in = buffers[current];
+            ClipVertex* out = buffers[1 - current];
+            unsigned outCount = 0;
+            for (unsigned i = 0; i < count; ++i)
+            {
+                const ClipVertex& a = in[i];
+                const ClipVertex& b = in[(i + 1) % count];
+                float da = distance(a.position, plane);
+                float db = distance(b.position, plane);
+                if (da >= 0.0f)
+                    out[outCount++] = a;
+                if ((da >= 0.0f) != (db >= 0.0f))
+                {
+                    // always interpolated from the inside vertex, so both triangles of a shared edge get the same point
+                    const ClipVertex& inside = da >= 0.0f ? a : b;
+                    const ClipVertex& other = da >= 0.0f ? b : a;
+                    float dInside = da >= 0.0f ? da : db;
+                    float dOther = da >= 0.0f ? db : da;
+                    float t = dInside / (dInside - dOther);
+                    out[outCount].position = glm::mix(inside.position, other.position, t);
+                    out[outCount].normal = glm::mix(inside.normal, other.normal, t);
+                    ++outCount;
+                }
+            }
+            count = outCount;
+            current = 1 - current;
+        }
+        for (unsigned i = 1; i + 1 < count; ++i)
+        {
+            setup(buffers[current][0], buffers[current][i], buffers[current][i + 1], color, chunk);
+        }
+    }
+
+    void setup(const ClipVertex& v0, const ClipVertex& v1, const ClipVertex& v2, uint32_t color, Chunk& chunk) const
+    {
+        const ClipVertex* v[3] = { &v0, &v1, &v2 };
+        float x[3], y[3], z[3], invW[3];
+        for (unsigned i = 0; i < 3; ++i)
+        {
+            invW[i] = 1.0f / v[i]->position.w;
+            // 8 bits of subpixel precision like common GPU rasterizers
+            x[i] = std::floor((v[i]->position.x * invW[i] * 0.5f + 0.5f) * m_gbuffer.width * 256.0f + 0.5f) / 256.0f;
+            y[i] = std::floor((v[i]->position.y * invW[i] * 0.5f + 0.5f) * m_gbuffer.height * 256.0f + 0.5f) / 256.0f;
+            z[i] = v[i]->position.z * invW[i] * 0.5f + 0.5f;
+        }
+
+        // counter clockwise is front facing, back faces and degenerate triangles are culled
+        float area = (x[1] - x[0]) * (y[2] - y[0]) - (x[2] - x[0]) * (y[1] - y[0]);
+        if (!(area > 0.0f))
+            return;
+
+        Triangle triangle;
+        // pixel centers inside the bounding box, clamped to the viewport
+        triangle.minX = std::max(0, static_cast<int>(std::ceil(std::min({ x[0], x[1], x[2] }) - 0.5f)));
+        triangle.minY = std::max(0, static_cast<int>(std::ceil(std::min({ y[0], y[1], y[2] }) - 0.5f)));
+        triangle.maxX = std::min(static_cast<int>(m_gbuffer.width) - 1, static_cast<int>(std::floor(std::max({ x[0], x[1], x[2] }) - 0.5f)));
+        triangle.maxY = std::min(static_cast<int>(m_gbuffer.height) - 1, static_cast<int>(std::floor(std::max({ y[0], y[1], y[2] }) - 0.5f)));
+        if (triangle.minX > triangle.maxX || triangle.minY > triangle.maxY)
+            return;
+
+        for (unsigned i = 0; i < 3; ++i)
+        {
+            unsigned j = (i + 1) % 3;
+            Edge& edge = triangle.edges[i];
+            edge.a = y[i] - y[j];
+            edge.b = x[j] - x[i];
+            bool originFirst = x[i] < x[j] || (x[i] == x[j] && y[i] < y[j]);
+            edge.x = originFirst ? x[i] : x[j];
+            edge.y = originFirst ? y[i] : y[j];
+            // counter clockwise with y up: left edges run down, top edges run left
+            edge.inclusive = y[j] < y[i] || (y[j] == y[i] && x[j] < x[i]);
+        }
+
+        auto plane = [&](float a0, float a1, float a2)
+        {
+            Plane p;
+            p.dx = ((a1 - a0) * (y[2] - y[0]) - (a2 - a0) * (y[1] - y[0])) / area;
+            p.dy = ((a2 - a0) * (x[1] - x[0]) - (a1 - a0) * (x[2] - x[0])) / area;
+            p.c = a0 - p.dx * x[0] - p.dy * y[0];
+            return p;
+        };
+        triangle.z = plane(z[0], z[1], z[2]);
+        triangle.invW = plane(invW[0], invW[1], invW[2]);
+        for (unsigned c = 0; c < 3; ++c)
+        {
+            triangle.normal[c] = plane(v0.normal[c] * invW[0], v1.normal[c] * invW[1], v2.normal[c] * invW[2]);
+        }
+        triangle.color = color;
+
+        uint32_t index = static_cast<uint32_t>(chunk.triangles.size());
+        bool binned = false;
+        for (int ty = triangle.minY / static_cast<int>(TileSize); ty <= triangle.maxY / static_cast<int>(TileSize); ++ty)
+        {
+            for (int tx = triangle.minX / static_cast<int>(TileSize); tx <= triangle.maxX / static_cast<int>(TileSize); ++tx)
+            {
+                if (!overlapsTile(triangle, tx, ty))
+                    continue;
+                chunk.bins[static_cast<size_t>(ty) * m_tilesX + tx].push_back(index);
+                binned = true;
+            }
+        }
+        if (binned)
+            chunk.triangles.push_back(triangle);
+    }
+
+    // false if the tile lies completely outside one edge, tested at the tile corner furthest inside
+    static bool overlapsTile(const Triangle& triangle, int tx, int ty)
+    {
+        float x0 = static_cast<float>(tx * TileSize) + 0.5f;
+        float y0 = static_cast<float>(ty * TileSize) + 0.5f;
+        float x1 = x0 + TileSize - 1.0f;
+        float y1 = y0 + TileSize - 1.0f;
+        for (const auto& it : triangle.edges)
+        {
+            float x = it.a > 0.0f ? x1 : x0;
+            float y = it.b > 0.0f ? y1 : y0;
+            if (it.a * (x - it.x) + it.b * (y - it.y) < 0.0f)
+                return false;
+        }
+        return true;
+    }
+
+    void rasterizeTile(unsigned tile)
+    {
+        int tileX0 = static_cast<int>((tile % m_tilesX) * TileSize);
+        int tileY0 = static_cast<int>((tile / m_tilesX) * TileSize);
+        int tileX1 = std::min(tileX0 + static_cast<int>(TileSize), static_cast<int>(m_gbuffer.width)) - 1;
+        int tileY1 = std::min(tileY0 + static_cast<int>(TileSize), static_cast<int>(m_gbuffer.height)) - 1;
+
+        uint32_t clearColor = CpuGBuffer::pack(m_clearColor);
+        // the background normal is the clear color read as N * 0.5 + 0.5, like GBuffer::clear
+        for (int y = tileY0; y <= tileY1; ++y)
+        {
+            size_t row = m_gbuffer.index(tileX0, y);
+            std::fill_n(&m_gbuffer.color[row], tileX1 - tileX0 + 1, clearColor);
+            std::fill_n(&m_gbuffer.normal[row], tileX1 - tileX0 + 1, clearColor);
+            std::fill_n(&m_gbuffer.depth[row], tileX1 - tileX0 + 1, 1.0f);
+        }
+
+        for (const auto& chunk : m_chunks)
+        {
+            for (uint32_t index : chunk.bins[tile])
+            {
+                const Triangle& triangle = chunk.triangles[index];
+                int x0 = std::max(triangle.minX, tileX0) & ~3;
+                int x1 = std::min(triangle.maxX, tileX1);
+                int y0 = std::max(triangle.minY, tileY0);
+                int y1 = std::min(triangle.maxY, tileY1);
+                for (int y = y0; y <= y1; ++y)
+                {
+                    rasterizeRow(triangle, y, x0, x1);
+                }
+            }
+        }
+    }
+
+    // x0 is a multiple of four, x1 the last pixel inclusive
+    void rasterizeRow(const Triangle& triangle, int y, int x0, int x1)
+    {
+        float py = y + 0.5f;
+        float* depthRow = &m_gbuffer.depth[m_gbuffer.index(0, y)];
+        // the row dependent half of every edge function, computed once per row
+        float rowTerm[3];
+        for (unsigned e = 0; e < 3; ++e)
+        {
+            rowTerm[e] = triangle.edges[e].b * (py - triangle.edges[e].y);
+        }
+        float zRow = triangle.z.dy * py + triangle.z.c;
+
+#ifdef DC_SSE2
+        const __m128 zero = _mm_setzero_ps();
+        const __m128 laneOffsets = _mm_set_ps(3.5f, 2.5f, 1.5f, 0.5f);
+        const __m128 last = _mm_set1_ps(x1 + 0.5f);
+        __m128 a[3], ox[3], row[3], inclusive[3];
+        for (unsigned e = 0; e < 3; ++e)
+        {
+            a[e] = _mm_set1_ps(triangle.edges[e].a);
+            ox[e] = _mm_set1_ps(triangle.edges[e].x);
+            row[e] = _mm_set1_ps(rowTerm[e]);
+            inclusive[e] = _mm_castsi128_ps(_mm_set1_epi32(triangle.edges[e].inclusive ? -1 : 0));
+        }
+        const __m128 zdx = _mm_set1_ps(triangle.z.dx);
+        const __m128 zrow = _mm_set1_ps(zRow);
+
+        for (int x = x0; x <= x1; x += 4)
+        {
+            __m128 px = _mm_add_ps(_mm_set1_ps(static_cast<float>(x)), laneOffsets);
+            __m128 mask = _mm_cmple_ps(px, last);
+            for (unsigned e = 0; e < 3; ++e)
+            {
+                __m128 value = _mm_add_ps(_mm_mul_ps(a[e], _mm_sub_ps(px, ox[e])), row[e]);
+                __m128 inside = _mm_or_ps(_mm_cmpgt_ps(value, zero), _mm_and_ps(_mm_cmpeq_ps(value, zero), inclusive[e]));
+                mask = _mm_and_ps(mask, inside);
+            }
+            if (_mm_movemask_ps(mask) == 0)
+                continue;
+
+            __m128 z = _mm_add_ps(_mm_mul_ps(zdx, px), zrow);
+            __m128 depth = _mm_loadu_ps(depthRow + x);
+            __m128 pass = _mm_and_ps(mask, _mm_cmplt_ps(z, depth));
+            int bits = _mm_movemask_ps(pass);
+            if (bits == 0)
+                continue;
+            _mm_storeu_ps(depthRow + x, _mm_or_ps(_mm_and_ps(pass, z), _mm_andnot_ps(pass, depth)));
+            for (int lane = 0; lane < 4; ++lane)
+            {
+                if (bits & (1 << lane))
+                    shadePixel(triangle, x + lane, y);
+            }
+        }
+#else
+        for (int x = x0; x <= x1; x += 4)
+        {
+            for (int lane = 0; lane < 4 && x + lane <= x1; ++lane)
+            {
+                float px = x + lane + 0.5f;
+                bool inside = true;
+                for (unsigned e = 0; e < 3; ++e)
+                {
+                    float value = triangle.edges[e].a * (px - triangle.edges[e].x) + rowTerm[e];
+                    inside = inside && (value > 0.0f || (value == 0.0f && triangle.edges[e].inclusive));
+                }
+                float z = triangle.z.dx * px + zRow;
+                if (inside && z < depthRow[x + lane])
+                {
+                    depthRow[x + lane] = z;
+                    shadePixel(triangle, x + lane, y);
+                }
+            }
+        }
+#endif
+    }
+
+    // fragment.glsl for the pixels that passed the depth test
+    void shadePixel(const Triangle& triangle, int x, int y)
+    {
+        float px = x + 0.5f;
+        float py = y + 0.5f;
+        float w = 1.0f / triangle.invW.at(px, py);
+        glm::vec3 normal(triangle.normal[0].at(px, py) * w, triangle.normal[1].at(px, py) * w, triangle.normal[2].at(px, py) * w);
+        float length = glm::length(normal);
+        normal = length > 0.0f ? normal / length : glm::vec3(0.0f, 1.0f, 0.0f);
+
+        size_t i = m_gbuffer.index(x, y);
+        m_gbuffer.color[i] = triangle.color;
+        m_gbuffer.normal[i] = CpuGBuffer::pack(normal * 0.5f + 0.5f);
+    }
+};
\ No newline at end of file
@@ -0,0 +1,355 @@
+#pragma once
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <dirent.h>
+#endif
+
+#include <dc/BlockingQueue.hpp>
+#include <dc/FrameBuffer.hpp>
+#include <dc/Mesh.hpp>
+#include <dc/ObjLoader.hpp>
+#include <dc/PngWriter.hpp>
+#include <dc/ThreadPool.hpp>
+
+#include "OrbitCamera.hpp"
+#include "Renderer.hpp"
+
+// Renders stylized previews of a model library in one GL context. Loader threads parse
+// OBJ files into dc::MeshData, the GL thread uploads each into the same recycled dc::Mesh
+// and renders every configured view, encoder threads write the PNGs. Bounded queues
+// between the stages keep memory flat no matter how many models are queued.
+struct ThumbnailView
+{
+    // degrees, elevation measured from the up axis like OrbitCamera
+    float azimuth;
+    float elevation;
+    // multiples of the model's bounding sphere radius
+    float distance;
+};
+
+struct ThumbnailOptions
+{
+    // directory of .obj files or a manifest listing one model per line
+    std::string input;
+    std::string outputDirectory = ".";
+    unsigned size = 256;
+    std::vector<ThumbnailView> views = { { 45.0f, 60.0f, 2.2f } };
+    unsigned loaders = glm::max(dc::ThreadPool::hardwareThreads() / 2, 1u);
+    unsigned encoders = 2;
+
+    // parses "azimuth,elevation,distance;..." as given on the command line
+    static std::vector<ThumbnailView> parseViews(const std::string& text)
+    {
+        std::vector<ThumbnailView> views;
+        std::istringstream list(text);
+        std::string item;
+        while (std::getline(list, item, ';'))
+        {
+            ThumbnailView view;
+            char comma1 = 0, comma2 = 0;
+            std::istringstream iss(item);
+            if (!(iss >> view.azimuth >> comma1 >> view.elevation >> comma2 >> view.distance) || comma1 != ',' || comma2 != ',')
+                throw std::invalid_argument("unable to parse view " + item);
+            views.push_back(view);
+        }
+        return views;
+    }
+};
+
+class ThumbnailBatch
+{
+public:
+    ThumbnailBatch(const ThumbnailOptions& options, const dc::GBufferLayout& layout, const glm::vec3& clearColor, bool computeSupported)
+        : m_options(options),
+          m_renderer(options.size, options.size, 1, layout, clearColor, computeSupported),
+          m_output(options.size, options.size, { { dc::FBAttachmentType::AttachColor, dc::TextureFormat::RGBA8 } })
+    {
+    }
+
+    ThumbnailBatch(const ThumbnailBatch& other) = delete;
+    ThumbnailBatch& operator=(const ThumbnailBatch& other) = delete;
+
+    Renderer::Settings& settings() { return m_renderer.settings; }
+
+    // renders every model of the input and prints throughput, returns the number of failed models
+    unsigned run(std::ostream& out)
+    {
+        std::vector<std::string> models = listModels(m_options.input);
+        out << "rendering " << models.size() << " models, " << m_options.views.size() << " views each, "
+            << m_options.size << "x" << m_options.size << ", " << m_options.loaders << " loaders, "
+            << m_options.encoders << " encoders" << std::endl;
+
+        Stats stats;
+        auto start = Clock::now();
+        {
+            // a few models ahead per loader, enough to hide parse time jitter
+            dc::BlockingQueue<LoadedModel> loaded(m_options.loaders * 2);
+            // pixel buffers circulate between readback and encoders, a full ring stalls readback
+            dc::BlockingQueue<std::vector<unsigned char>> freeBuffers(m_options.encoders * 2);
+            for (unsigned i = 0; i < freeBuffers.capacity(); ++i)
+            {
+                freeBuffers.push(std::vector<unsigned char>(m_options.size * m_options.size * 3));
+            }
+
+            dc::ThreadPool encoders(m_options.encoders);
+            dc::ThreadPool loaders(m_options.loaders);
+            // destroyed before the pools: when this thread throws, loaders blocked in push
+            // have to be woken or the pools would join them forever
+            struct CloseQueues
+            {
+                dc::BlockingQueue<LoadedModel>& loaded;
+                dc::BlockingQueue<std::vector<unsigned char>>& freeBuffers;
+
+                ~CloseQueues()
+                {
+                    loaded.close();
+                    freeBuffers.close();
+                }
+            } closeQueues{ loaded, freeBuffers };
+            std::atomic<size_t> nextModel(0);
+            for (unsigned i = 0; i < loaders.size(); ++i)
+            {
+                loaders.submit([&]()
+                {
+                    for (size_t index = nextModel++; index < models.size(); index = nextModel++)
+                    {
+                        if (!loaded.push(load(models[index], stats)))
+                            break;
+                    }
+                });
+            }
+
+            std::unique_ptr<dc::Mesh> mesh;
+            for (size_t i = 0; i < models.size(); ++i)
+            {
+                LoadedModel model;
+                auto waitStart = Clock::now();
+                loaded.pop(model);
+                stats.add(stats.glWaitMs, waitStart);
+
+                if (!model.error.empty())
+                {
+                    out << "failed to load " << model.path << ": " << model.error << std::endl;
+                    ++stats.failed;
+                    continue;
+                }
+
+                auto renderStart = Clock::now();
+                glm::vec3 center = model.center;
+                float radius = model.radius;
+                if (mesh)
+                    mesh->update(std::move(model.data));
+                else
+                    mesh.reset(new dc::Mesh(std::move(model.data)));
+
+                // every model is scaled into the unit sphere at the origin, so the fixed near and
+                // far planes and stylize.glsl's fog range fit any asset's size
+                glm::mat4 normalize = glm::scale(glm::mat4(1.0f), glm::vec3(1.0f / radius)) * glm::translate(glm::mat4(1.0f), -center);
+                for (unsigned v = 0; v < m_options.views.size(); ++v)
+                {
+                    const ThumbnailView& view = m_options.views[v];
+                    OrbitCamera camera{ glm::vec3(0.0f), glm::radians(view.azimuth), glm::radians(view.elevation), view.distance, false, 0, 0 };
+                    glm::mat4 projection = glm::perspectiveFov<float>(glm::radians(60.0f), static_cast<float>(m_options.size), static_cast<float>(m_options.size), 0.1f, 100.0f);
+                    m_renderer.render(*mesh, { normalize }, camera.getViewMatrix(), projection, &m_output);
+
+                    std::vector<unsigned char> pixels;
+                    auto bufferStart = Clock::now();
+                    freeBuffers.pop(pixels);
+                    stats.add(stats.glWaitMs, bufferStart);
+
+                    m_output.bind();
+                    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+                    glReadPixels(0, 0, m_options.size, m_options.size, GL_RGB, GL_UNSIGNED_BYTE, pixels.data());
+                    m_output.unbind();
+
+                    std::string path = outputPath(model.path, v);
+                    unsigned size = m_options.size;
+                    encoders.submit(std::bind([&stats, &freeBuffers, path, size](std::vector<unsigned char>& buffer)
+                    {
+                        auto encodeStart = Clock::now();
+                        if (!dc::writePng(path, buffer.data(), size, size, 3, true))
+                            ++stats.failedImages;
+                        stats.add(stats.encodeMs, encodeStart);
+                        freeBuffers.push(std::move(buffer));
+                    }, std::move(pixels)));
+                    ++stats.images;
+                }
+                stats.add(stats.renderMs, renderStart);
+                ++stats.rendered;
+            }
+            // pools join here, encoders last so every image is on disk before the report
+            stats.loadedPeak = loaded.peak();
+        }
+        std::chrono::duration<double> elapsed = Clock::now() - start;
+        stats.print(out, elapsed.count());
+        return stats.failed + stats.failedImages;
+    }
+
+    // .obj files of a directory, or the lines of a manifest relative to its directory
+    static std::vector<std::string> listModels(const std::string& input)
+    {
+        std::vector<std::string> models;
+        std::ifstream manifest(input);
+        std::string line;
+        if (manifest && std::getline(manifest, line))
+        {
+            std::string dir = input.substr(0, input.find_last_of("/\\") + 1);
+            do
+            {
+                line.erase(line.find_last_not_of(" \t\r") + 1);
+                if (line.empty() || line[0] == '#')
+                    continue;
+                bool absolute = line[0] == '/' || line[0] == '\\' || (line.size() > 1 && line[1] == ':');
+                models.push_back(absolute ? line : dir + line);
+            } while (std::getline(manifest, line));
+            return models;
+        }
+
+        std::string dir = input.empty() || input.back() == '/' || input.back() == '\\' ? input : input + "/";
+#ifdef _WIN32
+        _finddata_t entry;
+        intptr_t handle = _findfirst((dir + "*.obj").c_str(), &entry);
+        if (handle != -1)
+        {
+            do
+            {
+                models.push_back(dir + entry.name);
+            } while (_findnext(handle, &entry) == 0);
+            _findclose(handle);
+        }
+#else
+        if (DIR* directory = opendir(dir.c_str()))
+        {
+            while (dirent* entry = readdir(directory))
+            {
+                std::string name = entry->d_name;
+                if (name.size() > 4 && name.compare(name.size() - 4, 4, ".obj") == 0)
+                    models.push_back(dir + name);
+            }
+            closedir(directory);
+        }
+#endif
+        std::sort(models.begin(), models.end());
+        return models;
+    }
+
+private:
+    typedef std::chrono::high_resolution_clock Clock;
+
+    struct LoadedModel
+    {
+        std::string path;
+        std::string error;
+        dc::MeshData data;
+        glm::vec3 center;
+        float radius = 1.0f;
+    };
+
+    struct Stats
+    {
+        std::mutex mutex;
+        double loadMs = 0.0;
+        double renderMs = 0.0;
+        double encodeMs = 0.0;
+        // GL thread blocked on loaders or on free pixel buffers
+        double glWaitMs = 0.0;
+        size_t loadedPeak = 0;
+        std::atomic<unsigned> rendered{ 0 };
+        std::atomic<unsigned> failed{ 0 };
+        std::atomic<unsigned> images{ 0 };
+        std::atomic<unsigned> failedImages{ 0 };
+
+        void add(double& total, Clock::time_point start)
+        {
+            std::chrono::duration<double, std::milli> elapsed = Clock::now() - start;
+            std::lock_guard<std::mutex> lock(mutex);
+            total += elapsed.count();
+        }
+
+        void print(std::ostream& out, double seconds)
+        {
+            std::ios::fmtflags flags(out.flags());
+            std::streamsize precision = out.precision();
+
+            unsigned models = rendered + failed;
+            out << std::fixed << std::setprecision(2)
+                << rendered << " models (" << failed << " failed), " << images << " images in " << seconds << " s: "
+                << rendered / seconds << " models/s, " << images / seconds << " images/s" << std::endl
+                << "  load   " << loadMs / glm::max(models, 1u) << " ms per model on loader threads" << std::endl
+                << "  render " << renderMs / glm::max(rendered.load(), 1u) << " ms per model on the GL thread (upload, render, readback), "
+                << glWaitMs << " ms waiting" << std::endl
+                << "  encode " << encodeMs / glm::max(images.load(), 1u) << " ms per image on encoder threads" << std::endl
+                << "  peak loaded models queued " << loadedPeak << std::endl;
+
+            out.flags(flags);
+            out.precision(precision);
+        }
+    };
+
+    ThumbnailOptions m_options;
+    Renderer m_renderer;
+    dc::FrameBuffer m_output;
+
+    static LoadedModel load(const std::string& path, Stats& stats)
+    {
+        auto start = Clock::now();
+        LoadedModel model;
+        model.path = path;
+        try
+        {
+            dc::ObjLoader loader(path);
+            model.data = loader.exportMeshData();
+            if (model.data.vertices.empty())
+                throw std::runtime_error("no geometry");
+
+            glm::vec3 minimum(model.data.vertices[0].position);
+            glm::vec3 maximum(minimum);
+            for (const auto& it : model.data.vertices)
+            {
+                minimum = glm::min(minimum, it.position);
+                maximum = glm::max(maximum, it.position);
+            }
+            model.center = (minimum + maximum) * 0.5f;
+            model.radius = glm::max(glm::length(maximum - minimum) * 0.5f, 1e-3f);
+        }
+        catch (const std::exception& e)
+        {
+            model.error = e.what();
+            model.data = dc::MeshData();
+        }
+        stats.add(stats.loadMs, start);
+        return model;
+    }
+
+    std::string outputPath(const std::string& modelPath, unsigned view) const
+    {
+        size_t slash = modelPath.find_last_of("/\\");
+        std::string name = modelPath.substr(slash == std::string::npos ? 0 : slash + 1);
+        name = name.substr(0, name.find_last_of('.'));
+        if (m_options.views.size() > 1)
+            name += "_" + std::to_string(view);
+
+        std::string dir = m_options.outputDirectory;
+        if (!dir.empty() && dir.back() != '/' && dir.back() != '\\')
+            dir += "/";
+        return dir + name + ".png";
+    }
+};
\ No newline at end of file
@@ -0,0 +1,653 @@
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#if DC_TRACK_ALLOCATIONS
+#define DC_ALLOCATION_TRACKER_IMPLEMENTATION
+#endif
+#include <dc/AllocationTracker.hpp>
+#include <dc/FrameBuffer.hpp>
+#include <dc/GBuffer.hpp>
+#include <dc/GLExtensions.hpp>
+#include <dc/GpuResources.hpp>
+#include <dc/GpuTimer.hpp>
+#include <dc/Mesh.hpp>
+#include <dc/ImageCompare.hpp>
+#include <dc/ObjLoader.hpp>
+#include <dc/PngWriter.hpp>
+#include <dc/RenderStats.hpp>
+
+#include "CameraPath.hpp"
+#include "HeadlessContext.hpp"
+#include "OrbitCamera.hpp"
+#include "Renderer.hpp"
+#include "Scene.hpp"
+
+// Renders fixed scenes along a fixed camera path offscreen and writes frame time statistics
+// as JSON, so two builds or two machines can be compared number by number. Every frame is
+// finished before the next begins: CPU time is the submission, frame time submission plus
+// glFinish, GPU time a timestamp pair around the frame. Nothing is presented, so vsync
+// never throttles a frame. The camera is sampled by frame index, not by clock.
+//
+// --check runs the reference scenes instead and fails when an image no longer matches its
+// golden or a frame time exceeds its baseline, see runCheck. Built with DC_TRACK_ALLOCATIONS
+// it also counts the heap allocations of the measured frames, which --check wants none of.
+
+const glm::vec3 clearColor{ 0.2f, 0.3f, 0.3f };
+
+struct BenchmarkOptions
+{
+    std::string model = "../models/basic_model.obj";
+    // "grid" is the application's 3x3 grid, a number that many instances on a square grid
+    std::vector<std::string> scenes = { "grid", "100", "10000", "100000" };
+    // 0 picks 240 frames, 60 for --check
+    unsigned frames = 0;
+    // rendered before the measured frames, for warm caches and compiled pipelines
+    unsigned warmup = 10;
+    // 0 picks 1280x720, 640x360 for --check
+    unsigned width = 0;
+    unsigned height = 0;
+    // keyframes run once over the frames, see CameraPath::load, empty orbits once
+    std::string cameraPath;
+    // post process override, empty keeps the default
+    std::string post;
+    std::string output = "benchmark.json";
+    // golden images and the timing baseline, see runCheck
+    std::string checkDirectory;
+    // writes the goldens and the baseline instead of comparing against them
+    bool update = false;
+    // share the frame time p50 may exceed its baseline by
+    double timeThreshold = 0.15;
+    // delta E a pixel may be off by, and the share of pixels allowed beyond it
+    double deltaE = 2.3;
+    double differingShare = 0.001;
+};
+
+struct Summary
+{
+    double mean = 0.0;
+    double p50 = 0.0;
+    double p95 = 0.0;
+    double p99 = 0.0;
+    double max = 0.0;
+};
+
+struct SceneResult
+{
+    std::string name;
+    size_t instances = 0;
+    dc::RenderStats stats;
+    Summary cpu;
+    Summary frame;
+    Summary gpu;
+    // the start of the path rendered after the measured frames, RGBA bottom up
+    std::vector<unsigned char> pixels;
+    // FNV-1a of pixels, equal between runs of the same build on the same GL
+    uint32_t checksum = 0;
+    // made by Renderer::render over all measured frames, with DC_TRACK_ALLOCATIONS
+    uint64_t frameAllocations = 0;
+    uint64_t frameAllocatedBytes = 0;
+};
+
+static Summary summarize(std::vector<double> values)
+{
+    Summary summary;
+    if (values.empty())
+        return summary;
+    std::sort(values.begin(), values.end());
+    double sum = 0.0;
+    for (double value : values)
+    {
+        sum += value;
+    }
+    summary.mean = sum / values.size();
+    summary.p50 = values[values.size() / 2];
+    summary.p95 = values[(values.size() * 95) / 100];
+    summary.p99 = values[(values.size() * 99) / 100];
+    summary.max = values.back();
+    return summary;
+}
+
+static std::vector<std::string> split(const std::string& list, char separator)
+{
+    std::vector<std::string> parts;
+    std::istringstream iss(list);
+    std::string part;
+    while (std::getline(iss, part, separator))
+    {
+        if (!part.empty())
+            parts.push_back(part);
+    }
+    return parts;
+}
+
+static bool parseOptions(int argc, char** argv, BenchmarkOptions& options)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--model" && hasValue)
+        {
+            options.model = argv[++i];
+        }
+        else if (arg == "--scenes" && hasValue)
+        {
+            options.scenes = split(argv[++i], ',');
+        }
+        else if (arg == "--frames" && hasValue)
+        {
+            options.frames = glm::max(std::stoi(argv[++i]), 1);
+        }
+        else if (arg == "--warmup" && hasValue)
+        {
+            options.warmup = glm::max(std::stoi(argv[++i]), 0);
+        }
+        else if (arg == "--size" && hasValue)
+        {
+            std::vector<std::string> size = split(argv[++i], 'x');
+            if (size.size() != 2)
+                throw std::invalid_argument("size must be <width>x<height>");
+            options.width = glm::max(std::stoi(size[0]), 16);
+            options.height = glm::max(std::stoi(size[1]), 16);
+        }
+        else if (arg == "--path" && hasValue)
+        {
+            options.cameraPath = argv[++i];
+        }
+        else if (arg == "--post" && hasValue && (std::string(argv[i + 1]) == "compute" || std::string(argv[i + 1]) == "fragment"))
+        {
+            options.post = argv[++i];
+        }
+        else if (arg == "--out" && hasValue)
+        {
+            options.output = argv[++i];
+        }
+        else if (arg == "--check" && hasValue)
+        {
+            options.checkDirectory = argv[++i];
+        }
+        else if (arg == "--update")
+        {
+            options.update = true;
+        }
+        else if (arg == "--time-threshold" && hasValue)
+        {
+            options.timeThreshold = glm::max(std::stod(argv[++i]), 0.0);
+        }
+        else if (arg == "--delta-e" && hasValue)
+        {
+            options.deltaE = glm::max(std::stod(argv[++i]), 0.0);
+        }
+        else if (arg == "--max-differing" && hasValue)
+        {
+            options.differingShare = glm::max(std::stod(argv[++i]), 0.0);
+        }
+        else
+        {
+            std::cout << "usage: " << argv[0] << " [--model file.obj] [--scenes grid,100,10000,100000] [--frames n] [--warmup n]" << std::endl
+                << "       [--size 1280x720] [--path keys.txt] [--post compute|fragment] [--out benchmark.json]" << std::endl
+                << "       " << argv[0] << " --check dir [--update] [--time-threshold 0.15] [--delta-e 2.3] [--max-differing 0.001] [--frames n] [--size 640x360]" << std::endl;
+            return false;
+        }
+    }
+    for (const auto& it : options.scenes)
+    {
+        if (it != "grid" && it.find_first_not_of("0123456789") != std::string::npos)
+            throw std::invalid_argument("unknown scene " + it);
+    }
+    bool check = !options.checkDirectory.empty();
+    if (options.frames == 0)
+        options.frames = check ? 60 : 240;
+    if (options.width == 0)
+    {
+        options.width = check ? 640 : 1280;
+        options.height = check ? 360 : 720;
+    }
+    return true;
+}
+
+static std::string escape(const std::string& s)
+{
+    std::string escaped;
+    for (char c : s)
+    {
+        if (c == '"' || c == '\\')
+            escaped += '\\';
+        escaped += c;
+    }
+    return escaped;
+}
+
+static void writeSummary(std::ostream& out, const char* name, const Summary& summary)
+{
+    out << "\"" << name << "\":{\"mean\":" << summary.mean << ",\"p50\":" << summary.p50 << ",\"p95\":" << summary.p95
+        << ",\"p99\":" << summary.p99 << ",\"max\":" << summary.max << "}";
+}
+
+static bool writeJson(const std::string& path, const BenchmarkOptions& options, const std::string& renderer, const std::string& post,
+    double loadMilliseconds, const std::vector<SceneResult>& results)
+{
+    std::ofstream file(path);
+    file << std::fixed << std::setprecision(4);
+    file << "{\n  \"renderer\":\"" << escape(renderer) << "\",\n  \"model\":\"" << escape(options.model) << "\",\n  \"width\":" << options.width
+        << ",\n  \"height\":" << options.height << ",\n  \"frames\":" << options.frames << ",\n  \"warmup\":" << options.warmup
+        << ",\n  \"camera_path\":\"" << escape(options.cameraPath.empty() ? "orbit" : options.cameraPath) << "\",\n  \"post\":\"" << post
+        << "\",\n  \"load_ms\":" << loadMilliseconds << ",\n  \"scenes\":[\n";
+    for (size_t i = 0; i < results.size(); ++i)
+    {
+        const SceneResult& result = results[i];
+        file << "    {\"name\":\"" << escape(result.name) << "\",\"instances\":" << result.instances << ",\"draw_calls\":" << result.stats.drawCalls
+            << ",\"triangles\":" << result.stats.triangles << ",\"checksum\":" << result.checksum;
+        if (dc::AllocationTracker::get().installed())
+            file << ",\"frame_allocations\":" << result.frameAllocations << ",\"frame_allocated_bytes\":" << result.frameAllocatedBytes;
+        file << ",\n     ";
+        writeSummary(file, "cpu_ms", result.cpu);
+        file << ",\n     ";
+        writeSummary(file, "frame_ms", result.frame);
+        file << ",\n     ";
+        writeSummary(file, "gpu_ms", result.gpu);
+        file << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    file << "  ]\n}\n";
+    if (!file)
+    {
+        std::cout << "failed to write " << path << std::endl;
+        return false;
+    }
+    return true;
+}
+
+static SceneResult runScene(const std::string& name, Renderer& renderer, const dc::Mesh& mesh, const BenchmarkOptions& options, dc::FrameBuffer& output)
+{
+    SceneResult result;
+    result.name = name;
+
+    // the grid is seen like in the window, synthetic grids from high enough to fit on screen
+    OrbitCamera camera = defaultCamera();
+    std::vector<glm::mat4> instances;
+    float zNear = 0.1f;
+    float zFar = 100.0f;
+    if (name == "grid")
+    {
+        instances = sceneInstances();
+    }
+    else
+    {
+        instances = gridInstances(mesh, static_cast<unsigned>(std::stoul(name)));
+        glm::vec3 size = mesh.boundsMax() - mesh.boundsMin();
+        float extent = std::sqrt(static_cast<float>(instances.size())) * glm::max(size.x, size.z) * 1.1f;
+        camera.target = glm::vec3(0.0f, (mesh.boundsMin().y + mesh.boundsMax().y) * 0.5f, 0.0f);
+        camera.elevation = 0.7f;
+        camera.distance = glm::max(extent, 4.0f);
+        zNear = camera.distance * 0.01f;
+        zFar = camera.distance + extent;
+    }
+    result.instances = instances.size();
+    glm::mat4 projection = glm::perspectiveFov<float>(glm::radians(60.0f), static_cast<float>(options.width), static_cast<float>(options.height), zNear, zFar);
+    CameraPath path = options.cameraPath.empty() ? CameraPath::turntable(camera, 1.0f) : CameraPath::load(options.cameraPath, camera.target);
+
+    for (unsigned i = 0; i < options.warmup; ++i)
+    {
+        renderer.render(mesh, instances, path.sample(0.0f).getViewMatrix(), projection, &output);
+    }
+    glFinish();
+    dc::endRenderStatsFrame();
+
+    dc::GpuTimer gpuTimer(4, options.frames);
+    std::vector<double> cpu;
+    std::vector<double> frame;
+    cpu.reserve(options.frames);
+    frame.reserve(options.frames);
+    dc::AllocationCounts allocations = dc::AllocationTracker::get().counts(dc::AllocationTag::Frame);
+    for (unsigned i = 0; i < options.frames; ++i)
+    {
+        glm::mat4 view = path.sample(path.duration() * i / options.frames).getViewMatrix();
+        auto start = std::chrono::high_resolution_clock::now();
+        gpuTimer.begin("frame");
+        renderer.render(mesh, instances, view, projection, &output);
+        gpuTimer.end();
+        cpu.push_back(std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count());
+        glFinish();
+        frame.push_back(std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count());
+        result.stats = dc::endRenderStatsFrame();
+    }
+    dc::AllocationCounts allocated = dc::AllocationTracker::get().counts(dc::AllocationTag::Frame);
+    result.frameAllocations = allocated.allocations - allocations.allocations;
+    result.frameAllocatedBytes = allocated.bytes - allocations.bytes;
+    gpuTimer.flush();
+    std::vector<double> gpu = gpuTimer.samples("frame");
+    result.cpu = summarize(cpu);
+    result.frame = summarize(frame);
+    result.gpu = summarize(gpu);
+
+    // independent of the frame count, and for --check of the camera path's end
+    renderer.render(mesh, instances, path.sample(0.0f).getViewMatrix(), projection, &output);
+    result.pixels.resize(options.width * options.height * 4);
+    output.bind();
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    glReadPixels(0, 0, options.width, options.height, GL_RGBA, GL_UNSIGNED_BYTE, result.pixels.data());
+    output.unbind();
+    result.checksum = 2166136261u;
+    for (unsigned char value : result.pixels)
+    {
+        result.checksum = (result.checksum ^ value) * 16777619u;
+    }
+    return result;
+}
+
+// the regression check renders each with default settings changed by configure
+struct ReferenceScene
+{
+    const char* name;
+    // benchmark scene, see runScene
+    const char* scene;
+    void(*configure)(Renderer::Settings& settings);
+    bool needsGL43;
+};
+
+static const ReferenceScene referenceScenes[] = {
+    { "fragment", "grid", [](Renderer::Settings& settings) { settings.useCompute = false; }, false },
+    { "compute", "grid", [](Renderer::Settings& settings) { settings.useCompute = true; }, true },
+    { "jump-flood", "grid", [](Renderer::Settings& settings) { settings.outlineWidth = 3.0f; }, false },
+    { "geometry-edges", "grid", [](Renderer::Settings& settings) { settings.useGeometryEdges = true; }, false },
+    { "depth-prepass", "100", [](Renderer::Settings& settings) { settings.useDepthPrepass = true; }, false },
+    { "hi-z", "100", [](Renderer::Settings& settings) { settings.useHiZ = true; }, true }
+};
+
+// "renderer <GL_RENDERER>" and "<scene> <frame p50 ms>" per line, # starts a comment
+struct Baseline
+{
+    std::string renderer;
+    std::map<std::string, double> milliseconds;
+
+    static Baseline load(const std::string& path)
+    {
+        Baseline baseline;
+        std::ifstream file(path);
+        std::string line;
+        while (std::getline(file, line))
+        {
+            line = line.substr(0, line.find('#'));
+            std::istringstream iss(line);
+            std::string key;
+            if (!(iss >> key))
+                continue;
+            if (key == "renderer")
+            {
+                std::getline(iss >> std::ws, baseline.renderer);
+                continue;
+            }
+            double value;
+            if (!(iss >> value))
+                throw std::runtime_error("unable to parse baseline line " + line);
+            baseline.milliseconds[key] = value;
+        }
+        return baseline;
+    }
+
+    bool save(const std::string& path) const
+    {
+        std::ofstream file(path);
+        file << "# frame time p50 per reference scene in ms, written by Benchmark --check --update\n";
+        file << "renderer " << renderer << "\n" << std::fixed << std::setprecision(3);
+        for (const auto& it : milliseconds)
+        {
+            file << it.first << " " << it.second << "\n";
+        }
+        if (!file)
+        {
+            std::cout << "failed to write " << path << std::endl;
+            return false;
+        }
+        return true;
+    }
+};
+
+// Renders the reference scenes and compares each against <dir>/<name>.png, perceptually
+// so rasterization noise passes, and its frame time p50 against <dir>/baseline.txt. Times
+// are only compared on the renderer the baseline was taken on, and only when slower. A
+// failed image leaves <name>.actual.png and <name>.diff.png in the working directory.
+// --update writes the goldens and the baseline from this run instead. With allocation
+// tracking compiled in, a scene also fails when its measured frames allocate. Before the
+// scenes every g-buffer layout's normal encoding is checked against its error bound. The
+// compute post process also has to give exactly the fragment shader's image, so the two
+// paths cannot drift apart through an --update.
+static int runCheck(const BenchmarkOptions& options, Renderer& renderer, const dc::Mesh& mesh, dc::FrameBuffer& output, bool computeSupported, const std::string& rendererName)
+{
+    std::string baselinePath = options.checkDirectory + "/baseline.txt";
+    Baseline baseline;
+    try
+    {
+        baseline = Baseline::load(baselinePath);
+    }
+    catch (const std::exception& e)
+    {
+        std::cout << e.what() << std::endl;
+        return -1;
+    }
+    bool compareTimes = !options.update && baseline.renderer == rendererName;
+    if (!options.update && !baseline.renderer.empty() && !compareTimes)
+        std::cout << "baseline taken on " << baseline.renderer << ", frame times are not compared" << std::endl;
+    else if (!options.update && baseline.renderer.empty())
+        std::cout << "no baseline in " << baselinePath << ", frame times are not compared" << std::endl;
+
+    Baseline updated;
+    updated.renderer = rendererName;
+    const Renderer::Settings defaults = renderer.settings;
+    // the encodings are checked on the CPU, a regression there fails like a scene
+    unsigned failures = dc::checkGBufferLayouts(std::cout);
+    std::vector<unsigned char> fragmentPixels;
+    std::cout << std::left << std::setw(16) << "reference" << std::right << std::setw(12) << "differing" << std::setw(10) << "max dE"
+        << std::setw(11) << "frame p50" << std::setw(10) << "baseline" << "  result" << std::endl;
+    for (const auto& reference : referenceScenes)
+    {
+        if (reference.needsGL43 && !computeSupported)
+        {
+            std::cout << std::left << std::setw(16) << reference.name << " needs GL 4.3, skipped" << std::endl;
+            continue;
+        }
+        renderer.settings = defaults;
+        reference.configure(renderer.settings);
+        SceneResult result;
+        try
+        {
+            result = runScene(reference.scene, renderer, mesh, options, output);
+        }
+        catch (const std::exception& e)
+        {
+            std::cout << reference.name << ": " << e.what() << std::endl;
+            return -1;
+        }
+        std::string golden = options.checkDirectory + "/" + reference.name + ".png";
+        std::string problem;
+        if (std::string(reference.name) == "fragment")
+        {
+            fragmentPixels = result.pixels;
+        }
+        else if (std::string(reference.name) == "compute" && !fragmentPixels.empty())
+        {
+            dc::ImageDifference paths = dc::compareImages(fragmentPixels.data(), result.pixels.data(), options.width, options.height, 4);
+            if (paths.differingShare > 0.0)
+            {
+                std::ostringstream differs;
+                differs << std::fixed << std::setprecision(3) << paths.differingShare * 100.0 << "% pixels differ from fragment";
+                problem = differs.str();
+            }
+        }
+        std::cout << std::left << std::setw(16) << reference.name << std::right << std::fixed;
+        if (options.update)
+        {
+            updated.milliseconds[reference.name] = result.frame.p50;
+            bool written = problem.empty() && dc::writePng(golden, result.pixels.data(), options.width, options.height, 4, true);
+            std::cout << std::setw(33) << std::setprecision(2) << result.frame.p50 << std::setw(10) << "" << "  " << (written ? "updated" : "FAILED, " + problem) << std::endl;
+            failures += written ? 0 : 1;
+            continue;
+        }
+
+        // bottom up like the readback
+        int width = 0, height = 0, channels = 0;
+        stbi_set_flip_vertically_on_load(true);
+        unsigned char* expected = stbi_load(golden.c_str(), &width, &height, &channels, 4);
+        stbi_set_flip_vertically_on_load(false);
+        dc::PerceptualDifference difference;
+        if (!expected)
+        {
+            problem += (problem.empty() ? "" : ", ") + ("no golden " + golden);
+        }
+        else if (static_cast<unsigned>(width) != options.width || static_cast<unsigned>(height) != options.height)
+        {
+            problem += (problem.empty() ? "" : ", ") + ("golden is " + std::to_string(width) + "x" + std::to_string(height));
+        }
+        else
+        {
+            std::vector<unsigned char> diff;
+            difference = dc::compareImagesPerceptual(expected, result.pixels.data(), options.width, options.height, 4, options.deltaE, 1, &diff);
+            if (difference.differingShare > options.differingShare)
+            {
+                problem += (problem.empty() ? "" : ", ") + std::string("image differs");
+                dc::writePng(std::string(reference.name) + ".actual.png", result.pixels.data(), options.width, options.height, 4, true);
+                dc::writePng(std::string(reference.name) + ".diff.png", diff.data(), options.width, options.height, 3, true);
+            }
+        }
+        stbi_image_free(expected);
+
+        auto it = baseline.milliseconds.find(reference.name);
+        bool timed = compareTimes && it != baseline.milliseconds.end();
+        if (timed && result.frame.p50 > it->second * (1.0 + options.timeThreshold))
+        {
+            std::ostringstream slower;
+            slower << std::fixed << std::setprecision(0) << (result.frame.p50 / it->second - 1.0) * 100.0 << "% slower";
+            problem += (problem.empty() ? "" : ", ") + slower.str();
+        }
+        // the warm-up frames may size their buffers, after that a frame reuses them
+        if (result.frameAllocations > 0)
+        {
+            problem += (problem.empty() ? "" : ", ") + std::to_string(result.frameAllocations) + " allocations in "
+                + std::to_string(options.frames) + " frames";
+        }
+        std::cout << std::setw(11) << std::setprecision(3) << difference.differingShare * 100.0 << "%" << std::setw(10) << std::setprecision(1) << difference.maxDeltaE
+            << std::setw(11) << std::setprecision(2) << result.frame.p50 << std::setw(10);
+        if (timed)
+            std::cout << it->second;
+        else
+            std::cout << "-";
+        std::cout << "  " << (problem.empty() ? "ok" : "FAILED, " + problem) << std::endl;
+        failures += problem.empty() ? 0 : 1;
+    }
+    renderer.settings = defaults;
+
+    if (options.update)
+    {
+        if (!updated.save(baselinePath))
+            return -1;
+        std::cout << "wrote " << baselinePath << std::endl;
+    }
+    if (failures > 0)
+    {
+        std::cout << failures << " checks failed" << std::endl;
+        return -1;
+    }
+    return 0;
+}
+
+// the scenes or the check, everything holding GL objects lives and dies in here
+static int runBenchmark(const BenchmarkOptions& options, bool computeSupported, const std::string& rendererName)
+{
+    DC_GPU_RESOURCE_SCOPE("benchmark");
+    Renderer renderer(options.width, options.height, 1, dc::GBufferLayout::classic(), clearColor, computeSupported);
+    if (!options.post.empty())
+        renderer.settings.useCompute = computeSupported && options.post == "compute";
+    dc::FrameBuffer output(options.width, options.height, { { dc::FBAttachmentType::AttachColor, dc::TextureFormat::RGBA8 } });
+
+    // parse and upload, the time until the first frame could start
+    auto start = std::chrono::high_resolution_clock::now();
+    dc::ObjLoader loader(options.model);
+    auto mesh = loader.exportMesh();
+    glFinish();
+    double loadMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+    std::cout << std::fixed << std::setprecision(2) << options.model << " loaded in " << loadMilliseconds << " ms" << std::endl;
+    // the geometry edges reference scene needs them, kept out of the load time
+    mesh->setFeatureEdges(loader.exportFeatureEdges());
+    if (dc::AllocationTracker::get().installed())
+        dc::AllocationTracker::get().report(std::cout);
+    dc::GpuResources::get().report(std::cout);
+
+    if (!options.checkDirectory.empty())
+        return runCheck(options, renderer, *mesh, output, computeSupported, rendererName);
+
+    std::vector<SceneResult> results;
+    std::cout << std::left << std::setw(10) << "scene" << std::right << std::setw(10) << "instances" << std::setw(10) << "draws"
+        << std::setw(9) << "cpu p50" << std::setw(9) << "cpu p99" << std::setw(9) << "gpu p50" << std::setw(9) << "gpu p99"
+        << std::setw(10) << "frame p50" << std::setw(10) << "frame p99" << std::endl;
+    for (const auto& it : options.scenes)
+    {
+        SceneResult result;
+        try
+        {
+            result = runScene(it, renderer, *mesh, options, output);
+        }
+        catch (const std::exception& e)
+        {
+            std::cout << it << ": " << e.what() << std::endl;
+            return -1;
+        }
+        std::cout << std::left << std::setw(10) << result.name << std::right << std::setw(10) << result.instances << std::setw(10) << result.stats.drawCalls
+            << std::setw(9) << result.cpu.p50 << std::setw(9) << result.cpu.p99 << std::setw(9) << result.gpu.p50 << std::setw(9) << result.gpu.p99
+            << std::setw(10) << result.frame.p50 << std::setw(10) << result.frame.p99 << std::endl;
+        results.push_back(result);
+    }
+
+    if (!writeJson(options.output, options, rendererName, renderer.postName(), loadMilliseconds, results))
+        return -1;
+    std::cout << "wrote " << options.output << std::endl;
+    return 0;
+}
+
+int main(int argc, char** argv)
+{
+    BenchmarkOptions options;
+    try
+    {
+        if (!parseOptions(argc, argv, options))
+            return -1;
+    }
+    catch (const std::exception& e)
+    {
+        std::cout << e.what() << std::endl;
+        return -1;
+    }
+
+#ifdef DC_USE_EGL
+    // Mesa's llvmpipe even where a GPU is present, so the goldens see the same rasterizer everywhere
+    if (!options.checkDirectory.empty())
+        setenv("LIBGL_ALWAYS_SOFTWARE", "1", 0);
+#endif
+    HeadlessContext context;
+    if (!context.create())
+        return -1;
+    bool computeSupported = dc::loadGL43(context.loader());
+    std::string rendererName = reinterpret_cast<const char*>(glGetString(GL_RENDERER));
+    std::cout << "benchmark on " << rendererName << ", GL " << glGetString(GL_VERSION) << std::endl;
+
+    int result = runBenchmark(options, computeSupported, rendererName);
+    // what the registry still holds was never deleted
+    if (dc::GpuResources::get().reportLeaks(std::cout) > 0)
+        result = -1;
+    return result;
+}
\ No newline at end of file
@@ -0,0 +1,7 @@
+#version 330 core
+
+// fragment stage of the depth pre-pass, depth is all it writes
+
+void main()
+{
+}
\ No newline at end of file
@@ -2,16 +2,36 @@
 
 in vec3 normal;
 
+#ifdef MATERIAL_ID
+layout (location = 0) out uint colorFragment;
+#else
 layout (location = 0) out vec4 colorFragment;
+#endif
 layout (location = 1) out vec4 normalFragment;
 
 uniform vec3 Ka;
 uniform vec3 Kd;
 uniform vec3 Ks;
+uniform int materialId;
+
+vec2 octEncode(vec3 n)
+{
+    n /= abs(n.x) + abs(n.y) + abs(n.z);
+    vec2 signs = vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+    return n.z >= 0.0 ? n.xy : (1.0 - abs(n.yx)) * signs;
+}
 
 void main()
 {
+#ifdef MATERIAL_ID
+    colorFragment = uint(materialId);
+#else
     colorFragment = vec4(Kd, 1);
+#endif
     vec3 N = normalize(normal);
+#ifdef NORMAL_OCTAHEDRAL
+    normalFragment = vec4(octEncode(N) * 0.5 + 0.5, 0, 1);
+#else
     normalFragment = vec4(N * 0.5 + 0.5, 1);
+#endif
 }
\ No newline at end of file
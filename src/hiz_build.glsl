@@ -0,0 +1,41 @@
+#version 430 core
+
+// One level of the hierarchical depth buffer per dispatch, keeping the farthest depth of
+// the texels each target texel covers in the source, including the row and column an
+// odd source size leaves over. Level 0 is reduced from the g-buffer depth (FROM_DEPTH)
+// and so already has half its resolution, every further level from the one above.
+
+layout (local_size_x = 8, local_size_y = 8) in;
+
+#ifdef FROM_DEPTH
+uniform sampler2D depthTexture;
+
+ivec2 sourceSize() { return textureSize(depthTexture, 0); }
+float source(ivec2 p) { return texelFetch(depthTexture, p, 0).r; }
+#else
+layout (r32f) readonly uniform image2D sourceLevel;
+
+ivec2 sourceSize() { return imageSize(sourceLevel); }
+float source(ivec2 p) { return imageLoad(sourceLevel, p).r; }
+#endif
+layout (r32f) writeonly uniform image2D targetLevel;
+
+void main()
+{
+    ivec2 target = ivec2(gl_GlobalInvocationID.xy);
+    ivec2 size = imageSize(targetLevel);
+    if (any(greaterThanEqual(target, size)))
+        return;
+
+    ivec2 first = target * 2;
+    ivec2 last = min(first + 1 + ivec2(equal(target, size - 1)) * (sourceSize() & 1), sourceSize() - 1);
+    float depth = 0.0;
+    for (int y = first.y; y <= last.y; ++y)
+    {
+        for (int x = first.x; x <= last.x; ++x)
+        {
+            depth = max(depth, source(ivec2(x, y)));
+        }
+    }
+    imageStore(targetLevel, target, vec4(depth));
+}
\ No newline at end of file
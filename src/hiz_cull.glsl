@@ -0,0 +1,152 @@
+#version 430 core
+
+// Frustum and occlusion test of every instance's bounds. Visible instances are appended
+// to the id list the vertex shader (GPU_INSTANCES) reads and counted into the indirect
+// draw command of every material group. The first pass tests against the hierarchical
+// depth of the previous frame, seen with the previous camera; the second pass retests
+// what the first one found occluded against the depth the first pass just drew.
+
+layout (local_size_x = 64) in;
+
+struct DrawCommand
+{
+    uint count;
+    uint instanceCount;
+    uint firstIndex;
+    uint baseVertex;
+    uint baseInstance;
+};
+
+layout (std430, binding = 0) readonly buffer Instances
+{
+    mat4 models[];
+};
+
+layout (std430, binding = 1) buffer States
+{
+    uint states[];
+};
+
+layout (std430, binding = 2) buffer Commands
+{
+    DrawCommand commands[];
+};
+
+layout (std430, binding = 3) writeonly buffer VisibleIds
+{
+    uint visibleIds[];
+};
+
+const uint Culled = 0u;
+const uint Drawn = 1u;
+const uint Occluded = 2u;
+const uint DrawnLate = 3u;
+
+uniform int instanceCount;
+uniform int groupCount;
+// 0 or 1, selects the commands and the half of visibleIds written
+uniform int pass;
+uniform vec3 boundsMin;
+uniform vec3 boundsMax;
+// camera of the frame being drawn
+uniform mat4 viewProjection;
+// camera the hierarchical depth was drawn with
+uniform mat4 depthViewProjection;
+// false while there is no previous frame to test against
+uniform bool testDepth = true;
+uniform sampler2D hiZ;
+
+vec3 corner(int i)
+{
+    return mix(boundsMin, boundsMax, vec3(i & 1, (i >> 1) & 1, (i >> 2) & 1));
+}
+
+bool outsideFrustum(mat4 mvp)
+{
+    // corners outside -x, +x, -y, +y, -z, +z, all eight outside one plane culls
+    ivec3 below = ivec3(0);
+    ivec3 above = ivec3(0);
+    for (int i = 0; i < 8; ++i)
+    {
+        vec4 clip = mvp * vec4(corner(i), 1.0);
+        below += ivec3(lessThan(clip.xyz, vec3(-clip.w)));
+        above += ivec3(greaterThan(clip.xyz, vec3(clip.w)));
+    }
+    return any(equal(below, ivec3(8))) || any(equal(above, ivec3(8)));
+}
+
+bool occluded(mat4 mvp)
+{
+    vec2 lo = vec2(1.0);
+    vec2 hi = vec2(0.0);
+    float zMin = 1.0;
+    for (int i = 0; i < 8; ++i)
+    {
+        vec4 clip = mvp * vec4(corner(i), 1.0);
+        // reaches behind the camera, nothing to test against
+        if (clip.w <= 1e-3)
+            return false;
+        vec3 window = clip.xyz / clip.w * 0.5 + 0.5;
+        lo = min(lo, window.xy);
+        hi = max(hi, window.xy);
+        zMin = min(zMin, window.z);
+    }
+
+    // texels of level 0 under the bounds, then the level where they span at most 2x2 texels
+    ivec2 size = textureSize(hiZ, 0);
+    ivec2 first = clamp(ivec2(clamp(lo, 0.0, 1.0) * vec2(size)), ivec2(0), size - 1);
+    ivec2 last = clamp(ivec2(clamp(hi, 0.0, 1.0) * vec2(size)), ivec2(0), size - 1);
+    int extent = max(last.x - first.x, last.y - first.y) + 1;
+    int level = min(int(ceil(log2(float(extent)))), textureQueryLevels(hiZ) - 1);
+    // as allocated by dc::Texture, not textureSize, which some drivers answer with the base size
+    ivec2 levelSize = max(size >> level, ivec2(1));
+    first = min(first >> level, levelSize - 1);
+    last = min(last >> level, levelSize - 1);
+
+    float zMax = 0.0;
+    for (int y = first.y; y <= last.y; ++y)
+    {
+        for (int x = first.x; x <= last.x; ++x)
+        {
+            zMax = max(zMax, texelFetch(hiZ, ivec2(x, y), level).r);
+        }
+    }
+    return zMin > zMax;
+}
+
+void main()
+{
+    uint id = gl_GlobalInvocationID.x;
+    if (id >= uint(instanceCount))
+        return;
+
+    mat4 model = models[id];
+    if (pass == 0)
+    {
+        if (outsideFrustum(viewProjection * model))
+        {
+            states[id] = Culled;
+            return;
+        }
+        if (testDepth && occluded(depthViewProjection * model))
+        {
+            states[id] = Occluded;
+            return;
+        }
+        states[id] = Drawn;
+    }
+    else
+    {
+        if (states[id] != Occluded || occluded(viewProjection * model))
+            return;
+        states[id] = DrawnLate;
+    }
+
+    int first = pass * groupCount;
+    uint slot = atomicAdd(commands[first].instanceCount, 1u);
+    for (int group = 1; group < groupCount; ++group)
+    {
+        atomicAdd(commands[first + group].instanceCount, 1u);
+    }
+    visibleIds[uint(pass * instanceCount) + slot] = id;
+}
\ No newline at end of file
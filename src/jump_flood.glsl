@@ -0,0 +1,43 @@
+#version 330 core
+
+// One jump flood step: every pixel keeps the nearest seed among its own and the ones
+// stored stepSize pixels away in all eight directions.
+
+uniform usampler2D seedTexture;
+uniform int stepSize;
+
+out uvec2 nearestSeed;
+
+const uint NoSeed = 0xFFFFu;
+
+void main()
+{
+    ivec2 size = textureSize(seedTexture, 0);
+    ivec2 pixel = ivec2(gl_FragCoord.xy);
+
+    uvec2 best = uvec2(NoSeed);
+    int bestDist = 0x7FFFFFFF;
+    for (int y = -1; y <= 1; ++y)
+    {
+        for (int x = -1; x <= 1; ++x)
+        {
+            ivec2 tap = pixel + ivec2(x, y) * stepSize;
+            if (any(lessThan(tap, ivec2(0))) || any(greaterThanEqual(tap, size)))
+                continue;
+
+            uvec2 candidate = texelFetch(seedTexture, tap, 0).rg;
+            if (candidate.x == NoSeed)
+                continue;
+
+            ivec2 delta = ivec2(candidate) - pixel;
+            int dist = delta.x * delta.x + delta.y * delta.y;
+            if (dist < bestDist)
+            {
+                bestDist = dist;
+                best = candidate;
+            }
+        }
+    }
+
+    nearestSeed = best;
+}
\ No newline at end of file
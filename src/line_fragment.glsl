@@ -0,0 +1,25 @@
+#version 330 core
+
+// 1 where a visible feature line covers the pixel
+out float edgeMask;
+
+// g-buffer depth, lines lie on the surfaces they outline so the depth test is done here
+// with a tolerance instead of by the fixed function test
+uniform sampler2D depthTexture;
+uniform float zNear = 0.1;
+uniform float zFar = 100.0;
+uniform float depthTolerance = 0.01;
+
+float linearize(float depthSample)
+{
+    depthSample = 2.0 * depthSample - 1.0;
+    return 2.0 * zNear * zFar / (zFar + zNear - depthSample * (zFar - zNear));
+}
+
+void main()
+{
+    float sceneDepth = linearize(texelFetch(depthTexture, ivec2(gl_FragCoord.xy), 0).r);
+    if (linearize(gl_FragCoord.z) > sceneDepth * (1.0 + depthTolerance) + depthTolerance)
+        discard;
+    edgeMask = 1.0;
+}
\ No newline at end of file
@@ -4,42 +4,70 @@
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
+#include <chrono>
 #include <iostream>
+#include <sstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
 
-#include <dc/Shader.hpp>
+#if DC_TRACK_ALLOCATIONS
+#define DC_ALLOCATION_TRACKER_IMPLEMENTATION
+#endif
+#include <dc/AllocationTracker.hpp>
 #include <dc/ObjLoader.hpp>
 #include <dc/Mesh.hpp>
-#include <dc/Texture.hpp>
 #include <dc/FrameBuffer.hpp>
+#include <dc/GBuffer.hpp>
+#include <dc/FrameCapture.hpp>
+#include <dc/GLExtensions.hpp>
+#include <dc/GpuResources.hpp>
+#include <dc/ImageCompare.hpp>
+#include <dc/PngWriter.hpp>
+#include <dc/Profiler.hpp>
+#include <dc/RenderStats.hpp>
+
+#include "CameraPath.hpp"
+#include "CityScene.hpp"
+#include "FramePacer.hpp"
+#include "FrameTrace.hpp"
+#include "HeadlessContext.hpp"
+#include "OrbitCamera.hpp"
+#include "OcclusionCuller.hpp"
+#include "PerfOverlay.hpp"
+#include "RedrawTracker.hpp"
+#include "Renderer.hpp"
+#include "Scene.hpp"
+#include "SoftwareRenderer.hpp"
+#include "Thumbnails.hpp"
 
 const unsigned int dpi_scale = 1;
 const unsigned int width = 1280 * dpi_scale;
 const unsigned int height = 720 * dpi_scale;
 const unsigned int fboDownscale = 1;
-
-struct OrbitCamera
-{
-    glm::vec3 target;
-    float azimuth;
-    float elevation;
-    float distance;
-    bool moving;
-
-    int lastX;
-    int lastY;
-
-    glm::mat4 getViewMatrix() const
-    {
-        glm::vec3 eyePos{ sin(elevation) * cos(azimuth), cos(elevation), sin(elevation) * sin(azimuth) };
-        eyePos *= distance;
-        return glm::lookAt(target + eyePos, target, { 0.0f, 1.0f, 0.0f });
-    }
-};
+const dc::GBufferLayout gbufferLayout = dc::GBufferLayout::classic();
+const glm::vec3 clearColor{ 0.2f, 0.3f, 0.3f };
+const std::string defaultModel = "../models/basic_model.obj";
 
 OrbitCamera* camera = nullptr;
+// marked by the callbacks below, see RedrawTracker
+RedrawTracker* redraw = nullptr;
+// sees the mouse first while it is shown
+PerfOverlay* overlay = nullptr;
+
+glm::mat4 defaultProjection()
+{
+    return glm::perspectiveFov<float>(glm::radians(60.0f), width, height, 0.1f, 100.0f);
+    //return glm::ortho<float>(-10, 10, -8, 8, 0.1f, 100.0f);
+}
 
-static void mouse_button_callback(GLFWwindow* window, int button, int state, int)
+static void mouse_button_callback(GLFWwindow* window, int button, int state, int mods)
 {
+    if (overlay && overlay->mouseButton(window, button, state, mods) && state == GLFW_PRESS)
+        return;
     if (camera)
     {
         if (button == GLFW_MOUSE_BUTTON_LEFT)
@@ -64,6 +92,8 @@ static void cursor_pos_callback(GLFWwindow* window, double x, double y)
             camera->azimuth -= deltaX * 0.01f;
             camera->elevation += deltaY * 0.01f;
             camera->elevation = glm::clamp(camera->elevation, 0.001f, glm::pi<float>());
+            if (redraw && (deltaX != 0 || deltaY != 0))
+                redraw->markScene();
         }
 
         camera->lastX = curX;
@@ -73,23 +103,1226 @@ static void cursor_pos_callback(GLFWwindow* window, double x, double y)
 
 static void scroll_callback(GLFWwindow* window, double xoffset, double yoffset)
 {
+    if (overlay && overlay->scroll(window, xoffset, yoffset))
+        return;
     if (camera)
     {
         camera->distance -= yoffset;
         camera->distance = glm::clamp(camera->distance, 1.0f, 100.0f);
+        if (redraw)
+            redraw->markScene();
+    }
+}
+
+// the window was uncovered or resized, its contents are shaded again from the g-buffer
+static void refresh_callback(GLFWwindow*)
+{
+    if (redraw)
+        redraw->markPost();
+}
+
+struct Options
+{
+    std::string model = defaultModel;
+    // render without a window and write the final image here
+    std::string headlessOutput;
+    // render a camera path offscreen and capture every frame
+    bool headlessCapture = false;
+    // frames rendered before the capture, later frames see warm caches and timer results.
+    // For sequences the frame count, 0 derives it from the path duration
+    unsigned frames = 0;
+    // keyframes for the sequence, see CameraPath::load, empty renders a turntable
+    std::string cameraPath;
+    float fps = 30.0f;
+    unsigned captureRing = 3;
+    unsigned encoders = 2;
+    // post process override for the offscreen modes, empty keeps the default
+    std::string post;
+    // renders a preview of every model in a directory or manifest instead
+    bool batch = false;
+    ThumbnailOptions thumbnails;
+    // writes every frame as <prefix>00000.png, offscreen while orbiting or with R in the window
+    std::string capturePrefix;
+    // reads back with a blocking glReadPixels and encodes on the render thread, for comparison
+    bool captureSync = false;
+    // per-frame timings of the capture run as CSV
+    std::string tracePath;
+    // renders with the software renderer instead and writes the image here, no GL needed
+    std::string softwareOutput;
+    // 0 uses every hardware thread
+    unsigned threads = 0;
+    bool softwareBenchmark = false;
+    // renders with llvmpipe and the software renderer, writes <prefix>gl.png, cpu.png and diff.png
+    std::string comparePrefix;
+    // times every CpuStylize path on the software renderer's g-buffer
+    bool postBenchmark = false;
+    // runs CpuStylize on the GL g-buffer and checks it against the fragment post process
+    std::string postComparePrefix;
+    // culls a synthetic city from street level, writes <prefix>occlusion.png and <prefix>culled.png
+    std::string occlusionPrefix;
+    // blocks along each side of the city
+    unsigned blocks = 16;
+    // the window renders every iteration instead of only after something changed
+    bool continuous = false;
+    // culls an instance grid with HiZCulling and checks every frame against occlusion queries
+    bool hiZCheck = false;
+    // shaded fragments per pixel and frame time with and without the depth pre-pass
+    bool overdraw = false;
+    // idle CPU usage of continuous and on-demand rendering, and the post process only redraw
+    bool onDemandCheck = false;
+    // the window starts in latency mode, see FramePacer, and toggles it with L
+    bool latency = false;
+    unsigned framesInFlight = 1;
+    // frames per second in latency mode, 0 takes the monitor's refresh rate
+    double frameCap = 0.0;
+    // modelled latency and frame time jitter of the window loop with and without latency mode
+    bool latencyEstimate = false;
+    // Chrome trace of the headless frames, the window writes one per P as profile_<n>.json
+    std::string profilePath;
+    // draw calls, binds, uniforms and uploads of every headless frame as CSV
+    std::string statsPath;
+};
+
+static bool parseOptions(int argc, char** argv, Options& options)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--headless" && hasValue)
+        {
+            options.headlessOutput = argv[++i];
+        }
+        else if (arg == "--headless-capture" && hasValue)
+        {
+            options.headlessCapture = true;
+            options.capturePrefix = argv[++i];
+        }
+        else if (arg == "--model" && hasValue)
+        {
+            options.model = argv[++i];
+        }
+        else if (arg == "--frames" && hasValue)
+        {
+            options.frames = glm::max(std::stoi(argv[++i]), 1);
+        }
+        else if (arg == "--post" && hasValue && (std::string(argv[i + 1]) == "compute" || std::string(argv[i + 1]) == "fragment"))
+        {
+            options.post = argv[++i];
+        }
+        else if (arg == "--batch" && hasValue)
+        {
+            options.batch = true;
+            options.thumbnails.input = argv[++i];
+        }
+        else if (arg == "--out" && hasValue)
+        {
+            options.thumbnails.outputDirectory = argv[++i];
+        }
+        else if (arg == "--size" && hasValue)
+        {
+            options.thumbnails.size = glm::max(std::stoi(argv[++i]), 16);
+        }
+        else if (arg == "--views" && hasValue)
+        {
+            options.thumbnails.views = ThumbnailOptions::parseViews(argv[++i]);
+        }
+        else if (arg == "--loaders" && hasValue)
+        {
+            options.thumbnails.loaders = glm::max(std::stoi(argv[++i]), 1);
+        }
+        else if (arg == "--encoders" && hasValue)
+        {
+            options.encoders = glm::max(std::stoi(argv[++i]), 1);
+            options.thumbnails.encoders = options.encoders;
+        }
+        else if (arg == "--path" && hasValue)
+        {
+            options.cameraPath = argv[++i];
+        }
+        else if (arg == "--fps" && hasValue)
+        {
+            options.fps = glm::max(std::stof(argv[++i]), 1.0f);
+        }
+        else if (arg == "--ring" && hasValue)
+        {
+            options.captureRing = glm::max(std::stoi(argv[++i]), 1);
+        }
+        else if (arg == "--capture" && hasValue)
+        {
+            options.capturePrefix = argv[++i];
+        }
+        else if (arg == "--capture-sync")
+        {
+            options.captureSync = true;
+        }
+        else if (arg == "--trace" && hasValue)
+        {
+            options.tracePath = argv[++i];
+        }
+        else if (arg == "--cpu" && hasValue)
+        {
+            options.softwareOutput = argv[++i];
+        }
+        else if (arg == "--threads" && hasValue)
+        {
+            options.threads = glm::max(std::stoi(argv[++i]), 1);
+        }
+        else if (arg == "--cpu-benchmark")
+        {
+            options.softwareBenchmark = true;
+        }
+        else if (arg == "--cpu-compare" && hasValue)
+        {
+            options.comparePrefix = argv[++i];
+        }
+        else if (arg == "--cpu-post-benchmark")
+        {
+            options.postBenchmark = true;
+        }
+        else if (arg == "--cpu-post-compare" && hasValue)
+        {
+            options.postComparePrefix = argv[++i];
+        }
+        else if (arg == "--occlusion" && hasValue)
+        {
+            options.occlusionPrefix = argv[++i];
+        }
+        else if (arg == "--blocks" && hasValue)
+        {
+            options.blocks = glm::max(std::stoi(argv[++i]), 1);
+        }
+        else if (arg == "--hiz-check")
+        {
+            options.hiZCheck = true;
+        }
+        else if (arg == "--overdraw")
+        {
+            options.overdraw = true;
+        }
+        else if (arg == "--continuous")
+        {
+            options.continuous = true;
+        }
+        else if (arg == "--profile" && hasValue)
+        {
+            options.profilePath = argv[++i];
+        }
+        else if (arg == "--stats" && hasValue)
+        {
+            options.statsPath = argv[++i];
+        }
+        else if (arg == "--on-demand-check")
+        {
+            options.onDemandCheck = true;
+        }
+        else if (arg == "--latency")
+        {
+            options.latency = true;
+        }
+        else if (arg == "--frames-in-flight" && hasValue)
+        {
+            options.framesInFlight = glm::max(std::stoi(argv[++i]), 1);
+        }
+        else if (arg == "--frame-cap" && hasValue)
+        {
+            options.frameCap = glm::max(std::stod(argv[++i]), 0.0);
+        }
+        else if (arg == "--latency-estimate")
+        {
+            options.latencyEstimate = true;
+        }
+        else
+        {
+            std::cout << "usage: " << argv[0] << " [--model file.obj] [--capture prefix] [--continuous] [--latency [--frames-in-flight n] [--frame-cap fps]]" << std::endl
+                << "       " << argv[0] << " --headless output.png [--frames n] [--profile trace.json] [--stats frames.csv]" << std::endl
+                << "       " << argv[0] << " --headless-capture prefix [--path keys.txt] [--fps n] [--frames n] [--ring n] [--encoders n] [--capture-sync] [--trace frames.csv]" << std::endl
+                << "       " << argv[0] << " --batch models/ [--out dir] [--size n] [--views \"az,el,dist;...\"] [--loaders n] [--encoders n]" << std::endl
+                << "       " << argv[0] << " --cpu output.png [--threads n] | --cpu-benchmark | --cpu-compare prefix" << std::endl
+                << "       " << argv[0] << " --cpu-post-benchmark | --cpu-post-compare prefix" << std::endl
+                << "       " << argv[0] << " --occlusion prefix [--blocks n] [--frames views]" << std::endl
+                << "       " << argv[0] << " --hiz-check [--blocks n] [--frames n]" << std::endl
+                << "       " << argv[0] << " --overdraw [--model file.obj] [--frames views]" << std::endl
+                << "       " << argv[0] << " --on-demand-check [--frames seconds]" << std::endl
+                << "       " << argv[0] << " --latency-estimate [--frames seconds] [--frames-in-flight n] [--frame-cap fps]" << std::endl
+                << "       offscreen modes take --post compute|fragment" << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+// Cost of one zone while recording and while the profiler is idle, timed over a capture
+// of its own that the following one replaces.
+static void printZoneOverhead(std::ostream& out)
+{
+    const unsigned zones = 200000;
+    dc::Profiler& profiler = dc::Profiler::get();
+    double nanoseconds[2] = {};
+    for (unsigned recording = 0; recording < 2; ++recording)
+    {
+        if (recording)
+        {
+            profiler.capture(1);
+            profiler.frame();
+        }
+        auto start = std::chrono::high_resolution_clock::now();
+        for (unsigned i = 0; i < zones; ++i)
+        {
+            dc::ProfileZone zone("overhead");
+        }
+        nanoseconds[recording] = std::chrono::duration<double, std::nano>(std::chrono::high_resolution_clock::now() - start).count() / zones;
+        if (recording)
+            profiler.frame();
+    }
+    out << std::fixed << std::setprecision(1) << "zone overhead " << nanoseconds[1] << " ns recording, " << nanoseconds[0] << " ns idle, "
+        << profiler.ticksPerMicrosecond() << " ticks per us" << std::endl;
+}
+
+static int runHeadless(const Options& options)
+{
+    HeadlessContext context;
+    if (!context.create())
+        return -1;
+    bool computeSupported = dc::loadGL43(context.loader());
+    std::cout << "headless " << glGetString(GL_RENDERER) << ", GL " << glGetString(GL_VERSION) << std::endl;
+
+    DC_GPU_RESOURCE_SCOPE("headless");
+    Renderer renderer(width, height, fboDownscale, gbufferLayout, clearColor, computeSupported);
+    if (!options.post.empty())
+        renderer.settings.useCompute = computeSupported && options.post == "compute";
+    dc::ObjLoader loader(options.model);
+    auto mesh = loader.exportMesh();
+    std::vector<glm::mat4> instances = sceneInstances();
+
+    // stands in for the window's back buffer
+    dc::FrameBuffer output(width, height, {
+        { dc::FBAttachmentType::AttachColor, dc::TextureFormat::RGBA8 }
+    });
+
+    // wall clock instead of the timer queries, which llvmpipe does not report reliably after compute passes
+    OrbitCamera view = defaultCamera();
+    unsigned frames = glm::max(options.frames, 1u);
+    if (!options.profilePath.empty())
+    {
+        printZoneOverhead(std::cout);
+        dc::Profiler::get().capture(frames);
+        dc::Profiler::get().frame();
+    }
+    // the setup uploads are not part of any frame
+    dc::endRenderStatsFrame();
+    std::vector<dc::RenderStats> stats;
+    auto start = std::chrono::high_resolution_clock::now();
+    for (unsigned i = 0; i < frames; ++i)
+    {
+        renderer.render(*mesh, instances, view.getViewMatrix(), defaultProjection(), &output);
+        stats.push_back(dc::endRenderStatsFrame());
+        if (!options.profilePath.empty())
+        {
+            {
+                // keeps the GPU time of each frame inside it, with llvmpipe that is most of it
+                DC_PROFILE_ZONE("glFinish");
+                glFinish();
+            }
+            dc::Profiler::get().frame();
+        }
+    }
+    glFinish();
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::high_resolution_clock::now() - start;
+    renderer.gpuTimer().flush();
+    if (!options.profilePath.empty())
+    {
+        dc::Profiler::get().stop();
+        if (!dc::Profiler::get().writeChromeTrace(options.profilePath))
+            return -1;
+        std::cout << "wrote " << options.profilePath << " (" << dc::Profiler::get().eventCount("Mesh::draw") << " Mesh::draw zones)" << std::endl;
+    }
+
+    std::vector<unsigned char> pixels(width * height * 3);
+    output.bind();
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, width, height, GL_RGB, GL_UNSIGNED_BYTE, pixels.data());
+    output.unbind();
+
+    std::cout << std::fixed << std::setprecision(2) << frames << " frames, " << renderer.postName() << " post, "
+        << elapsed.count() / frames << " ms per frame" << std::endl;
+    renderer.gpuTimer().printSummary(std::cout);
+    const dc::RenderStats& last = stats.back();
+    std::cout << "per frame " << last.drawCalls << " draw calls, " << last.triangles << " triangles, " << last.programBinds << " program binds, "
+        << last.uniforms << " uniforms, " << last.textureBinds << " texture binds, " << last.framebufferBinds << " framebuffer binds, "
+        << last.bufferUploads << " buffer uploads of " << last.bufferBytes << " bytes" << std::endl;
+    if (dc::AllocationTracker::get().installed())
+        dc::AllocationTracker::get().report(std::cout);
+    dc::GpuResources::get().report(std::cout);
+    if (!options.statsPath.empty())
+    {
+        if (!dc::writeRenderStatsCsv(options.statsPath, stats))
+            return -1;
+        std::cout << "wrote " << options.statsPath << std::endl;
+    }
+    if (!dc::writePng(options.headlessOutput, pixels.data(), width, height, 3, true))
+        return -1;
+    std::cout << "wrote " << options.headlessOutput << std::endl;
+    return 0;
+}
+
+// Renders a camera path offscreen and captures every frame. Render, readback and encoding
+// overlap: the GL thread renders frame n while the PBO ring still holds frames n-1 and n-2
+// and the encoder threads compress older ones, so throughput is bounded by the slowest
+// stage. --capture-sync serializes all three on the render thread for comparison.
+static int runSequence(const Options& options)
+{
+    HeadlessContext context;
+    if (!context.create())
+        return -1;
+    bool computeSupported = dc::loadGL43(context.loader());
+    std::cout << "sequence " << glGetString(GL_RENDERER) << ", GL " << glGetString(GL_VERSION) << std::endl;
+
+    Renderer renderer(width, height, fboDownscale, gbufferLayout, clearColor, computeSupported);
+    if (!options.post.empty())
+        renderer.settings.useCompute = computeSupported && options.post == "compute";
+    dc::ObjLoader loader(options.model);
+    auto mesh = loader.exportMesh();
+    std::vector<glm::mat4> instances = sceneInstances();
+
+    // without a path one turn of the default camera, closing the loop on the first frame
+    float fps = options.fps;
+    unsigned frames;
+    std::unique_ptr<CameraPath> path;
+    if (options.cameraPath.empty())
+    {
+        frames = options.frames > 0 ? options.frames : static_cast<unsigned>(4.0f * fps);
+        path.reset(new CameraPath(CameraPath::turntable(defaultCamera(), frames / fps)));
+    }
+    else
+    {
+        path.reset(new CameraPath(CameraPath::load(options.cameraPath, defaultCamera().target)));
+        frames = options.frames > 0 ? options.frames : static_cast<unsigned>(path->duration() * fps) + 1;
+    }
+
+    dc::FrameBuffer output(width, height, {
+        { dc::FBAttachmentType::AttachColor, dc::TextureFormat::RGBA8 }
+    });
+
+    typedef std::chrono::high_resolution_clock Clock;
+    auto milliseconds = [](Clock::time_point from, Clock::time_point to) { return std::chrono::duration<double, std::milli>(to - from).count(); };
+
+    // encode time summed over all encoder threads
+    std::mutex encodeMutex;
+    double encodeMs = 0.0;
+    dc::FrameCapture::Sink png = dc::FrameCapture::pngSequence(options.capturePrefix);
+    dc::FrameCapture::Sink sink = [&](dc::CapturedFrame& frame)
+    {
+        auto start = Clock::now();
+        bool written = png(frame);
+        double elapsed = milliseconds(start, Clock::now());
+        std::lock_guard<std::mutex> lock(encodeMutex);
+        encodeMs += elapsed;
+        return written;
+    };
+
+    std::unique_ptr<dc::FrameCapture> capture;
+    if (!options.captureSync)
+        capture.reset(new dc::FrameCapture(width, height, sink, options.captureRing, options.encoders));
+
+    FrameTrace trace({ "total", "render", "capture", "flush" });
+    double syncReadbackMs = 0.0;
+    uint64_t syncFailed = 0;
+    auto start = Clock::now();
+    auto frameStart = start;
+    for (unsigned i = 0; i < frames; ++i)
+    {
+        // fixed timestep, the sequence does not depend on how long a frame takes
+        OrbitCamera view = path->sample(i / fps);
+        renderer.render(*mesh, instances, view.getViewMatrix(), defaultProjection(), &output);
+        auto captureStart = Clock::now();
+        if (capture)
+        {
+            capture->capture(&output);
+        }
+        else
+        {
+            dc::CapturedFrame frame;
+            frame.frame = i;
+            frame.width = width;
+            frame.height = height;
+            frame.rgba.resize(width * height * 4);
+            output.bind();
+            glPixelStorei(GL_PACK_ALIGNMENT, 4);
+            glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, frame.rgba.data());
+            output.unbind();
+            syncReadbackMs += milliseconds(captureStart, Clock::now());
+            if (!sink(frame))
+                ++syncFailed;
+        }
+        // without a swap nothing paces the loop, so a flush per frame stands in for it
+        auto flushStart = Clock::now();
+        glFlush();
+        auto frameEnd = Clock::now();
+        trace.add({ milliseconds(frameStart, frameEnd), milliseconds(frameStart, captureStart), milliseconds(captureStart, flushStart), milliseconds(flushStart, frameEnd) });
+        frameStart = frameEnd;
+    }
+
+    dc::FrameCapture::Stats stats;
+    if (capture)
+    {
+        capture->flush();
+        stats = capture->stats();
+        // the destructor waits for the encoders to write the last frames
+        capture.reset();
+    }
+    glFinish();
+    double elapsed = milliseconds(start, Clock::now());
+
+    // the render thread's share, i.e. its whole frame time minus what the other stages cost it
+    double readbackMs = options.captureSync ? syncReadbackMs : stats.readbackMs;
+    double renderMs = -readbackMs - (options.captureSync ? encodeMs : 0.0);
+    for (size_t i = 0; i < trace.size(); ++i)
+    {
+        renderMs += trace.value(i, 0);
+    }
+    unsigned encoders = options.captureSync ? 1 : options.encoders;
+
+    std::ios::fmtflags flags(std::cout.flags());
+    std::cout << std::fixed << std::setprecision(2) << frames << " frames at " << fps << " fps of camera time, "
+        << (options.captureSync ? "synchronous capture" : "pipelined capture") << ", " << renderer.postName() << " post: "
+        << frames * 1000.0 / elapsed << " frames/s" << std::endl;
+    // a stage sustains this many frames per second on its own, the smallest bounds the pipeline
+    auto stage = [&](const char* name, double totalMs, unsigned threads)
+    {
+        double perFrame = totalMs / frames;
+        std::cout << "  " << std::left << std::setw(9) << name << std::right << std::setw(8) << perFrame << " ms per frame, "
+            << threads << (threads == 1 ? " thread, " : " threads, ") << std::setw(7) << threads * 1000.0 / glm::max(perFrame, 1e-3) << " frames/s max" << std::endl;
+    };
+    stage("render", renderMs, 1);
+    stage("readback", readbackMs, 1);
+    stage("encode", encodeMs, encoders);
+    if (!options.captureSync)
+    {
+        std::cout << "  ring stalls " << stats.ringStalls << " (" << stats.ringStallMs << " ms), waiting for encoders "
+            << stats.encoderWaitMs << " ms" << std::endl;
+    }
+    std::cout.flags(flags);
+    trace.printSummary(std::cout, 1);
+    if (!options.tracePath.empty() && trace.writeCsv(options.tracePath))
+        std::cout << "wrote " << options.tracePath << std::endl;
+    uint64_t failed = options.captureSync ? syncFailed : stats.failed;
+    if (stats.dropped > 0 || failed > 0)
+    {
+        std::cout << stats.dropped << " frames dropped, " << failed << " failed to write" << std::endl;
+        return -1;
+    }
+    return 0;
+}
+
+// The scene through SoftwareRenderer, which needs neither a GPU nor a GL context
+static int runSoftware(const Options& options)
+{
+    dc::ObjLoader loader(options.model);
+    dc::MeshData mesh = loader.exportMeshData();
+    std::vector<glm::mat4> instances = sceneInstances();
+    glm::mat4 view = defaultCamera().getViewMatrix();
+
+    if (options.softwareBenchmark)
+    {
+        SoftwareRenderer::benchmark(std::cout, mesh, instances, view, defaultProjection(), width, height, clearColor);
+        return 0;
+    }
+    if (options.postBenchmark)
+    {
+        // the post process alone, on the g-buffer of one software frame
+        SoftwareRenderer renderer(width, height, clearColor);
+        renderer.render(mesh, instances, view, defaultProjection());
+        CpuStylize::benchmark(std::cout, renderer.gbuffer());
+        return 0;
+    }
+
+    unsigned threads = options.threads > 0 ? options.threads : dc::ThreadPool::hardwareThreads();
+    SoftwareRenderer renderer(width, height, clearColor, threads);
+    unsigned frames = glm::max(options.frames, 1u);
+    for (unsigned i = 0; i < frames; ++i)
+    {
+        renderer.render(mesh, instances, view, defaultProjection());
+    }
+
+    const SoftwareRenderer::Timings& timings = renderer.timings();
+    std::cout << std::fixed << std::setprecision(2) << "software renderer, " << renderer.threads() << " threads, "
+        << renderer.triangleCount() << " triangles drawn: " << timings.total() << " ms (transform " << timings.transform
+        << ", bin " << timings.bin << ", raster " << timings.raster << ", post " << timings.post << ")" << std::endl;
+    if (!dc::writePng(options.softwareOutput, renderer.image().data(), width, height, 4, true))
+        return -1;
+    std::cout << "wrote " << options.softwareOutput << std::endl;
+    return 0;
+}
+
+// Golden image test of the software renderer against the GL path with the fragment post
+// process, which is what SoftwareRenderer ports. Rasterization rules and 8 bit rounding
+// differ in details, so a few percent of edge pixels flipping is expected.
+static int runSoftwareCompare(const Options& options)
+{
+    HeadlessContext context;
+    if (!context.create())
+        return -1;
+    bool computeSupported = dc::loadGL43(context.loader());
+    std::cout << "comparing against " << glGetString(GL_RENDERER) << std::endl;
+
+    dc::ObjLoader loader(options.model);
+    dc::MeshData data = loader.exportMeshData();
+    std::vector<glm::mat4> instances = sceneInstances();
+    glm::mat4 view = defaultCamera().getViewMatrix();
+
+    // classic layout with the fragment post process, the configuration the software renderer implements
+    Renderer renderer(width, height, 1, dc::GBufferLayout::classic(), clearColor, computeSupported);
+    renderer.settings.useCompute = false;
+    dc::Mesh mesh(data);
+    dc::FrameBuffer output(width, height, {
+        { dc::FBAttachmentType::AttachColor, dc::TextureFormat::RGBA8 }
+    });
+    renderer.render(mesh, instances, view, defaultProjection(), &output);
+
+    std::vector<unsigned char> reference(width * height * 4);
+    output.bind();
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, reference.data());
+    output.unbind();
+
+    unsigned threads = options.threads > 0 ? options.threads : dc::ThreadPool::hardwareThreads();
+    SoftwareRenderer software(width, height, clearColor, threads);
+    software.render(data, instances, view, defaultProjection());
+
+    // rasterization rules differ on a few edge pixels, llvmpipe gives 0.01% and 56.5 dB
+    const unsigned tolerance = 8;
+    const double maxDifferingShare = 1e-3;
+    const double minPsnr = 45.0;
+    std::vector<unsigned char> diff;
+    dc::ImageDifference difference = dc::compareImages(reference.data(), software.image().data(), width, height, 4, tolerance, &diff);
+    bool passed = difference.differingShare <= maxDifferingShare && difference.psnr >= minPsnr;
+    std::cout << std::fixed << std::setprecision(2) << "software against GL: ";
+    difference.print(std::cout);
+    std::cout << (passed ? ", passed" : ", FAILED") << std::endl;
+
+    bool written = dc::writePng(options.comparePrefix + "gl.png", reference.data(), width, height, 4, true)
+        && dc::writePng(options.comparePrefix + "cpu.png", software.image().data(), width, height, 4, true)
+        && dc::writePng(options.comparePrefix + "diff.png", diff.data(), width, height, 3, true);
+    if (written)
+        std::cout << "wrote " << options.comparePrefix << "gl.png, cpu.png and diff.png" << std::endl;
+    return passed && written ? 0 : -1;
+}
+
+// classic layout attachments as CpuGBuffer, read back from the bound g-buffer
+static void readGBuffer(const dc::GBuffer& gbuffer, CpuGBuffer& target)
+{
+    unsigned w = gbuffer.width();
+    unsigned h = gbuffer.height();
+    target.resize(w, h);
+    std::vector<uint32_t> rgba(static_cast<size_t>(w) * h);
+    std::vector<float> depth(rgba.size());
+
+    gbuffer.bind();
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    const GLenum attachments[] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1 };
+    std::vector<uint32_t>* planes[] = { &target.color, &target.normal };
+    for (int a = 0; a < 2; ++a)
+    {
+        glReadBuffer(attachments[a]);
+        glReadPixels(0, 0, w, h, GL_RGBA, GL_UNSIGNED_BYTE, rgba.data());
+        for (unsigned y = 0; y < h; ++y)
+        {
+            for (unsigned x = 0; x < w; ++x)
+            {
+                (*planes[a])[target.index(x, y)] = rgba[static_cast<size_t>(y) * w + x] & 0xFFFFFF;
+            }
+        }
+    }
+    glReadPixels(0, 0, w, h, GL_DEPTH_COMPONENT, GL_FLOAT, depth.data());
+    glReadBuffer(GL_COLOR_ATTACHMENT0);
+    gbuffer.unbind();
+
+    for (unsigned y = 0; y < h; ++y)
+    {
+        std::copy_n(&depth[static_cast<size_t>(y) * w], w, &target.depth[target.index(0, y)]);
+    }
+}
+
+// Tolerance test of CpuStylize alone: the GL renders the g-buffer and its fragment post
+// process, every compiled CpuStylize path shades the same g-buffer read back. Both sides
+// see identical inputs, so only float rounding differs, and an edge test sitting exactly
+// on the threshold may flip a few pixels.
+static int runPostCompare(const Options& options)
+{
+    HeadlessContext context;
+    if (!context.create())
+        return -1;
+    bool computeSupported = dc::loadGL43(context.loader());
+    std::cout << "comparing against " << glGetString(GL_RENDERER) << std::endl;
+
+    dc::ObjLoader loader(options.model);
+    Renderer renderer(width, height, 1, dc::GBufferLayout::classic(), clearColor, computeSupported);
+    renderer.settings.useCompute = false;
+    dc::Mesh mesh(loader.exportMeshData());
+    dc::FrameBuffer output(width, height, {
+        { dc::FBAttachmentType::AttachColor, dc::TextureFormat::RGBA8 }
+    });
+    renderer.render(mesh, sceneInstances(), defaultCamera().getViewMatrix(), defaultProjection(), &output);
+
+    std::vector<unsigned char> reference(width * height * 4);
+    output.bind();
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, reference.data());
+    output.unbind();
+
+    CpuGBuffer gbuffer;
+    readGBuffer(renderer.gbuffer(), gbuffer);
+
+    // one step of 8 bit rounding, on at most one pixel in ten thousand
+    const unsigned tolerance = 1;
+    const double maxDifferingShare = 1e-4;
+
+    unsigned threads = options.threads > 0 ? options.threads : dc::ThreadPool::hardwareThreads();
+    dc::ThreadPool pool(threads);
+    bool passed = true;
+    bool written = true;
+    for (CpuStylize::Path path : { CpuStylize::Scalar, CpuStylize::Sse2, CpuStylize::Avx2 })
+    {
+        if (!CpuStylize::supported(path))
+            continue;
+
+        CpuStylize stylize;
+        stylize.path = path;
+        std::vector<unsigned char> image;
+        stylize.run(gbuffer, image, pool);
+
+        std::vector<unsigned char> diff;
+        dc::ImageDifference difference = dc::compareImages(reference.data(), image.data(), width, height, 4, tolerance, &diff);
+        bool pathPassed = difference.differingShare <= maxDifferingShare;
+        passed = passed && pathPassed;
+        std::cout << std::fixed << std::setprecision(4) << "  " << CpuStylize::name(path) << " against GL: ";
+        difference.print(std::cout);
+        std::cout << (pathPassed ? ", passed" : ", FAILED") << std::endl;
+
+        std::string prefix = options.postComparePrefix + CpuStylize::name(path);
+        written = written && dc::writePng(prefix + ".png", image.data(), width, height, 4, true)
+            && dc::writePng(prefix + "_diff.png", diff.data(), width, height, 3, true);
+    }
+    written = written && dc::writePng(options.postComparePrefix + "gl.png", reference.data(), width, height, 4, true);
+    if (written)
+        std::cout << "wrote " << options.postComparePrefix << "gl.png and a .png and _diff.png per path" << std::endl;
+    return passed && written ? 0 : -1;
+}
+
+// Occlusion culling of a synthetic city built from the model's primitives, seen from the
+// central crossing looking down the streets. Every view is culled on the CPU; a few are
+// also rendered by SoftwareRenderer with and without the culled objects, where any
+// differing pixel would be an object culled although visible.
+static int runOcclusion(const Options& options)
+{
+    dc::ObjLoader loader(options.model);
+    CityScene city(loader.exportPrimitives(), options.blocks);
+    std::vector<OcclusionCuller::Object> objects = city.cullObjects();
+    std::vector<unsigned> everything(objects.size());
+    for (size_t i = 0; i < everything.size(); ++i)
+    {
+        everything[i] = static_cast<unsigned>(i);
+    }
+
+    size_t triangles = 0;
+    for (unsigned i : everything)
+    {
+        triangles += city.triangleCount(i);
+    }
+    std::cout << "city of " << options.blocks << "x" << options.blocks << " blocks, " << objects.size() << " objects, "
+        << triangles << " triangles from " << city.primitives().size() << " primitives" << std::endl;
+
+    OcclusionCuller culler;
+    unsigned views = options.frames > 0 ? options.frames : 36;
+    const unsigned checkedViews = 4;
+    std::unique_ptr<SoftwareRenderer> software;
+    OcclusionCuller::Stats sum;
+    size_t submittedTriangles = 0;
+    size_t changedPixels = 0;
+    for (unsigned v = 0; v < views; ++v)
+    {
+        float azimuth = 6.2832f * v / views;
+        glm::vec3 eye(0.0f, 1.7f, 0.0f);
+        glm::vec3 direction(std::cos(azimuth), -0.1f, std::sin(azimuth));
+        glm::mat4 view = glm::lookAt(eye, eye + direction, { 0.0f, 1.0f, 0.0f });
+
+        const std::vector<unsigned>& visible = culler.cull(objects, view, defaultProjection());
+        const OcclusionCuller::Stats& stats = culler.stats();
+        sum.frustumCulled += stats.frustumCulled;
+        sum.occluded += stats.occluded;
+        sum.occluders += stats.occluders;
+        sum.occluderTriangles += stats.occluderTriangles;
+        sum.tested += stats.tested;
+        sum.projectMs += stats.projectMs;
+        sum.rasterMs += stats.rasterMs;
+        sum.testMs += stats.testMs;
+        for (unsigned i : visible)
+        {
+            submittedTriangles += city.triangleCount(i);
+        }
+
+        if (v == 0)
+        {
+            std::vector<unsigned char> depth = culler.depthImage();
+            dc::writePng(options.occlusionPrefix + "occlusion.png", depth.data(), culler.width(), culler.height(), 1, true);
+        }
+        if (v % (views / glm::min(views, checkedViews)) != 0)
+            continue;
+
+        if (!software)
+            software.reset(new SoftwareRenderer(width, height, clearColor));
+        std::vector<glm::mat4> identity = { glm::mat4(1.0f) };
+        software->render(city.merge(everything), identity, view, defaultProjection());
+        std::vector<unsigned char> reference = software->image();
+        software->render(city.merge(visible), identity, view, defaultProjection());
+        dc::ImageDifference difference = dc::compareImages(reference.data(), software->image().data(), width, height, 4);
+        changedPixels += static_cast<size_t>(difference.differingShare * width * height + 0.5);
+        if (v == 0)
+            dc::writePng(options.occlusionPrefix + "culled.png", software->image().data(), width, height, 4, true);
+    }
+
+    double perView = 1.0 / views;
+    std::cout << std::fixed << std::setprecision(1) << views << " views at street level, per view:" << std::endl
+        << "  " << objects.size() - (sum.frustumCulled + sum.occluded) * perView << " objects drawn, "
+        << sum.frustumCulled * perView << " outside the frustum, " << sum.occluded * perView << " occluded ("
+        << 100.0 * sum.occluded / glm::max<size_t>(sum.tested, 1) << "% of the frustum)" << std::endl
+        << "  " << sum.occluders * perView << " occluders, " << sum.occluderTriangles * perView << " triangles rasterized at "
+        << culler.width() << "x" << culler.height() << ", " << submittedTriangles * perView << " of " << triangles << " triangles submitted" << std::endl
+        << std::setprecision(3) << "  project " << sum.projectMs * perView << " ms, rasterize " << sum.rasterMs * perView
+        << " ms, test " << sum.testMs * perView << " ms, " << std::setprecision(1)
+        << sum.tested / glm::max(sum.testMs, 1e-6) / 1000.0 << " M tests/s" << std::endl
+        << "  " << changedPixels << " pixels changed by culling in " << glm::min(views, checkedViews) << " rendered views" << std::endl;
+    std::cout << "wrote " << options.occlusionPrefix << "occlusion.png and " << options.occlusionPrefix << "culled.png" << std::endl;
+    return changedPixels == 0 ? 0 : -1;
+}
+
+// Hi-Z culling of a grid of the model walked through at street level. Every frame the
+// states the cull shader left are checked against a brute force visible set: each
+// instance is drawn again with an occlusion query against the final depth, and any that
+// passes a sample must have been drawn by one of the two passes. The frame is also
+// rendered without culling, which must give the same image.
+static int runHiZCheck(const Options& options)
+{
+    HeadlessContext context;
+    if (!context.create())
+        return -1;
+    if (!dc::loadGL43(context.loader()))
+    {
+        std::cout << "Hi-Z culling needs GL 4.3" << std::endl;
+        return -1;
+    }
+    std::cout << "Hi-Z check on " << glGetString(GL_RENDERER) << std::endl;
+
+    Renderer renderer(width, height, 1, gbufferLayout, clearColor, true);
+    dc::ObjLoader loader(options.model);
+    auto mesh = loader.exportMesh();
+    glm::vec3 size = mesh->boundsMax() - mesh->boundsMin();
+    float pitch = glm::max(size.x, size.z) * 1.1f;
+    std::vector<glm::mat4> instances = gridInstances(*mesh, options.blocks * options.blocks);
+
+    dc::Shader queryShader({ { dc::ShaderStage::Vertex, "vertex.glsl" },{ dc::ShaderStage::Fragment, "fragment.glsl" } }, gbufferLayout.shaderDefines());
+    GLuint query;
+    glGenQueries(1, &query);
+    dc::FrameBuffer output(width, height, { { dc::FBAttachmentType::AttachColor, dc::TextureFormat::RGBA8 } });
+    std::vector<unsigned char> culled(width * height * 4);
+    std::vector<unsigned char> reference(culled.size());
+    auto readOutput = [&](std::vector<unsigned char>& pixels)
+    {
+        output.bind();
+        glPixelStorei(GL_PACK_ALIGNMENT, 4);
+        glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+        output.unbind();
+    };
+
+    unsigned frames = options.frames > 0 ? options.frames : 24;
+    size_t counts[4] = {};
+    size_t falseNegatives = 0;
+    size_t hiddenDrawn = 0;
+    size_t changedPixels = 0;
+    double culledMs = 0.0;
+    double referenceMs = 0.0;
+    for (unsigned f = 0; f < frames; ++f)
+    {
+        // down the street between the first two rows, turning to look across them
+        float t = static_cast<float>(f) / frames;
+        glm::vec3 eye((t - 0.5f) * options.blocks * pitch * 0.5f, 1.7f, (0.5f - options.blocks * 0.5f) * pitch);
+        float yaw = 0.5f * std::sin(6.2832f * t);
+        glm::mat4 view = glm::lookAt(eye, eye + glm::vec3(std::cos(yaw), -0.05f, std::sin(yaw)), { 0.0f, 1.0f, 0.0f });
+
+        renderer.settings.useHiZ = true;
+        auto start = std::chrono::high_resolution_clock::now();
+        renderer.render(*mesh, instances, view, defaultProjection(), &output);
+        glFinish();
+        culledMs += std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+        readOutput(culled);
+        std::vector<HiZCulling::State> states = renderer.hiZ()->readStates();
+
+        // brute force, every instance against the final depth without touching it. Culled ones
+        // count as visible where they would have won the depth test, drawn ones where they did.
+        // Each result is read right away, llvmpipe misreports the odd one of many queries in flight
+        renderer.gbuffer().bind();
+        glViewport(0, 0, width, height);
+        glEnable(GL_DEPTH_TEST);
+        glEnable(GL_CULL_FACE);
+        glDepthMask(GL_FALSE);
+        glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+        queryShader.use();
+        queryShader.setMat4("view", view);
+        queryShader.setMat4("projection", defaultProjection());
+        for (size_t i = 0; i < instances.size(); ++i)
+        {
+            bool drawn = states[i] == HiZCulling::Drawn || states[i] == HiZCulling::DrawnLate;
+            glDepthFunc(drawn ? GL_LEQUAL : GL_LESS);
+            glBeginQuery(GL_SAMPLES_PASSED, query);
+            queryShader.setMat4("model", instances[i]);
+            mesh->draw(queryShader);
+            glEndQuery(GL_SAMPLES_PASSED);
+
+            GLuint samples = 0;
+            glGetQueryObjectuiv(query, GL_QUERY_RESULT, &samples);
+            falseNegatives += samples > 0 && !drawn ? 1 : 0;
+            hiddenDrawn += samples == 0 && drawn ? 1 : 0;
+            ++counts[states[i]];
+        }
+        glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+        glDepthMask(GL_TRUE);
+        glDepthFunc(GL_LESS);
+        glDisable(GL_DEPTH_TEST);
+        glUseProgram(0);
+        renderer.gbuffer().unbind();
+
+        renderer.settings.useHiZ = false;
+        start = std::chrono::high_resolution_clock::now();
+        renderer.render(*mesh, instances, view, defaultProjection(), &output);
+        glFinish();
+        referenceMs += std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+        readOutput(reference);
+        dc::ImageDifference difference = dc::compareImages(reference.data(), culled.data(), width, height, 4);
+        changedPixels += static_cast<size_t>(difference.differingShare * width * height + 0.5);
+    }
+    glDeleteQueries(1, &query);
+
+    double perFrame = 1.0 / frames;
+    std::cout << std::fixed << std::setprecision(1) << instances.size() << " instances, " << frames << " frames, per frame:" << std::endl
+        << "  " << counts[HiZCulling::Drawn] * perFrame << " drawn early, " << counts[HiZCulling::DrawnLate] * perFrame << " drawn late, "
+        << counts[HiZCulling::Occluded] * perFrame << " occluded, " << counts[HiZCulling::Culled] * perFrame << " outside the frustum" << std::endl
+        << "  " << hiddenDrawn * perFrame << " drawn although hidden, " << falseNegatives << " visible instances culled in total" << std::endl
+        << std::setprecision(2) << "  " << culledMs * perFrame << " ms with Hi-Z culling, " << referenceMs * perFrame << " ms without" << std::endl
+        << "  " << changedPixels << " pixels changed by culling" << std::endl;
+    return falseNegatives == 0 && changedPixels == 0 ? 0 : -1;
+}
+
+// Overdraw of the g-buffer pass with and without the depth pre-pass, from views around the
+// scene. Fragments shaded per pixel come from the stencil count, frame times from the wall
+// clock over uncounted frames. Both configurations must produce the same image except
+// where coplanar faces tie in depth: GL_EQUAL keeps the last of them, GL_LESS the first.
+static int runOverdraw(const Options& options)
+{
+    HeadlessContext context;
+    if (!context.create())
+        return -1;
+    bool computeSupported = dc::loadGL43(context.loader());
+    std::cout << "overdraw on " << glGetString(GL_RENDERER) << std::endl;
+
+    Renderer renderer(width, height, fboDownscale, gbufferLayout, clearColor, computeSupported);
+    if (!options.post.empty())
+        renderer.settings.useCompute = computeSupported && options.post == "compute";
+    dc::ObjLoader loader(options.model);
+    auto mesh = loader.exportMesh();
+    std::vector<glm::mat4> instances = sceneInstances();
+    dc::FrameBuffer output(width, height, { { dc::FBAttachmentType::AttachColor, dc::TextureFormat::RGBA8 } });
+    std::vector<unsigned char> images[2] = { std::vector<unsigned char>(width * height * 4), std::vector<unsigned char>(width * height * 4) };
+
+    const unsigned repetitions = 3;
+    unsigned views = options.frames > 0 ? options.frames : 8;
+    Renderer::Overdraw overdraw[2] = {};
+    double milliseconds[2] = {};
+    size_t changedPixels = 0;
+    for (unsigned v = 0; v < views; ++v)
+    {
+        OrbitCamera camera = defaultCamera();
+        camera.azimuth = 6.2832f * v / views;
+        camera.elevation = 1.2f;
+        camera.distance = 12.0f;
+        glm::mat4 view = camera.getViewMatrix();
+
+        for (unsigned prepass = 0; prepass < 2; ++prepass)
+        {
+            renderer.settings.useDepthPrepass = prepass == 1;
+            renderer.settings.countOverdraw = true;
+            renderer.render(*mesh, instances, view, defaultProjection(), &output);
+            Renderer::Overdraw counted = renderer.overdraw();
+            overdraw[prepass].perPixel += counted.perPixel / views;
+            overdraw[prepass].perCoveredPixel += counted.perCoveredPixel / views;
+            overdraw[prepass].coveredShare += counted.coveredShare / views;
+
+            output.bind();
+            glPixelStorei(GL_PACK_ALIGNMENT, 4);
+            glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, images[prepass].data());
+            output.unbind();
+
+            renderer.settings.countOverdraw = false;
+            glFinish();
+            auto start = std::chrono::high_resolution_clock::now();
+            for (unsigned i = 0; i < repetitions; ++i)
+            {
+                renderer.render(*mesh, instances, view, defaultProjection(), &output);
+            }
+            glFinish();
+            milliseconds[prepass] += std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count() / (repetitions * views);
+        }
+        dc::ImageDifference difference = dc::compareImages(images[0].data(), images[1].data(), width, height, 4);
+        changedPixels += static_cast<size_t>(difference.differingShare * width * height + 0.5);
+    }
+
+    std::cout << std::fixed << std::setprecision(2) << views << " views, " << 100.0 * overdraw[0].coveredShare << "% of the pixels covered" << std::endl;
+    const char* names[] = { "direct", "depth pre-pass" };
+    for (unsigned prepass = 0; prepass < 2; ++prepass)
+    {
+        std::cout << "  " << std::left << std::setw(15) << names[prepass] << std::right << overdraw[prepass].perPixel << " fragments shaded per pixel, "
+            << overdraw[prepass].perCoveredPixel << " per covered pixel, " << milliseconds[prepass] << " ms per frame" << std::endl;
+    }
+    const double maxChangedShare = 1e-4;
+    double changedShare = static_cast<double>(changedPixels) / (static_cast<double>(width) * height * views);
+    std::cout << "  " << changedPixels << " pixels changed by the pre-pass (" << std::setprecision(4) << 100.0 * changedShare << "%, at most "
+        << 100.0 * maxChangedShare << "% allowed), it " << (milliseconds[1] < milliseconds[0] ? "pays off" : "does not pay off") << " for this scene" << std::endl;
+    return changedShare <= maxChangedShare ? 0 : -1;
+}
+
+// The window loop without a window: an idle scene is run for a while rendering every
+// iteration, then the way the on-demand loop does, where sleeping stands in for
+// glfwWaitEventsTimeout and glFinish for the swap. The CPU usage of both is only printed,
+// with the sleep standing in for the wait it says nothing about the real loop. The check
+// is the outline width change redrawn by the post process alone, which has to give the
+// image a full frame gives.
+static int runOnDemandCheck(const Options& options)
+{
+    HeadlessContext context;
+    if (!context.create())
+        return -1;
+    bool computeSupported = dc::loadGL43(context.loader());
+    std::cout << "on-demand rendering on " << glGetString(GL_RENDERER) << std::endl;
+
+    Renderer renderer(width, height, fboDownscale, gbufferLayout, clearColor, computeSupported);
+    if (!options.post.empty())
+        renderer.settings.useCompute = computeSupported && options.post == "compute";
+    dc::ObjLoader loader(options.model);
+    auto mesh = loader.exportMesh();
+    std::vector<glm::mat4> instances = sceneInstances();
+    glm::mat4 view = defaultCamera().getViewMatrix();
+    dc::FrameBuffer output(width, height, { { dc::FBAttachmentType::AttachColor, dc::TextureFormat::RGBA8 } });
+
+    double seconds = options.frames > 0 ? options.frames : 2.0;
+    double cpuShare[2] = {};
+    RedrawTracker::Stats stats[2];
+    const char* names[] = { "continuous", "on demand" };
+    for (unsigned onDemand = 0; onDemand < 2; ++onDemand)
+    {
+        RedrawTracker tracker;
+        auto start = std::chrono::steady_clock::now();
+        double startCpu = processCpuSeconds();
+        double elapsed = 0.0;
+        while (elapsed < seconds)
+        {
+            if (!onDemand)
+                tracker.markScene();
+            if (tracker.level() != RedrawTracker::Clean)
+            {
+                renderer.render(*mesh, instances, view, defaultProjection(), &output);
+                glFinish();
+            }
+            tracker.presented();
+            if (onDemand)
+                std::this_thread::sleep_for(std::chrono::milliseconds(500));
+            elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        }
+        cpuShare[onDemand] = (processCpuSeconds() - startCpu) / elapsed;
+        stats[onDemand] = tracker.stats();
+    }
+    for (unsigned onDemand = 0; onDemand < 2; ++onDemand)
+    {
+        std::cout << std::fixed << std::setprecision(1) << "  " << std::left << std::setw(11) << names[onDemand] << std::right
+            << 100.0 * cpuShare[onDemand] << "% CPU idle (simulated), " << stats[onDemand].fullFrames << " frames, " << stats[onDemand].idleWakeups << " idle wakeups" << std::endl;
+    }
+
+    std::vector<unsigned char> images[2] = { std::vector<unsigned char>(width * height * 4), std::vector<unsigned char>(width * height * 4) };
+    double milliseconds[2] = {};
+    const unsigned repetitions = 5;
+    renderer.render(*mesh, instances, view, defaultProjection(), &output);
+    renderer.settings.outlineWidth += 1.0f;
+    for (unsigned postOnly = 0; postOnly < 2; ++postOnly)
+    {
+        glFinish();
+        auto start = std::chrono::high_resolution_clock::now();
+        for (unsigned i = 0; i < repetitions; ++i)
+        {
+            if (postOnly)
+                renderer.renderPost(*mesh, instances, view, defaultProjection(), &output);
+            else
+                renderer.render(*mesh, instances, view, defaultProjection(), &output);
+        }
+        glFinish();
+        milliseconds[postOnly] = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count() / repetitions;
+
+        output.bind();
+        glPixelStorei(GL_PACK_ALIGNMENT, 4);
+        glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, images[postOnly].data());
+        output.unbind();
+    }
+    dc::ImageDifference difference = dc::compareImages(images[0].data(), images[1].data(), width, height, 4);
+    std::cout << std::setprecision(2) << "  outline width change: " << milliseconds[0] << " ms full frame, " << milliseconds[1] << " ms post process only, ";
+    difference.print(std::cout);
+    bool passed = difference.differingShare == 0.0;
+    std::cout << (passed ? ", passed" : ", FAILED") << std::endl;
+    return passed ? 0 : -1;
+}
+
+// A model of the window loop's pacing without a window, see FramePacer. The old loop reads
+// input right after the swap returns, at vsync, which a sleep until the next multiple of
+// the period stands in for, so the input waits a whole frame before it is shown. Latency
+// mode reads it just before the deadline instead. Both render the default scene at the
+// frame cap. There is no real swap, so the numbers estimate the difference and nothing is
+// passed or failed; the window's overlay measures the real thing.
+static int runLatencyEstimate(const Options& options)
+{
+    HeadlessContext context;
+    if (!context.create())
+        return -1;
+    bool computeSupported = dc::loadGL43(context.loader());
+    std::cout << "frame pacing model estimate on " << glGetString(GL_RENDERER) << ", simulated vsync, no swap" << std::endl;
+
+    Renderer renderer(width, height, fboDownscale, gbufferLayout, clearColor, computeSupported);
+    if (!options.post.empty())
+        renderer.settings.useCompute = computeSupported && options.post == "compute";
+    dc::ObjLoader loader(options.model);
+    auto mesh = loader.exportMesh();
+    std::vector<glm::mat4> instances = sceneInstances();
+    glm::mat4 view = defaultCamera().getViewMatrix();
+    dc::FrameBuffer output(width, height, { { dc::FBAttachmentType::AttachColor, dc::TextureFormat::RGBA8 } });
+
+    double seconds = options.frames > 0 ? options.frames : 2.0;
+    double frameCap = options.frameCap > 0.0 ? options.frameCap : 60.0;
+    auto period = std::chrono::duration_cast<FramePacer::Clock::duration>(std::chrono::duration<double>(1.0 / frameCap));
+    FramePacer::Stats stats[2];
+    const char* names[] = { "vsync", "latency mode" };
+    for (unsigned latency = 0; latency < 2; ++latency)
+    {
+        FramePacer pacer;
+        pacer.configure(latency != 0, options.framesInFlight, latency ? frameCap : 0.0);
+        auto start = FramePacer::Clock::now();
+        auto vsync = start;
+        while (FramePacer::Clock::now() - start < std::chrono::duration<double>(seconds))
+        {
+            pacer.waitToLatch();
+            pacer.latched();
+            renderer.render(*mesh, instances, view, defaultProjection(), &output);
+            glFlush();
+            pacer.submitted();
+            pacer.waitToPresent();
+            if (!latency)
+            {
+                // the swap blocks until the next vertical blank
+                auto now = FramePacer::Clock::now();
+                while (vsync <= now)
+                {
+                    vsync += period;
+                }
+                FramePacer::waitUntil(vsync);
+            }
+            pacer.presented();
+        }
+        glFinish();
+        stats[latency] = pacer.stats();
+    }
+
+    std::cout << "  " << std::left << std::setw(14) << "ms" << std::right << std::setw(8) << "frames" << std::setw(10) << "submit" << std::setw(10) << "p99"
+        << std::setw(10) << "present" << std::setw(10) << "p99" << std::setw(10) << "interval" << std::setw(10) << "jitter" << std::endl;
+    for (unsigned latency = 0; latency < 2; ++latency)
+    {
+        const FramePacer::Stats& s = stats[latency];
+        std::cout << std::fixed << std::setprecision(2) << "  " << std::left << std::setw(14) << names[latency] << std::right << std::setw(8) << s.frames
+            << std::setw(10) << s.submitMean << std::setw(10) << s.submitP99 << std::setw(10) << s.presentMean << std::setw(10) << s.presentP99
+            << std::setw(10) << s.intervalMean << std::setw(10) << s.intervalJitter << std::endl;
+    }
+    std::cout << "  estimated input to present " << std::setprecision(2) << stats[1].presentMean - stats[0].presentMean << " ms at "
+        << std::setprecision(0) << frameCap << " fps, " << options.framesInFlight << " frames in flight" << std::endl;
+    return 0;
+}
+
+static int runBatch(const Options& options)
+{
+    HeadlessContext context;
+    if (!context.create())
+        return -1;
+    bool computeSupported = dc::loadGL43(context.loader());
+    std::cout << "batch " << glGetString(GL_RENDERER) << ", GL " << glGetString(GL_VERSION) << std::endl;
+
+    ThumbnailBatch batch(options.thumbnails, gbufferLayout, clearColor, computeSupported);
+    if (!options.post.empty())
+        batch.settings().useCompute = computeSupported && options.post == "compute";
+    try
+    {
+        return batch.run(std::cout) == 0 ? 0 : -1;
+    }
+    catch (const std::exception& e)
+    {
+        std::cout << "batch failed: " << e.what() << std::endl;
+        return -1;
     }
 }
 
-int main()
+int main(int argc, char** argv)
 {
+    Options options;
+    try
+    {
+        if (!parseOptions(argc, argv, options))
+            return -1;
+    }
+    catch (const std::exception& e)
+    {
+        std::cout << e.what() << std::endl;
+        return -1;
+    }
+    if (!options.softwareOutput.empty() || options.softwareBenchmark || options.postBenchmark)
+        return runSoftware(options);
+    if (!options.postComparePrefix.empty())
+        return runPostCompare(options);
+    if (!options.occlusionPrefix.empty())
+        return runOcclusion(options);
+    if (options.hiZCheck)
+        return runHiZCheck(options);
+    if (options.overdraw)
+        return runOverdraw(options);
+    if (options.onDemandCheck)
+        return runOnDemandCheck(options);
+    if (options.latencyEstimate)
+        return runLatencyEstimate(options);
+    if (!options.comparePrefix.empty())
+        return runSoftwareCompare(options);
+    if (options.batch)
+        return runBatch(options);
+    if (options.headlessCapture)
+        return runSequence(options);
+    if (!options.headlessOutput.empty())
+        return runHeadless(options);
+
     glfwInit();
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
     glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
     glfwWindowHint(GLFW_RESIZABLE, GL_FALSE);
 
+    // 4.3 enables the compute post process, 3.3 is all the rest needs
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
     GLFWwindow* window = glfwCreateWindow(width, height, "Mesh Rendering", NULL, NULL);
     if (window == NULL)
+    {
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+        window = glfwCreateWindow(width, height, "Mesh Rendering", NULL, NULL);
+    }
+    if (window == NULL)
     {
         std::cout << "Failed to create GLFW window" << std::endl;
         glfwTerminate();
@@ -102,42 +1335,127 @@ int main()
         std::cout << "Failed to initialize GLAD" << std::endl;
         return -1;
     }
+    bool computeSupported = dc::loadGL43((GLADloadproc)glfwGetProcAddress);
 
     glfwSetMouseButtonCallback(window, mouse_button_callback);
     glfwSetCursorPosCallback(window, cursor_pos_callback);
     glfwSetScrollCallback(window, scroll_callback);
+    glfwSetWindowRefreshCallback(window, refresh_callback);
 
-    camera = new OrbitCamera{ { 0.0f, 0.5f, 0.0f }, 0.0f, 0.5f, 4.0f, false, 0, 0 };
-
-    dc::Shader shader({ { dc::ShaderStage::Vertex, "vertex.glsl" },{ dc::ShaderStage::Fragment, "fragment.glsl" } });
-    dc::Shader quadShader({ { dc::ShaderStage::Vertex, "quad.glsl" },{ dc::ShaderStage::Fragment, "sobel.glsl" } });
-
-    dc::ObjLoader loader("../models/basic_model.obj");
-    auto mesh = loader.exportMesh();
+    camera = new OrbitCamera(defaultCamera());
 
-    GLuint quadVAO;
-    glGenVertexArrays(1, std::addressof(quadVAO));
+    // rebuilt when the overlay changes the downscale, settings are copied in every frame
+    int downscale = static_cast<int>(fboDownscale);
+    auto makeRenderer = [&]()
+    {
+        DC_GPU_RESOURCE_SCOPE("renderer");
+        return std::unique_ptr<Renderer>(new Renderer(width, height, downscale, gbufferLayout, clearColor, computeSupported));
+    };
+    std::unique_ptr<Renderer> renderer = makeRenderer();
+    Renderer::Settings settings = renderer->settings;
+    std::cout << "post process: " << (settings.useCompute ? "compute" : "fragment") << " (toggle with C), "
+        << "tile classification " << (settings.useTiles ? "on" : "off") << " (toggle with T)" << std::endl;
+    std::cout << "outline width " << settings.outlineWidth << " (change with + and -, benchmark with B)" << std::endl;
+    std::cout << "geometry edges " << (settings.useGeometryEdges ? "on" : "off") << " (toggle with G)" << std::endl;
+    if (computeSupported)
+        std::cout << "Hi-Z culling " << (settings.useHiZ ? "on" : "off") << " (toggle with H)" << std::endl;
+    std::cout << "depth pre-pass " << (settings.useDepthPrepass ? "on" : "off") << " (toggle with O), count overdraw with V" << std::endl;
+    std::cout << "record frames with R" << std::endl;
+    std::cout << "profile 120 frames with P, performance overlay with F1" << std::endl;
+    std::cout << "render " << (options.continuous ? "continuously" : "on demand") << " (toggle with D)" << std::endl;
 
-    unsigned int fboWidth = width / fboDownscale;
-    unsigned int fboHeight = height / fboDownscale;
+    PerfOverlay::LoadStats loadStats;
+    auto loadMesh = [&]()
+    {
+        DC_GPU_RESOURCE_SCOPE("model");
+        auto start = std::chrono::high_resolution_clock::now();
+        dc::ObjLoader loader(options.model);
+        auto loaded = loader.exportMesh();
+        // G can turn the geometry edge pass on at any time
+        loaded->setFeatureEdges(loader.exportFeatureEdges());
+        loadStats.model = options.model;
+        loadStats.milliseconds = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+        loadStats.vertices = loaded->vertexCount();
+        loadStats.triangles = loaded->triangleCount();
+        loadStats.groups = loaded->groups().size();
+        return loaded;
+    };
+    auto mesh = loadMesh();
 
-    dc::FrameBuffer fbo(fboWidth, fboHeight, {
-        { dc::FBAttachmentType::AttachColor, dc::TextureFormat::RGB8 },
-        { dc::FBAttachmentType::AttachColor, dc::TextureFormat::RGB8 },
-        { dc::FBAttachmentType::AttachDepth, dc::TextureFormat::Depth24 }
-    });
+    dc::printGBufferReport(std::cout, renderer->gbuffer().width(), renderer->gbuffer().height());
+    std::cout << "using g-buffer layout " << gbufferLayout.name << std::endl;
 
-    glm::mat4 projection = glm::perspectiveFov<float>(glm::radians(60.0f), width, height, 0.1f, 100.0f);
-    //glm::mat4 projection = glm::ortho<float>(-10, 10, -8, 8, 0.1f, 100.0f);
+    std::vector<glm::mat4> instances = sceneInstances();
+    glm::mat4 projection = defaultProjection();
+    double lastTitleUpdate = 0.0;
 
     glViewport(0, 0, width, height);
-    glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
+    glClearColor(clearColor.r, clearColor.g, clearColor.b, 1.0f);
 
     int lastSpace = GLFW_RELEASE;
     int lastS = GLFW_RELEASE;
+    int lastC = GLFW_RELEASE;
+    int lastT = GLFW_RELEASE;
+    int lastPlus = GLFW_RELEASE;
+    int lastMinus = GLFW_RELEASE;
+    int lastB = GLFW_RELEASE;
+    int lastG = GLFW_RELEASE;
+    int lastR = GLFW_RELEASE;
+    int lastH = GLFW_RELEASE;
+    int lastO = GLFW_RELEASE;
+    int lastV = GLFW_RELEASE;
+    int lastD = GLFW_RELEASE;
+    int lastP = GLFW_RELEASE;
+    int lastF1 = GLFW_RELEASE;
+    int lastL = GLFW_RELEASE;
+    PerfOverlay perfOverlay(window);
+    overlay = &perfOverlay;
+    double lastFrameTime = glfwGetTime();
+    // P captures this many frames into profile_<n>.json
+    const unsigned profileFrames = 120;
+    unsigned profileCount = 0;
+    bool profiling = false;
+    DC_PROFILE_THREAD("main");
+    bool onDemand = !options.continuous;
+    RedrawTracker redrawTracker;
+    redraw = &redrawTracker;
+    // CPU usage between title updates, shows what an idle window costs in either mode
+    double lastCpuSeconds = processCpuSeconds();
+    // CPU and wall seconds of the real loop per mode, continuous first, printed at exit
+    double modeCpuSeconds[2] = {};
+    double modeSeconds[2] = {};
+    // submissions of the last rendered frame
+    dc::RenderStats frameStats;
+    // recording with R reads the back buffer through a PBO ring, see FrameCapture
+    std::unique_ptr<dc::FrameCapture> recording;
+    std::string recordPrefix = options.capturePrefix.empty() ? "capture_" : options.capturePrefix;
+    // latency mode paces the loop itself and swaps without vsync, the frame cap defaults to
+    // the monitor's refresh rate
+    double frameCap = options.frameCap;
+    if (frameCap <= 0.0)
+    {
+        GLFWmonitor* monitor = glfwGetPrimaryMonitor();
+        const GLFWvidmode* mode = monitor ? glfwGetVideoMode(monitor) : nullptr;
+        frameCap = mode && mode->refreshRate > 0 ? mode->refreshRate : 60.0;
+    }
+    FramePacer pacer;
+    pacer.configure(options.latency, options.framesInFlight, frameCap);
+    // latency mode paces to its own deadlines and swaps without waiting for vsync, which tears;
+    // adaptive vsync would wait for the blank after the deadline again and add up to a refresh
+    glfwSwapInterval(pacer.latencyMode() ? 0 : 1);
+    std::cout << "latency mode " << (pacer.latencyMode() ? "on" : "off") << " at " << frameCap << " fps, "
+        << pacer.framesInFlight() << " frames in flight, tearing (toggle with L)" << std::endl;
 
     while (!glfwWindowShouldClose(window))
     {
+        if (pacer.latencyMode())
+        {
+            DC_PROFILE_ZONE("latch");
+            // the camera's callbacks run here, as close to the submission as the frame allows
+            pacer.waitToLatch();
+            glfwPollEvents();
+        }
+        pacer.latched();
         double time = glfwGetTime();
 
         if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
@@ -151,74 +1469,243 @@ int main()
         {
             // reload mesh!
             // TODO: find out why this doesn't work with asset forge! it doesn't want to write to the obj file while app is running
-            dc::ObjLoader newLoader("../models/basic_model.obj");
-            mesh = loader.exportMesh();
+            mesh = loadMesh();
+            redrawTracker.markScene();
         }
         if (skey == GLFW_PRESS && lastS == GLFW_RELEASE)
         {
             // reload shader!
-            shader.reload();
-            quadShader.reload();
+            renderer->reloadShaders();
+            redrawTracker.markScene();
+        }
+        int ckey = glfwGetKey(window, GLFW_KEY_C);
+        if (ckey == GLFW_PRESS && lastC == GLFW_RELEASE && computeSupported)
+        {
+            settings.useCompute = !settings.useCompute;
+            redrawTracker.markPost();
+        }
+        int tkey = glfwGetKey(window, GLFW_KEY_T);
+        if (tkey == GLFW_PRESS && lastT == GLFW_RELEASE)
+        {
+            settings.useTiles = !settings.useTiles;
+            redrawTracker.markPost();
+        }
+        int plus = glfwGetKey(window, GLFW_KEY_EQUAL);
+        int minus = glfwGetKey(window, GLFW_KEY_MINUS);
+        if (plus == GLFW_PRESS && lastPlus == GLFW_RELEASE)
+        {
+            settings.outlineWidth = glm::min(settings.outlineWidth + 1.0f, 16.0f);
+            redrawTracker.markPost();
+        }
+        if (minus == GLFW_PRESS && lastMinus == GLFW_RELEASE)
+        {
+            settings.outlineWidth = glm::max(settings.outlineWidth - 1.0f, 1.0f);
+            redrawTracker.markPost();
+        }
+        int bkey = glfwGetKey(window, GLFW_KEY_B);
+        if (bkey == GLFW_PRESS && lastB == GLFW_RELEASE)
+        {
+            renderer->requestBenchmarks();
+            redrawTracker.markPost();
+        }
+        int gkey = glfwGetKey(window, GLFW_KEY_G);
+        if (gkey == GLFW_PRESS && lastG == GLFW_RELEASE)
+        {
+            settings.useGeometryEdges = !settings.useGeometryEdges;
+            redrawTracker.markPost();
         }
         lastSpace = space;
         lastS = skey;
-
-        fbo.bind();
-        glViewport(0, 0, fbo.width(), fbo.height());
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
-        glEnable(GL_CULL_FACE);
-        glEnable(GL_DEPTH_TEST);
-
-        shader.use();
-        shader.setMat4("view", camera->getViewMatrix());
-        shader.setMat4("projection", projection);
-
-        for (int z = -1; z < 2; ++z)
+        lastC = ckey;
+        lastT = tkey;
+        lastPlus = plus;
+        lastMinus = minus;
+        lastB = bkey;
+        int rkey = glfwGetKey(window, GLFW_KEY_R);
+        if (rkey == GLFW_PRESS && lastR == GLFW_RELEASE)
         {
-            for (int x = -1; x < 2; ++x)
+            if (recording)
             {
-                glm::mat4 model = glm::rotate(glm::translate(glm::mat4(1.0f), { 15.0f * x, 0, 15.0f * z }), (x + z)*2.0f, { 0, 1, 0 });
-                shader.setMat4("model", model);
-                mesh->draw(shader);
+                recording->flush();
+                dc::FrameCapture::Stats stats = recording->stats();
+                std::cout << "recorded " << stats.frames << " frames, " << stats.ringStalls << " ring stalls";
+                if (stats.dropped > 0 || stats.failed > 0)
+                    std::cout << ", " << stats.dropped << " dropped, " << stats.failed << " failed to write";
+                std::cout << std::endl;
+                recording.reset();
+            }
+            else
+            {
+                std::cout << "recording to " << recordPrefix << "*.png (stop with R)" << std::endl;
+                DC_GPU_RESOURCE_SCOPE("recording");
+                recording.reset(new dc::FrameCapture(width, height, dc::FrameCapture::pngSequence(recordPrefix)));
             }
         }
+        int hkey = glfwGetKey(window, GLFW_KEY_H);
+        if (hkey == GLFW_PRESS && lastH == GLFW_RELEASE && computeSupported)
+        {
+            settings.useHiZ = !settings.useHiZ;
+            redrawTracker.markScene();
+        }
+        int okey = glfwGetKey(window, GLFW_KEY_O);
+        if (okey == GLFW_PRESS && lastO == GLFW_RELEASE)
+        {
+            settings.useDepthPrepass = !settings.useDepthPrepass;
+            redrawTracker.markScene();
+        }
+        int vkey = glfwGetKey(window, GLFW_KEY_V);
+        if (vkey == GLFW_PRESS && lastV == GLFW_RELEASE)
+        {
+            settings.countOverdraw = !settings.countOverdraw;
+            redrawTracker.markScene();
+        }
+        int dkey = glfwGetKey(window, GLFW_KEY_D);
+        if (dkey == GLFW_PRESS && lastD == GLFW_RELEASE)
+        {
+            onDemand = !onDemand;
+            std::cout << "rendering " << (onDemand ? "on demand" : "continuously") << std::endl;
+        }
+        int pkey = glfwGetKey(window, GLFW_KEY_P);
+        if (pkey == GLFW_PRESS && lastP == GLFW_RELEASE && !profiling)
+        {
+            dc::Profiler::get().capture(profileFrames);
+            profiling = true;
+        }
+        if (profiling && dc::Profiler::get().captured() && !dc::Profiler::get().recording())
+        {
+            // the GPU spans of the last frames are still in flight
+            renderer->gpuTimer().flush();
+            std::string path = "profile_" + std::to_string(profileCount++) + ".json";
+            if (dc::Profiler::get().writeChromeTrace(path))
+                std::cout << "wrote " << profileFrames << " frames to " << path << std::endl;
+            profiling = false;
+        }
+        lastG = gkey;
+        lastR = rkey;
+        lastH = hkey;
+        lastO = okey;
+        lastV = vkey;
+        lastD = dkey;
+        lastP = pkey;
+        int f1key = glfwGetKey(window, GLFW_KEY_F1);
+        if (f1key == GLFW_PRESS && lastF1 == GLFW_RELEASE)
+        {
+            perfOverlay.toggle();
+            redrawTracker.markPost();
+        }
+        lastF1 = f1key;
+        int lkey = glfwGetKey(window, GLFW_KEY_L);
+        if (lkey == GLFW_PRESS && lastL == GLFW_RELEASE)
+        {
+            pacer.configure(!pacer.latencyMode(), pacer.framesInFlight(), pacer.frameCap());
+            glfwSwapInterval(pacer.latencyMode() ? 0 : 1);
+            pacer.reset();
+            std::cout << "latency mode " << (pacer.latencyMode() ? "on" : "off") << std::endl;
+        }
+        lastL = lkey;
 
-        glUseProgram(0);
-        fbo.unbind();
-
-        glViewport(0, 0, width, height);
-        glClear(GL_COLOR_BUFFER_BIT);
-        glDisable(GL_DEPTH_TEST);
-
-        quadShader.use();
-        glActiveTexture(GL_TEXTURE0);
-        fbo.texture(0)->bind();
-        quadShader.setInt("colorTexture", 0);
-
-        glActiveTexture(GL_TEXTURE1);
-        fbo.texture(1)->bind();
-        quadShader.setInt("normalTexture", 1);
-
-        glActiveTexture(GL_TEXTURE2);
-        fbo.texture(2)->bind();
-        quadShader.setInt("depthTexture", 2);
-
-        glBindVertexArray(quadVAO);
-        glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
-        glBindVertexArray(0);
+        if (time - lastTitleUpdate > 0.5)
+        {
+            std::ostringstream title;
+            title << std::fixed << std::setprecision(2) << "Mesh Rendering - g-buffer " << renderer->gbufferMilliseconds()
+                << " ms, " << renderer->postName() << " post " << renderer->postMilliseconds() << " ms";
+            if (settings.useGeometryEdges)
+            {
+                title << ", " << renderer->geometryLineCount() << " lines";
+            }
+            else if (settings.useTiles)
+            {
+                // stalls on the last frame, but only twice a second
+                title << ", " << std::setprecision(1) << 100.0 * renderer->skippedTileShare() << "% tiles skipped";
+            }
+            if (settings.countOverdraw)
+            {
+                // stalls like the tile share
+                title << ", " << std::setprecision(2) << renderer->overdraw().perCoveredPixel << " fragments per covered pixel";
+            }
+            title << ", " << frameStats.drawCalls << " draws, " << frameStats.uniforms << " uniforms";
+            double cpuSeconds = processCpuSeconds();
+            title << ", " << std::setprecision(0) << 100.0 * (cpuSeconds - lastCpuSeconds) / (time - lastTitleUpdate) << "% CPU";
+            glfwSetWindowTitle(window, title.str().c_str());
+            modeCpuSeconds[onDemand] += cpuSeconds - lastCpuSeconds;
+            modeSeconds[onDemand] += time - lastTitleUpdate;
+            lastTitleUpdate = time;
+            lastCpuSeconds = cpuSeconds;
+        }
 
-        glBindTexture(GL_TEXTURE_2D, 0);
-        glUseProgram(0);
+        // a recording, a profile, the overlay's graphs or latency mode's pacing need every frame
+        if (!onDemand || recording || profiling || perfOverlay.visible() || pacer.latencyMode())
+            redrawTracker.markScene();
+        RedrawTracker::Level level = redrawTracker.level();
+        renderer->settings = settings;
+        double submitStart = glfwGetTime();
+        if (level == RedrawTracker::Full)
+            renderer->render(*mesh, instances, camera->getViewMatrix(), projection);
+        else if (level == RedrawTracker::Post)
+            renderer->renderPost(*mesh, instances, camera->getViewMatrix(), projection);
+        if (level != RedrawTracker::Clean)
+        {
+            double submitEnd = glfwGetTime();
+            perfOverlay.addFrame((submitEnd - submitStart) * 1000.0, (submitEnd - lastFrameTime) * 1000.0);
+            lastFrameTime = submitEnd;
+            bool rebuild = perfOverlay.draw(*renderer, settings, downscale, frameStats, loadStats, pacer);
+            if (recording)
+            {
+                recording->capture(nullptr);
+            }
+            pacer.submitted();
+            DC_PROFILE_ZONE("swap");
+            pacer.waitToPresent();
+            glfwSwapBuffers(window);
+            pacer.presented();
+            frameStats = dc::endRenderStatsFrame();
+            if (rebuild)
+            {
+                renderer = makeRenderer();
+                redrawTracker.markScene();
+            }
+        }
+        redrawTracker.presented();
 
-        glfwPollEvents();
-        glfwSwapBuffers(window);
+        if (!pacer.latencyMode())
+        {
+            DC_PROFILE_ZONE("events");
+            // blocks until input arrives, waking twice a second for the title
+            if (onDemand && !recording && !profiling)
+                glfwWaitEventsTimeout(0.5);
+            else
+                glfwPollEvents();
+        }
+        // not the macro, P has to end its capture in builds without zones too
+        dc::Profiler::get().frame();
     }
 
-    glDeleteVertexArrays(1, std::addressof(quadVAO));
+    const RedrawTracker::Stats& redrawStats = redrawTracker.stats();
+    std::cout << redrawStats.fullFrames << " frames rendered, " << redrawStats.postFrames << " post process only, "
+        << redrawStats.idleWakeups << " idle wakeups" << std::endl;
+    const char* modeNames[] = { "continuously", "on demand" };
+    for (unsigned mode = 0; mode < 2; ++mode)
+    {
+        if (modeSeconds[mode] > 0.0)
+            std::cout << std::fixed << std::setprecision(1) << modeNames[mode] << " " << 100.0 * modeCpuSeconds[mode] / modeSeconds[mode]
+                << "% CPU over " << modeSeconds[mode] << " s" << std::endl;
+    }
+    FramePacer::Stats latency = pacer.stats();
+    std::cout << std::fixed << std::setprecision(2) << "input to submit " << latency.submitMean << " ms, to present " << latency.presentMean
+        << " ms (p99 " << latency.presentP99 << "), frame interval " << latency.intervalMean << " ms, jitter " << latency.intervalJitter << " ms" << std::endl;
+    if (dc::AllocationTracker::get().installed())
+        dc::AllocationTracker::get().report(std::cout);
+    redraw = nullptr;
+    overlay = nullptr;
 
+    recording.reset();
     delete camera;
 
+    // everything that owns a GL object is gone, ImGui's own are not tracked
+    renderer.reset();
+    mesh.reset();
+    dc::GpuResources::get().reportLeaks(std::cout);
+
     glfwTerminate();
     return 0;
 }
\ No newline at end of file
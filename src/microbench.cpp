@@ -0,0 +1,398 @@
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// allocations are always counted here, see measure
+#define DC_ALLOCATION_TRACKER_IMPLEMENTATION
+#include <dc/AllocationTracker.hpp>
+#include <dc/Mesh.hpp>
+#include <dc/ObjLoader.hpp>
+#include <dc/PngWriter.hpp>
+#include <dc/Texture.hpp>
+
+#include "HeadlessContext.hpp"
+
+// Microbenchmarks of the loading pipeline on generated inputs, in the manner of Google
+// Benchmark: every case repeats its body in batches, doubling them until one takes the
+// minimum time, and reports the last batch per iteration with its throughput and the heap
+// allocations it made. Only Mesh upload needs a GL context, the rest runs anywhere.
+
+struct MicroOptions
+{
+    // vertices of the generated models, each rounded to a square grid
+    std::vector<unsigned> sizes = { 1000, 10000, 100000 };
+    // edge of the generated textures in pixels
+    std::vector<unsigned> imageSizes = { 256, 1024, 2048 };
+    // cases whose name contains it, empty runs all
+    std::string filter;
+    double minSeconds = 0.5;
+    std::string csvPath;
+};
+
+struct MicroCase
+{
+    std::string name;
+    // processed per iteration, for MB/s and items/s, zero leaves the column empty
+    double bytes;
+    double items;
+    std::string itemName;
+    std::function<void()> body;
+    bool needsGL;
+};
+
+struct MicroResult
+{
+    std::string name;
+    uint64_t iterations = 0;
+    double nanoseconds = 0.0;
+    double megabytesPerSecond = 0.0;
+    double itemsPerSecond = 0.0;
+    std::string itemName;
+    double allocations = 0.0;
+    double allocatedBytes = 0.0;
+};
+
+static MicroResult measure(const MicroCase& microCase, double minSeconds)
+{
+    // once for warm caches, and so lazily built state is not counted
+    microCase.body();
+
+    MicroResult result;
+    result.name = microCase.name;
+    result.itemName = microCase.itemName;
+    uint64_t iterations = 1;
+    while (true)
+    {
+        // every allocation of the process goes through dc::AllocationTracker, read around the batch
+        dc::AllocationCounts before = dc::AllocationTracker::get().total();
+        auto start = std::chrono::high_resolution_clock::now();
+        for (uint64_t i = 0; i < iterations; ++i)
+        {
+            microCase.body();
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+        if (seconds >= minSeconds || iterations >= (1u << 30))
+        {
+            result.iterations = iterations;
+            result.nanoseconds = seconds * 1.0e9 / iterations;
+            result.megabytesPerSecond = microCase.bytes * iterations / seconds / (1024.0 * 1024.0);
+            result.itemsPerSecond = microCase.items * iterations / seconds;
+            dc::AllocationCounts after = dc::AllocationTracker::get().total();
+            result.allocations = static_cast<double>(after.allocations - before.allocations) / iterations;
+            result.allocatedBytes = static_cast<double>(after.bytes - before.bytes) / iterations;
+            return result;
+        }
+        // aim a little past the minimum, but never more than ten times the batch
+        double perIteration = seconds / iterations;
+        uint64_t next = perIteration > 0.0 ? static_cast<uint64_t>(minSeconds * 1.2 / perIteration) : iterations * 10;
+        iterations = std::min(std::max(next, iterations * 2), iterations * 10);
+    }
+}
+
+static std::vector<unsigned> parseList(const std::string& list)
+{
+    std::vector<unsigned> values;
+    std::istringstream iss(list);
+    std::string item;
+    while (std::getline(iss, item, ','))
+    {
+        if (!item.empty())
+            values.push_back(glm::max(std::stoi(item), 1));
+    }
+    return values;
+}
+
+static bool parseOptions(int argc, char** argv, MicroOptions& options)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--sizes" && hasValue)
+        {
+            options.sizes = parseList(argv[++i]);
+        }
+        else if (arg == "--image-sizes" && hasValue)
+        {
+            options.imageSizes = parseList(argv[++i]);
+        }
+        else if (arg == "--filter" && hasValue)
+        {
+            options.filter = argv[++i];
+        }
+        else if (arg == "--min-time" && hasValue)
+        {
+            options.minSeconds = glm::max(std::stod(argv[++i]), 0.001);
+        }
+        else if (arg == "--csv" && hasValue)
+        {
+            options.csvPath = argv[++i];
+        }
+        else
+        {
+            std::cout << "usage: " << argv[0] << " [--sizes 1000,10000,100000] [--image-sizes 256,1024,2048] [--filter name] [--min-time seconds] [--csv results.csv]" << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+// A rolling height field of side x side vertices with a texcoord and a normal each, split
+// into four usemtl bands like the primitives of an Asset Forge export. Besides the whole
+// model, every line type is written to a file of its own for the per type cases.
+struct GeneratedModel
+{
+    unsigned side;
+    std::string obj;
+    std::string mtl;
+    std::string positions;
+    std::string texCoords;
+    std::string normals;
+    std::string faces;
+    // the part after "f " of every face line
+    std::vector<std::string> faceValues;
+
+    explicit GeneratedModel(unsigned vertices)
+        : side(glm::max(static_cast<unsigned>(std::sqrt(static_cast<double>(vertices)) + 0.5), 2u))
+    {
+        std::ostringstream v, vt, vn, f, m;
+        v << std::fixed << std::setprecision(6);
+        vt << std::fixed << std::setprecision(6);
+        vn << std::fixed << std::setprecision(6);
+        for (unsigned z = 0; z < side; ++z)
+        {
+            for (unsigned x = 0; x < side; ++x)
+            {
+                float height = 0.5f * std::sin(x * 0.3f) * std::cos(z * 0.2f);
+                glm::vec3 normal = glm::normalize(glm::vec3(-0.15f * std::cos(x * 0.3f) * std::cos(z * 0.2f), 1.0f, 0.1f * std::sin(x * 0.3f) * std::sin(z * 0.2f)));
+                v << "v " << x * 0.5f << " " << height << " " << z * 0.5f << "\n";
+                vt << "vt " << static_cast<float>(x) / (side - 1) << " " << static_cast<float>(z) / (side - 1) << "\n";
+                vn << "vn " << normal.x << " " << normal.y << " " << normal.z << "\n";
+            }
+        }
+        for (unsigned band = 0; band < 4; ++band)
+        {
+            m << "newmtl band" << band << "\nKa 0.000000 0.000000 0.000000\nKd " << 0.25f * (band + 1) << " 0.5 0.5\nKs 0.330000 0.330000 0.330000\n\n";
+            f << "usemtl band" << band << "\n";
+            for (unsigned z = band * (side - 1) / 4; z < (band + 1) * (side - 1) / 4; ++z)
+            {
+                for (unsigned x = 0; x + 1 < side; ++x)
+                {
+                    unsigned a = z * side + x + 1;
+                    unsigned b = a + 1;
+                    unsigned c = a + side;
+                    unsigned d = c + 1;
+                    for (const auto& it : { glm::uvec3(a, c, b), glm::uvec3(b, c, d) })
+                    {
+                        std::ostringstream face;
+                        face << it.x << "/" << it.x << "/" << it.x << " " << it.y << "/" << it.y << "/" << it.y << " " << it.z << "/" << it.z << "/" << it.z;
+                        faceValues.push_back(face.str());
+                        f << "f " << faceValues.back() << "\n";
+                    }
+                }
+            }
+        }
+        positions = v.str();
+        texCoords = vt.str();
+        normals = vn.str();
+        faces = f.str();
+        mtl = m.str();
+        obj = "mtllib " + fileName("mtl") + "\n" + positions + texCoords + normals + faces;
+    }
+
+    unsigned vertices() const { return side * side; }
+
+    // next to the working directory, the mtllib line names it relative to the obj
+    std::string fileName(const std::string& kind) const
+    {
+        return "microbench_" + std::to_string(vertices()) + "_" + kind + (kind == "mtl" ? ".mtl" : ".obj");
+    }
+};
+
+static std::string writeFile(const std::string& path, const std::string& contents, std::vector<std::string>& written)
+{
+    std::ofstream file(path, std::ios::binary);
+    file << contents;
+    if (!file)
+        throw std::runtime_error("failed to write " + path);
+    written.push_back(path);
+    return path;
+}
+
+int main(int argc, char** argv)
+{
+    MicroOptions options;
+    try
+    {
+        if (!parseOptions(argc, argv, options))
+            return -1;
+    }
+    catch (const std::exception& e)
+    {
+        std::cout << e.what() << std::endl;
+        return -1;
+    }
+
+    std::vector<std::string> written;
+    std::vector<MicroCase> cases;
+    // kept alive for the cases, which refer to them
+    std::vector<std::unique_ptr<GeneratedModel>> models;
+    std::vector<std::unique_ptr<dc::ObjLoader>> loaders;
+    std::vector<std::unique_ptr<dc::MeshData>> meshData;
+    try
+    {
+        for (unsigned size : options.sizes)
+        {
+            models.emplace_back(new GeneratedModel(size));
+            const GeneratedModel& model = *models.back();
+            std::string suffix = "/" + std::to_string(model.vertices());
+            double vertices = model.vertices();
+            double faces = static_cast<double>(model.faceValues.size());
+
+            writeFile(model.fileName("mtl"), model.mtl, written);
+            std::string objPath = writeFile(model.fileName("obj"), model.obj, written);
+            std::string vPath = writeFile(model.fileName("v"), model.positions, written);
+            std::string vtPath = writeFile(model.fileName("vt"), model.texCoords, written);
+            std::string vnPath = writeFile(model.fileName("vn"), model.normals, written);
+            std::string fPath = writeFile(model.fileName("f"), model.faces, written);
+
+            cases.push_back({ "ObjLoader v" + suffix, static_cast<double>(model.positions.size()), vertices, "lines", [vPath]() { dc::ObjLoader loader(vPath); }, false });
+            cases.push_back({ "ObjLoader vt" + suffix, static_cast<double>(model.texCoords.size()), vertices, "lines", [vtPath]() { dc::ObjLoader loader(vtPath); }, false });
+            cases.push_back({ "ObjLoader vn" + suffix, static_cast<double>(model.normals.size()), vertices, "lines", [vnPath]() { dc::ObjLoader loader(vnPath); }, false });
+            cases.push_back({ "ObjLoader f" + suffix, static_cast<double>(model.faces.size()), faces, "lines", [fPath]() { dc::ObjLoader loader(fPath); }, false });
+            cases.push_back({ "ObjLoader obj" + suffix, static_cast<double>(model.obj.size()), vertices, "vertices", [objPath]() { dc::ObjLoader loader(objPath); }, false });
+            const std::vector<std::string>* faceValues = &model.faceValues;
+            cases.push_back({ "parse_face" + suffix, 0.0, faces, "faces", [faceValues]()
+            {
+                for (const auto& it : *faceValues)
+                {
+                    dc::parse_face(it);
+                }
+            }, false });
+
+            // MTL parsing alone, through an obj with nothing but the mtllib line
+            unsigned materials = glm::max(model.vertices() / 10, 1u);
+            std::ostringstream mtl;
+            for (unsigned i = 0; i < materials; ++i)
+            {
+                mtl << "newmtl material" << i << "\nKa 0.000000 0.000000 0.000000\nKd 0.5 0.5 0.5\nKs 0.330000 0.330000 0.330000\nmap_Kd texture" << i << ".png\n\n";
+            }
+            std::string mtlName = "microbench_" + std::to_string(materials) + "_materials.mtl";
+            writeFile(mtlName, mtl.str(), written);
+            std::string mtlObjPath = writeFile("microbench_" + std::to_string(materials) + "_materials.obj", "mtllib " + mtlName + "\n", written);
+            cases.push_back({ "MTL/" + std::to_string(materials), static_cast<double>(mtl.str().size()), static_cast<double>(materials), "materials",
+                [mtlObjPath]() { dc::ObjLoader loader(mtlObjPath); }, false });
+
+            // vertex dedup and groups of the parsed model, and the feature edges on their own
+            loaders.emplace_back(new dc::ObjLoader(objPath));
+            const dc::ObjLoader* loader = loaders.back().get();
+            cases.push_back({ "exportMeshData" + suffix, 0.0, faces * 3.0, "vertices", [loader]() { loader->exportMeshData(); }, false });
+            cases.push_back({ "exportFeatureEdges" + suffix, 0.0, faces, "triangles", [loader]() { loader->exportFeatureEdges(); }, false });
+
+            // a Mesh built from the exported arrays, which copies them and uploads both buffers
+            meshData.emplace_back(new dc::MeshData(loader->exportMeshData()));
+            dc::MeshData* data = meshData.back().get();
+            double uploadBytes = static_cast<double>(sizeof(dc::VertexData) * data->vertices.size() + sizeof(unsigned) * data->indices.size());
+            cases.push_back({ "Mesh upload" + suffix, uploadBytes, static_cast<double>(data->vertices.size()), "vertices", [data]()
+            {
+                dc::Mesh mesh(data->vertices, data->indices, data->groups);
+                glFinish();
+            }, true });
+        }
+
+        // noise over gradients, so the PNG filters and deflate have some work to do
+        for (unsigned size : options.imageSizes)
+        {
+            std::vector<unsigned char> pixels(size * size * 3);
+            uint32_t random = 1;
+            for (unsigned i = 0; i < size * size; ++i)
+            {
+                random = random * 1664525u + 1013904223u;
+                unsigned x = i % size;
+                unsigned y = i / size;
+                pixels[i * 3] = static_cast<unsigned char>(x * 255 / size);
+                pixels[i * 3 + 1] = static_cast<unsigned char>(y * 255 / size);
+                pixels[i * 3 + 2] = static_cast<unsigned char>(random >> 28);
+            }
+            std::vector<unsigned char> png = dc::encodePng(pixels.data(), size, size, 3);
+            std::string path = writeFile("microbench_" + std::to_string(size) + ".png", std::string(png.begin(), png.end()), written);
+            // what dc::Texture does before the upload
+            cases.push_back({ "stbi_load/" + std::to_string(size), static_cast<double>(png.size()), static_cast<double>(size) * size, "pixels", [path]()
+            {
+                int width, height, channels;
+                unsigned char* decoded = stbi_load(path.c_str(), &width, &height, &channels, 0);
+                if (!decoded)
+                    throw std::runtime_error("failed to decode " + path);
+                stbi_image_free(decoded);
+            }, false });
+        }
+    }
+    catch (const std::exception& e)
+    {
+        std::cout << e.what() << std::endl;
+        return -1;
+    }
+
+    std::unique_ptr<HeadlessContext> context;
+    bool glMissing = false;
+    std::cout << std::left << std::setw(24) << "case" << std::right << std::setw(12) << "iterations" << std::setw(14) << "ns/iter" << std::setw(10) << "MB/s"
+        << std::setw(14) << "items/s" << std::setw(12) << "allocs/iter" << std::setw(14) << "bytes/iter" << std::endl;
+    std::vector<MicroResult> results;
+    for (const auto& it : cases)
+    {
+        if (!options.filter.empty() && it.name.find(options.filter) == std::string::npos)
+            continue;
+        if (it.needsGL && !context && !glMissing)
+        {
+            context.reset(new HeadlessContext());
+            glMissing = !context->create();
+            if (glMissing)
+                std::cout << "no GL context, skipping the upload cases" << std::endl;
+        }
+        if (it.needsGL && glMissing)
+            continue;
+        MicroResult result = measure(it, options.minSeconds);
+        std::cout << std::left << std::setw(24) << result.name << std::right << std::setw(12) << result.iterations << std::fixed << std::setprecision(0)
+            << std::setw(14) << result.nanoseconds << std::setprecision(1) << std::setw(10) << result.megabytesPerSecond << std::setprecision(0)
+            << std::setw(14) << result.itemsPerSecond << std::setprecision(1) << std::setw(12) << result.allocations << std::setprecision(0)
+            << std::setw(14) << result.allocatedBytes << " " << result.itemName << std::endl;
+        results.push_back(result);
+    }
+
+    for (const auto& it : written)
+    {
+        std::remove(it.c_str());
+    }
+
+    if (!options.csvPath.empty())
+    {
+        std::ofstream file(options.csvPath);
+        file << "case,iterations,ns_per_iteration,mb_per_second,items_per_second,item,allocations_per_iteration,bytes_per_iteration\n";
+        for (const auto& it : results)
+        {
+            file << it.name << "," << it.iterations << "," << it.nanoseconds << "," << it.megabytesPerSecond << "," << it.itemsPerSecond << ","
+                << it.itemName << "," << it.allocations << "," << it.allocatedBytes << "\n";
+        }
+        if (!file)
+        {
+            std::cout << "failed to write " << options.csvPath << std::endl;
+            return -1;
+        }
+        std::cout << "wrote " << options.csvPath << std::endl;
+    }
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,39 @@
+#version 330 core
+
+// Reference for jump_flood.glsl: brute force search for the nearest seed within radius,
+// (2 * radius + 1)^2 fetches per pixel.
+
+uniform usampler2D seedTexture;
+uniform int radius;
+
+out uvec2 nearestSeed;
+
+const uint NoSeed = 0xFFFFu;
+
+void main()
+{
+    ivec2 size = textureSize(seedTexture, 0);
+    ivec2 pixel = ivec2(gl_FragCoord.xy);
+
+    uvec2 best = uvec2(NoSeed);
+    int bestDist = 0x7FFFFFFF;
+    for (int y = -radius; y <= radius; ++y)
+    {
+        for (int x = -radius; x <= radius; ++x)
+        {
+            ivec2 tap = pixel + ivec2(x, y);
+            if (any(lessThan(tap, ivec2(0))) || any(greaterThanEqual(tap, size)))
+                continue;
+
+            uvec2 candidate = texelFetch(seedTexture, tap, 0).rg;
+            int dist = x * x + y * y;
+            if (candidate.x != NoSeed && dist < bestDist)
+            {
+                bestDist = dist;
+                best = candidate;
+            }
+        }
+    }
+
+    nearestSeed = best;
+}
\ No newline at end of file
@@ -2,84 +2,85 @@
 
 in vec2 uv;
 
+#ifdef EDGE_SEEDS
+// jump flood seeds, the pixel's own coordinate where an edge was detected
+out uvec2 seed;
+#else
 out vec4 fragment;
+#endif
 
-uniform sampler2D colorTexture;
-uniform sampler2D normalTexture;
-uniform sampler2D depthTexture;
-uniform vec3 lightDirection = vec3(-1, -1, 1);
-uniform float zNear = 0.1;
-uniform float zFar = 100.0;
+#include "stylize.glsl"
 
-uniform float fogStart = 90.0;
-uniform float fogEnd = 100.0;
+const uint NoSeed = 0xFFFFu;
 
-// depthSample from depthTexture.r, for instance
-float linearDepth()
-{
-    float depthSample = texture(depthTexture, uv).r;
-    depthSample = 2.0 * depthSample - 1.0;
-    float zLinear = 2.0 * zNear * zFar / (zFar + zNear - depthSample * (zFar - zNear));
-    return zLinear;
-}
+#ifdef OUTLINE_DISTANCE
+// nearest edge pixel of every pixel, written by jump_flood.glsl
+uniform usampler2D outlineSeeds;
+uniform float outlineWidth = 1.0;
 
-float transformColor(vec3 color)
+// coverage of a stroke outlineWidth pixels wide around the detected edges,
+// width 1 reproduces the plain edge detection
+float outlineEdge()
 {
-    vec3 conv = vec3(0.2126, 0.7152, 0.0722);
-    return dot(color, conv);
+    ivec2 size = textureSize(outlineSeeds, 0);
+    ivec2 pixel = min(ivec2(uv * size), size - 1);
+    uvec2 nearest = texelFetch(outlineSeeds, pixel, 0).rg;
+    if (nearest.x == NoSeed)
+        return 0.0;
+    float dist = length(vec2(nearest) - vec2(pixel));
+    return clamp(outlineWidth * 0.5 + 0.5 - dist, 0.0, 1.0);
 }
+#endif
+
+#ifdef EDGE_MASK
+// feature lines rasterized by line_fragment.glsl, replaces the image space edge detection
+uniform sampler2D edgeMask;
+#endif
+
+#ifdef TILE_MASK
+// written by tile_mask.glsl, edge detection is skipped on tiles marked 0
+uniform sampler2D tileMask;
+#endif
 
-float getSample(sampler2D sampler, vec2 offset)
+float detectColorEdge(vec2 uvStep)
 {
-    vec2 uvStep = vec2(1.0) / textureSize(sampler, 0);
-    return transformColor(texture2D(sampler, uv + uvStep * offset).rgb);
+    float s[9];
+    for (int i = 0; i < 9; ++i)
+        s[i] = transformColor(sampleColor(uv + uvStep * sobelOffsets[i]));
+    return sobel(s);
 }
 
-float detectEdge(sampler2D sampler)
+float detectNormalEdge(vec2 uvStep)
 {
-    float ul = getSample(sampler, vec2(-1, 1));
-    float u = getSample(sampler, vec2(0, 1));
-    float ur = getSample(sampler, vec2(1, 1));
-
-    float dl = getSample(sampler, vec2(-1, -1));
-    float d = getSample(sampler, vec2(0, -1));
-    float dr = getSample(sampler, vec2(1, -1));
-    
-    float l = getSample(sampler, vec2(-1, 0));
-    float m = getSample(sampler, vec2(0, 0));
-    float r = getSample(sampler, vec2(1, 0));
-
-    float gx = ul + 2.0 * l + dl - ur - 2.0 * r - dr;
-    float gy = ul + 2.0 * u + ur - dl - 2.0 * d - dr;
-
-    return sqrt(gx * gx + gy * gy);
+    float s[9];
+    for (int i = 0; i < 9; ++i)
+        s[i] = transformColor(sampleNormal(uv + uvStep * sobelOffsets[i]));
+    return sobel(s);
 }
 
 void main()
 {
-    vec3 N = normalize(texture2D(normalTexture, uv).rgb * 2.0 - 1.0);
-
-    float colorEdge = detectEdge(colorTexture);
-    float normalEdge = detectEdge(normalTexture);
-    float edge = step(0.05, (colorEdge + normalEdge) * 2.0);
-
-    vec3 leftBot = vec3(1, 0.9, 0.4);
-    vec3 rightTop = vec3(0.9, 0.7, 1);
-    float luv = length(uv);
-    vec3 mixColor = mix(leftBot, rightTop, luv * luv);
-    vec3 faceColor = mix(vec3(1.0), mixColor, abs(dot(N, vec3(0, 1, 0))));
-
-    vec3 edgeColor = vec3(0.2, 0, 0.1);
-
-    vec3 L = -normalize(lightDirection);
-    float diffuse = max(0, dot(N, L));
-    float shadow = 0.7 + diffuse * 0.3;
-
-    float depth = linearDepth();
-    vec3 fogColor = mixColor * 0.2;
-
-    vec3 finalColor = mix(faceColor, edgeColor, edge) * shadow;
-
-    fragment = vec4(mix(finalColor, fogColor, smoothstep(fogStart, fogEnd, depth)), 1);
-    //fragment = vec4(vec3(getSample(depthTexture, vec2(0))), 1);
+#ifdef OUTLINE_DISTANCE
+    float edge = outlineEdge();
+#elif defined(EDGE_MASK)
+    float edge = texture(edgeMask, uv).r;
+#else
+    vec2 uvStep = vec2(1.0) / textureSize(normalTexture, 0);
+#ifdef TILE_MASK
+    ivec2 tile = ivec2(uv * textureSize(normalTexture, 0)) / TILE_SIZE;
+    bool edgeTile = texelFetch(tileMask, tile, 0).r > 0.5;
+#else
+    bool edgeTile = true;
+#endif
+
+    float edge = 0.0;
+    if (edgeTile)
+        edge = edgeFromGradients(detectColorEdge(uvStep), detectNormalEdge(uvStep));
+#endif
+
+#ifdef EDGE_SEEDS
+    seed = edge > 0.5 ? uvec2(gl_FragCoord.xy) : uvec2(NoSeed);
+#else
+    fragment = vec4(stylize(uv, edge), 1);
+#endif
 }
\ No newline at end of file
@@ -0,0 +1,70 @@
+#version 430 core
+
+// Compute implementation of sobel.glsl. Every work group loads its tile plus a one pixel
+// apron into shared memory once, so each g-buffer texel is fetched and converted to
+// luminance once instead of nine times.
+
+#ifndef TILE_SIZE
+#define TILE_SIZE 16
+#endif
+#define APRON_SIZE (TILE_SIZE + 2)
+
+layout (local_size_x = TILE_SIZE, local_size_y = TILE_SIZE) in;
+
+layout (rgba8) writeonly uniform image2D outputImage;
+
+#ifdef TILE_LIST
+// written by tile_classify.glsl, one work group is dispatched per listed tile
+layout (std430, binding = 0) readonly buffer TileList
+{
+    uint numGroups[3];
+    uint tiles[];
+};
+#endif
+
+#include "stylize.glsl"
+
+shared float colorLuma[APRON_SIZE][APRON_SIZE];
+shared float normalLuma[APRON_SIZE][APRON_SIZE];
+
+void main()
+{
+    ivec2 size = textureSize(normalTexture, 0);
+    vec2 uvStep = vec2(1.0) / vec2(size);
+#ifdef TILE_LIST
+    uint packedTile = tiles[gl_WorkGroupID.x];
+    ivec2 tile = ivec2(packedTile & 0xFFFFu, packedTile >> 16);
+#else
+    ivec2 tile = ivec2(gl_WorkGroupID.xy);
+#endif
+    ivec2 tileOrigin = tile * TILE_SIZE - 1;
+
+    // sample through the sampler like the fragment path does, so borders behave the same
+    for (uint i = gl_LocalInvocationIndex; i < APRON_SIZE * APRON_SIZE; i += TILE_SIZE * TILE_SIZE)
+    {
+        ivec2 local = ivec2(i % APRON_SIZE, i / APRON_SIZE);
+        vec2 texCoord = (vec2(tileOrigin + local) + 0.5) * uvStep;
+        colorLuma[local.y][local.x] = transformColor(sampleColor(texCoord));
+        normalLuma[local.y][local.x] = transformColor(sampleNormal(texCoord));
+    }
+
+    barrier();
+
+    ivec2 pixel = tile * TILE_SIZE + ivec2(gl_LocalInvocationID.xy);
+    if (pixel.x >= size.x || pixel.y >= size.y)
+        return;
+
+    ivec2 center = ivec2(gl_LocalInvocationID.xy) + 1;
+    float colorSamples[9];
+    float normalSamples[9];
+    for (int i = 0; i < 9; ++i)
+    {
+        ivec2 tap = center + ivec2(sobelOffsets[i]);
+        colorSamples[i] = colorLuma[tap.y][tap.x];
+        normalSamples[i] = normalLuma[tap.y][tap.x];
+    }
+    float edge = edgeFromGradients(sobel(colorSamples), sobel(normalSamples));
+
+    vec2 uv = (vec2(pixel) + 0.5) * uvStep;
+    imageStore(outputImage, pixel, vec4(stylize(uv, edge), 1));
+}
\ No newline at end of file
@@ -0,0 +1,117 @@
+// shared by the fragment and compute implementations of the stylization post process
+
+#ifndef MAX_MATERIALS
+#define MAX_MATERIALS 64
+#endif
+
+#ifdef MATERIAL_ID
+uniform usampler2D colorTexture;
+uniform vec3 materialColors[MAX_MATERIALS];
+#else
+uniform sampler2D colorTexture;
+#endif
+uniform sampler2D normalTexture;
+uniform sampler2D depthTexture;
+uniform vec3 lightDirection = vec3(-1, -1, 1);
+uniform float zNear = 0.1;
+uniform float zFar = 100.0;
+
+uniform float fogStart = 90.0;
+uniform float fogEnd = 100.0;
+
+uniform float edgeThreshold = 0.05;
+
+const vec2 sobelOffsets[9] = vec2[]
+(
+    vec2(-1,  1), vec2(0,  1), vec2(1,  1),
+    vec2(-1,  0), vec2(0,  0), vec2(1,  0),
+    vec2(-1, -1), vec2(0, -1), vec2(1, -1)
+);
+
+// depthSample from depthTexture.r, for instance
+float linearDepth(vec2 texCoord)
+{
+    float depthSample = texture(depthTexture, texCoord).r;
+    depthSample = 2.0 * depthSample - 1.0;
+    float zLinear = 2.0 * zNear * zFar / (zFar + zNear - depthSample * (zFar - zNear));
+    return zLinear;
+}
+
+float transformColor(vec3 color)
+{
+    vec3 conv = vec3(0.2126, 0.7152, 0.0722);
+    return dot(color, conv);
+}
+
+vec3 octDecode(vec2 e)
+{
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    float t = clamp(-n.z, 0.0, 1.0);
+    n.xy += vec2(n.x >= 0.0 ? -t : t, n.y >= 0.0 ? -t : t);
+    return normalize(n);
+}
+
+vec3 sampleColor(vec2 texCoord)
+{
+#ifdef MATERIAL_ID
+    // Mesh::draw clamps the ids already, this keeps a bad texel from indexing past the palette
+    return materialColors[min(texture(colorTexture, texCoord).r, uint(MAX_MATERIALS - 1))];
+#else
+    return texture(colorTexture, texCoord).rgb;
+#endif
+}
+
+// normal as N * 0.5 + 0.5, independent of how the g-buffer stores it
+vec3 sampleNormal(vec2 texCoord)
+{
+#ifdef NORMAL_OCTAHEDRAL
+    return octDecode(texture(normalTexture, texCoord).rg * 2.0 - 1.0) * 0.5 + 0.5;
+#else
+    return texture(normalTexture, texCoord).rgb;
+#endif
+}
+
+float sobel(float s[9])
+{
+    float gx = s[0] + 2.0 * s[3] + s[6] - s[2] - 2.0 * s[5] - s[8];
+    float gy = s[0] + 2.0 * s[1] + s[2] - s[6] - 2.0 * s[7] - s[8];
+
+    return sqrt(gx * gx + gy * gy);
+}
+
+float edgeFromGradients(float colorEdge, float normalEdge)
+{
+    return step(edgeThreshold, (colorEdge + normalEdge) * 2.0);
+}
+
+// upper bound of what edgeFromGradients compares against edgeThreshold, given the colour
+// and normal luminance ranges around a pixel: a 3x3 Sobel over values spanning r has
+// |gx|, |gy| <= 4r, so its magnitude is at most 4 * sqrt(2) * r
+float maxSobelEdge(vec2 lumaRange)
+{
+    return (lumaRange.x + lumaRange.y) * 4.0 * sqrt(2.0) * 2.0;
+}
+
+vec3 stylize(vec2 texCoord, float edge)
+{
+    vec3 N = normalize(sampleNormal(texCoord) * 2.0 - 1.0);
+
+    vec3 leftBot = vec3(1, 0.9, 0.4);
+    vec3 rightTop = vec3(0.9, 0.7, 1);
+    float luv = length(texCoord);
+    vec3 mixColor = mix(leftBot, rightTop, luv * luv);
+    vec3 faceColor = mix(vec3(1.0), mixColor, abs(dot(N, vec3(0, 1, 0))));
+
+    vec3 edgeColor = vec3(0.2, 0, 0.1);
+
+    vec3 L = -normalize(lightDirection);
+    float diffuse = max(0, dot(N, L));
+    float shadow = 0.7 + diffuse * 0.3;
+
+    float depth = linearDepth(texCoord);
+    vec3 fogColor = mixColor * 0.2;
+
+    vec3 finalColor = mix(faceColor, edgeColor, edge) * shadow;
+
+    return mix(finalColor, fogColor, smoothstep(fogStart, fogEnd, depth));
+}
\ No newline at end of file
@@ -0,0 +1,77 @@
+#version 430 core
+
+// First stage of the tiled post process. Every work group measures the colour and normal
+// luminance range of its tile plus apron. Tiles whose range is too small for the Sobel
+// kernel to ever reach edgeThreshold are shaded right here without edge detection, all
+// others are appended to the tile list that sobel_compute.glsl is dispatched over.
+
+#ifndef TILE_SIZE
+#define TILE_SIZE 16
+#endif
+#define APRON_SIZE (TILE_SIZE + 2)
+#define GROUP_SIZE (TILE_SIZE * TILE_SIZE)
+
+layout (local_size_x = TILE_SIZE, local_size_y = TILE_SIZE) in;
+
+layout (rgba8) writeonly uniform image2D outputImage;
+
+layout (std430, binding = 0) buffer TileList
+{
+    uint numGroups[3];
+    uint tiles[];
+};
+
+#include "stylize.glsl"
+
+shared vec2 minLuma[GROUP_SIZE];
+shared vec2 maxLuma[GROUP_SIZE];
+
+void main()
+{
+    ivec2 size = textureSize(normalTexture, 0);
+    vec2 uvStep = vec2(1.0) / vec2(size);
+    ivec2 tile = ivec2(gl_WorkGroupID.xy);
+    ivec2 tileOrigin = tile * TILE_SIZE - 1;
+    uint index = gl_LocalInvocationIndex;
+
+    vec2 lo = vec2(1.0e9);
+    vec2 hi = vec2(-1.0e9);
+    for (uint i = index; i < APRON_SIZE * APRON_SIZE; i += GROUP_SIZE)
+    {
+        ivec2 local = ivec2(i % APRON_SIZE, i / APRON_SIZE);
+        vec2 texCoord = (vec2(tileOrigin + local) + 0.5) * uvStep;
+        vec2 luma = vec2(transformColor(sampleColor(texCoord)), transformColor(sampleNormal(texCoord)));
+        lo = min(lo, luma);
+        hi = max(hi, luma);
+    }
+    minLuma[index] = lo;
+    maxLuma[index] = hi;
+    barrier();
+
+    for (uint stride = GROUP_SIZE / 2; stride > 0; stride >>= 1)
+    {
+        if (index < stride)
+        {
+            minLuma[index] = min(minLuma[index], minLuma[index + stride]);
+            maxLuma[index] = max(maxLuma[index], maxLuma[index + stride]);
+        }
+        barrier();
+    }
+
+    if (maxSobelEdge(maxLuma[0] - minLuma[0]) >= edgeThreshold * 0.99)
+    {
+        if (index == 0)
+        {
+            uint slot = atomicAdd(numGroups[0], 1u);
+            tiles[slot] = uint(tile.x) | (uint(tile.y) << 16);
+        }
+        return;
+    }
+
+    ivec2 pixel = tile * TILE_SIZE + ivec2(gl_LocalInvocationID.xy);
+    if (pixel.x >= size.x || pixel.y >= size.y)
+        return;
+
+    vec2 uv = (vec2(pixel) + 0.5) * uvStep;
+    imageStore(outputImage, pixel, vec4(stylize(uv, 0.0), 1));
+}
\ No newline at end of file
@@ -0,0 +1,34 @@
+#version 330 core
+
+// Fragment counterpart of tile_classify.glsl, rendered at one fragment per tile. Writes 1
+// where the tile plus apron spans enough luminance for the Sobel kernel to find an edge.
+
+#ifndef TILE_SIZE
+#define TILE_SIZE 16
+#endif
+#define APRON_SIZE (TILE_SIZE + 2)
+
+out float tileMask;
+
+#include "stylize.glsl"
+
+void main()
+{
+    vec2 uvStep = vec2(1.0) / textureSize(normalTexture, 0);
+    ivec2 tileOrigin = ivec2(gl_FragCoord.xy) * TILE_SIZE - 1;
+
+    vec2 lo = vec2(1.0e9);
+    vec2 hi = vec2(-1.0e9);
+    for (int y = 0; y < APRON_SIZE; ++y)
+    {
+        for (int x = 0; x < APRON_SIZE; ++x)
+        {
+            vec2 texCoord = (vec2(tileOrigin + ivec2(x, y)) + 0.5) * uvStep;
+            vec2 luma = vec2(transformColor(sampleColor(texCoord)), transformColor(sampleNormal(texCoord)));
+            lo = min(lo, luma);
+            hi = max(hi, luma);
+        }
+    }
+
+    tileMask = maxSobelEdge(hi - lo) >= edgeThreshold * 0.99 ? 1.0 : 0.0;
+}
\ No newline at end of file
@@ -5,13 +5,33 @@ layout (location = 1) in vec3 vNormal;
 layout (location = 2) in vec2 vTexcoord;
 
 out vec3 normal;
+// the depth pre-pass and the g-buffer pass after it compare depths with GL_EQUAL
+invariant gl_Position;
 
 uniform mat4 projection = mat4(1.0);
 uniform mat4 view = mat4(1.0);
 uniform mat4 model = mat4(1.0);
 
+#ifdef GPU_INSTANCES
+// written by hiz_cull.glsl: ids of the visible instances, and the matrices of all of them
+// as four texels each, both through buffer textures to stay within GLSL 3.30
+uniform usamplerBuffer visibleIds;
+uniform samplerBuffer instanceModels;
+uniform int visibleOffset;
+
+mat4 instanceModel()
+{
+    int id = int(texelFetch(visibleIds, visibleOffset + gl_InstanceID).r) * 4;
+    return mat4(texelFetch(instanceModels, id), texelFetch(instanceModels, id + 1), texelFetch(instanceModels, id + 2), texelFetch(instanceModels, id + 3));
+}
+#endif
+
 void main()
 {
     normal = vNormal;
+#ifdef GPU_INSTANCES
+    gl_Position = projection * view * instanceModel() * vec4(vPosition, 1);
+#else
     gl_Position = projection * view * model * vec4(vPosition, 1);
+#endif
 }
\ No newline at end of file